@@ -0,0 +1,172 @@
+#include <getopt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "jazzlights/audio_analyzer.h"
+#include "jazzlights/util/log.h"
+
+// Replays a WAV file through AudioAnalyzer and prints the resulting VisualizerData for every frame as CSV, followed by
+// how long the analysis took. This lets us tune and regression-test the audio pipeline without a microphone or board.
+//
+// Usage: jazzlights-audio-replay [-q] [-r repetitions] [-f fft_size] [-o hop_size] [-m] file.wav
+//
+// -f and -o select the analysis window and how many new samples each frame consumes, and -m switches to mel-spaced
+// bands. The defaults match AudioAnalyzer::kDefaultConfig.
+
+namespace jazzlights {
+namespace {
+
+uint32_t ReadLittleEndian(const uint8_t* data, size_t length) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < length; i++) { value |= static_cast<uint32_t>(data[i]) << (8 * i); }
+  return value;
+}
+
+// Reads a 16-bit PCM WAV file and returns its first channel resampled to AudioAnalyzer::kSampleRate.
+bool ReadWavFile(const char* path, std::vector<int16_t>* samples) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    jll_error("Failed to open %s", path);
+    return false;
+  }
+  std::vector<uint8_t> contents;
+  uint8_t buffer[4096];
+  size_t readLength;
+  while ((readLength = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    contents.insert(contents.end(), buffer, buffer + readLength);
+  }
+  fclose(file);
+  if (contents.size() < 12 || memcmp(contents.data(), "RIFF", 4) != 0 || memcmp(contents.data() + 8, "WAVE", 4) != 0) {
+    jll_error("%s is not a WAV file", path);
+    return false;
+  }
+  uint32_t numChannels = 0;
+  uint32_t sampleRate = 0;
+  const uint8_t* data = nullptr;
+  size_t dataLength = 0;
+  size_t offset = 12;
+  while (offset + 8 <= contents.size()) {
+    const uint8_t* chunk = contents.data() + offset;
+    const size_t chunkLength = std::min<size_t>(ReadLittleEndian(chunk + 4, 4), contents.size() - offset - 8);
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunkLength >= 16) {
+      const uint32_t format = ReadLittleEndian(chunk + 8, 2);
+      numChannels = ReadLittleEndian(chunk + 10, 2);
+      sampleRate = ReadLittleEndian(chunk + 12, 4);
+      const uint32_t bitsPerSample = ReadLittleEndian(chunk + 22, 2);
+      if (format != 1 || bitsPerSample != 16 || numChannels == 0 || sampleRate == 0) {
+        jll_error("%s is not 16-bit PCM (format %u, %u bits, %u channels, %u Hz)", path, format, bitsPerSample,
+                  numChannels, sampleRate);
+        return false;
+      }
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      data = chunk + 8;
+      dataLength = chunkLength;
+    }
+    // Chunks are padded to an even length.
+    offset += 8 + chunkLength + (chunkLength & 1);
+  }
+  if (numChannels == 0 || data == nullptr) {
+    jll_error("%s is missing its fmt or data chunk", path);
+    return false;
+  }
+  const size_t numInputFrames = dataLength / (2 * numChannels);
+  auto inputSample = [&](size_t frame) -> int16_t {
+    return static_cast<int16_t>(ReadLittleEndian(data + frame * 2 * numChannels, 2));
+  };
+  // Linear interpolation is plenty for analysis purposes.
+  const double step = static_cast<double>(sampleRate) / AudioAnalyzer::kSampleRate;
+  samples->clear();
+  for (double position = 0; position + 1 < numInputFrames; position += step) {
+    const size_t index = static_cast<size_t>(position);
+    const double frac = position - index;
+    samples->push_back(static_cast<int16_t>(inputSample(index) * (1 - frac) + inputSample(index + 1) * frac));
+  }
+  jll_info("Read %zu frames of %u channels at %u Hz from %s", numInputFrames, numChannels, sampleRate, path);
+  return true;
+}
+
+int runMain(int argc, char** argv) {
+  bool quiet = false;
+  int repetitions = 1;
+  AudioAnalyzer::Config config = AudioAnalyzer::kDefaultConfig;
+  bool hopSizeSet = false;
+  while (true) {
+    int ch = getopt(argc, argv, "qr:f:o:m");
+    if (ch == -1) { break; }
+    if (ch == 'q') { quiet = true; }
+    if (ch == 'r') { repetitions = strtol(optarg, nullptr, 10); }
+    if (ch == 'f') { config.fft_size = strtol(optarg, nullptr, 10); }
+    if (ch == 'o') {
+      config.hop_size = strtol(optarg, nullptr, 10);
+      hopSizeSet = true;
+    }
+    if (ch == 'm') { config.band_spacing = AudioAnalyzer::BandSpacing::kMel; }
+  }
+  // Without an explicit hop, windows do not overlap.
+  if (!hopSizeSet) { config.hop_size = config.fft_size; }
+  const bool validConfig = config.fft_size >= AudioAnalyzer::kMinFFTSize &&
+                           config.fft_size <= AudioAnalyzer::kMaxFFTSize &&
+                           (config.fft_size & (config.fft_size - 1)) == 0 &&
+                           config.hop_size >= AudioAnalyzer::kMinHopSize && config.hop_size <= config.fft_size;
+  if (optind >= argc || repetitions < 1 || !validConfig) {
+    fprintf(stderr, "Usage: %s [-q] [-r repetitions] [-f fft_size] [-o hop_size] [-m] file.wav\n", argv[0]);
+    return 1;
+  }
+  std::vector<int16_t> samples;
+  if (!ReadWavFile(argv[optind], &samples)) { return 1; }
+  const size_t numFrames = samples.size() / config.hop_size;
+  if (numFrames == 0) {
+    jll_error("%s is too short", argv[optind]);
+    return 1;
+  }
+
+  if (!quiet) {
+    printf("time,volume,agc_min,agc_max,beat,squelch");
+    for (int i = 0; i < AudioAnalyzer::kNumBands; i++) { printf(",band%d", i); }
+    printf("\n");
+  }
+  using Clock = std::chrono::steady_clock;
+  Clock::duration totalDuration = Clock::duration::zero();
+  Clock::duration maxDuration = Clock::duration::zero();
+  size_t numBeats = 0;
+  Milliseconds frameDuration = 0;
+  for (int repetition = 0; repetition < repetitions; repetition++) {
+    // Use a fresh analyzer for each repetition so they all produce the same output.
+    AudioAnalyzer analyzer(config);
+    frameDuration = analyzer.FrameDuration();
+    for (size_t frame = 0; frame < numFrames; frame++) {
+      const Milliseconds currentTime = frame * frameDuration;
+      const Clock::time_point start = Clock::now();
+      analyzer.ProcessSamples(&samples[frame * config.hop_size], /*numChannels=*/1, currentTime);
+      const Clock::duration duration = Clock::now() - start;
+      totalDuration += duration;
+      if (duration > maxDuration) { maxDuration = duration; }
+      if (repetition > 0) { continue; }
+      AudioAnalyzer::VisualizerData data;
+      analyzer.GetVisualizerData(&data);
+      if (data.beat) { numBeats++; }
+      if (quiet) { continue; }
+      printf("%d,%.3f,%.2f,%.2f,%d,%d", currentTime, data.volume, data.agc_min, data.agc_max, data.beat ? 1 : 0,
+             data.squelch ? 1 : 0);
+      for (int i = 0; i < AudioAnalyzer::kNumBands; i++) { printf(",%.2f", data.bands[i]); }
+      printf("\n");
+    }
+  }
+  const double totalMicros = std::chrono::duration<double, std::micro>(totalDuration).count();
+  const double maxMicros = std::chrono::duration<double, std::micro>(maxDuration).count();
+  const double averageMicros = totalMicros / (numFrames * repetitions);
+  jll_info("Analyzed %zu frames x %d with %d-sample FFT: %zu beats, average %.2fus max %.2fus per %dms frame "
+           "(%.0fx realtime)",
+           numFrames, repetitions, config.fft_size, numBeats, averageMicros, maxMicros, frameDuration,
+           frameDuration * 1000.0 / averageMicros);
+  return 0;
+}
+
+}  // namespace
+}  // namespace jazzlights
+
+int main(int argc, char** argv) { return jazzlights::runMain(argc, argv); }
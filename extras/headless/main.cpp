@@ -0,0 +1,109 @@
+#include <getopt.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "jazzlights/frame_sink.h"
+#include "jazzlights/layout/matrix.h"
+#include "jazzlights/player.h"
+#include "jazzlights/software_renderer.h"
+#include "jazzlights/util/log.h"
+
+namespace jazzlights {
+
+int runMain(int argc, char** argv) {
+  bool shouldSetPattern = false;
+  PatternBits pattern = 0;
+  size_t matrixWidth = 400;
+  size_t matrixHeight = 300;
+  size_t imageWidth = 0;
+  size_t imageHeight = 0;
+  size_t ledRadius = 0;
+  uint32_t framesPerSecond = 30;
+  uint64_t numFrames = 300;
+  bool realTime = false;
+  const char* formatName = nullptr;
+  const char* outputPath = nullptr;
+  while (true) {
+    int ch = getopt(argc, argv, "p:m:s:r:f:n:tF:o:");
+    if (ch == -1) { break; }
+    if (ch == 'p') {
+      shouldSetPattern = true;
+      pattern = strtoll(optarg, nullptr, 16);
+    }
+    if (ch == 'm' && sscanf(optarg, "%zux%zu", &matrixWidth, &matrixHeight) != 2) { return 1; }
+    if (ch == 's' && sscanf(optarg, "%zux%zu", &imageWidth, &imageHeight) != 2) { return 1; }
+    if (ch == 'r') { ledRadius = strtoul(optarg, nullptr, 10); }
+    if (ch == 'f') { framesPerSecond = strtoul(optarg, nullptr, 10); }
+    if (ch == 'n') { numFrames = strtoull(optarg, nullptr, 10); }
+    if (ch == 't') { realTime = true; }
+    if (ch == 'F') { formatName = optarg; }
+    if (ch == 'o') { outputPath = optarg; }
+    if (ch == '?') { return 1; }
+  }
+  if (framesPerSecond == 0) { return 1; }
+  if (imageWidth == 0 || imageHeight == 0) {
+    imageWidth = matrixWidth * (2 * ledRadius + 1);
+    imageHeight = matrixHeight * (2 * ledRadius + 1);
+  }
+
+  Matrix layout(matrixWidth, matrixHeight);
+  SoftwareRenderer renderer(layout, imageWidth, imageHeight, ledRadius);
+
+  // Logs go to stdout, so frames can only be written to files, FIFOs or shared memory.
+  std::unique_ptr<FrameSink> sink;
+  FILE* outputFile = nullptr;
+  if (formatName != nullptr && strcmp(formatName, "shm") == 0) {
+    sink = SharedMemoryFrameSink::Create(outputPath != nullptr ? outputPath : "/jazzlights", imageWidth, imageHeight);
+    if (!sink) { return 1; }
+  } else if (outputPath != nullptr) {
+    FrameFormat format = FrameFormat::kY4m;
+    if (formatName != nullptr && !ParseFrameFormat(formatName, &format)) {
+      jll_error("Unknown frame format %s", formatName);
+      return 1;
+    }
+    outputFile = fopen(outputPath, "wb");
+    if (outputFile == nullptr) {
+      jll_error("Failed to open %s", outputPath);
+      return 1;
+    }
+    sink = std::make_unique<FileFrameSink>(outputFile, format, imageWidth, imageHeight, framesPerSecond);
+  }
+
+  Player player;
+  player.addStrand(layout, renderer);
+  player.begin();
+  // Unless running in real time, frames are rendered as fast as possible at evenly spaced times, which makes the
+  // output identical from one run to the next when a pattern is set.
+  const Milliseconds startTime = timeMillis();
+  if (shouldSetPattern) {
+    player.loopOne(startTime);
+    player.setPattern(pattern, startTime);
+  }
+  const Milliseconds benchmarkStartTime = timeMillis();
+  uint64_t numRendered = 0;
+  for (uint64_t frameIndex = 0; numRendered < numFrames; frameIndex++) {
+    const Milliseconds frameTime =
+        realTime ? timeMillis() : startTime + static_cast<Milliseconds>(frameIndex * 1000 / framesPerSecond);
+    // The player skips frames that come less than 10ms after the previous one.
+    if (!player.render(frameTime)) { continue; }
+    numRendered++;
+    if (sink && !sink->WriteFrame(renderer.pixels())) {
+      jll_error("Failed to write frame %llu", static_cast<unsigned long long>(numRendered));
+      return 1;
+    }
+  }
+  const Milliseconds duration = timeMillis() - benchmarkStartTime;
+  const double fps = duration > 0 ? numRendered * 1000.0 / duration : 0.0;
+  jll_info("Rendered %llu %zux%zu frames of %zu LEDs in %ums, %.1f FPS", static_cast<unsigned long long>(numRendered),
+           imageWidth, imageHeight, layout.pixelCount(), duration, fps);
+  sink.reset();
+  if (outputFile != nullptr) { fclose(outputFile); }
+  return 0;
+}
+
+}  // namespace jazzlights
+
+int main(int argc, char** argv) { return jazzlights::runMain(argc, argv); }
@@ -0,0 +1,113 @@
+#include <getopt.h>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "jazzlights/effect/effect.h"
+#include "jazzlights/layout/layout_file.h"
+#include "jazzlights/layout/matrix.h"
+#include "jazzlights/layout/pixelmap.h"
+#include "jazzlights/pattern_cache.h"
+#include "jazzlights/player.h"
+#include "jazzlights/util/log.h"
+
+namespace jazzlights {
+
+// Stores the colors of one strand into its part of a buffer covering all strands.
+class CaptureRenderer : public Renderer {
+ public:
+  CaptureRenderer(std::vector<CRGB>* colors, size_t offset) : colors_(colors), offset_(offset) {}
+  void renderPixel(size_t index, CRGB color) override { (*colors_)[offset_ + index] = color; }
+
+ private:
+  std::vector<CRGB>* colors_;
+  size_t offset_;
+};
+
+int runMain(int argc, char** argv) {
+  size_t matrixWidth = 0;
+  size_t matrixHeight = 0;
+  std::vector<std::vector<Point>> layoutFiles;
+  uint16_t framesPerSecond = 100;
+  Milliseconds duration = kEffectDuration;
+  uint16_t keyframeInterval = 32;
+  const char* outputPath = nullptr;
+  while (true) {
+    int ch = getopt(argc, argv, "m:l:f:d:k:o:");
+    if (ch == -1) { break; }
+    if (ch == 'm' && sscanf(optarg, "%zux%zu", &matrixWidth, &matrixHeight) != 2) { return 1; }
+    if (ch == 'l') {
+      layoutFiles.emplace_back();
+      if (!ReadLayoutFile(optarg, &layoutFiles.back())) { return 1; }
+    }
+    if (ch == 'f') { framesPerSecond = strtoul(optarg, nullptr, 10); }
+    if (ch == 'd') { duration = strtol(optarg, nullptr, 10); }
+    if (ch == 'k') { keyframeInterval = strtoul(optarg, nullptr, 10); }
+    if (ch == 'o') { outputPath = optarg; }
+    if (ch == '?') { return 1; }
+  }
+  // The player does not render frames closer than 10ms apart, and restarts the pattern time every kEffectDuration.
+  if (outputPath == nullptr || optind >= argc || framesPerSecond == 0 || framesPerSecond > 100 || duration < 0 ||
+      duration > kEffectDuration) {
+    fprintf(stderr, "Usage: %s [-m WxH | -l layout.csv...] [-f fps] [-d ms] [-k interval] -o out.bin pattern...\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<Layout>> layouts;
+  for (const std::vector<Point>& points : layoutFiles) {
+    layouts.push_back(std::make_unique<PixelMap>(points.size(), points.data()));
+  }
+  if (matrixWidth > 0 && matrixHeight > 0) { layouts.push_back(std::make_unique<Matrix>(matrixWidth, matrixHeight)); }
+  if (layouts.empty()) { layouts.push_back(std::make_unique<Matrix>(20, 10)); }
+  std::vector<const Layout*> layoutPointers;
+  size_t numLeds = 0;
+  for (const std::unique_ptr<Layout>& layout : layouts) {
+    layoutPointers.push_back(layout.get());
+    numLeds += layout->pixelCount();
+  }
+
+  PatternCacheWriter writer(numLeds, PatternCacheLayoutFingerprint(layoutPointers), framesPerSecond,
+                            keyframeInterval);
+  std::vector<CRGB> colors(numLeds);
+  const uint32_t numFrames = static_cast<uint32_t>(duration * framesPerSecond / 1000 + 1);
+  for (int i = optind; i < argc; i++) {
+    const PatternBits pattern = strtoull(argv[i], nullptr, 16);
+    // Use a fresh player for each pattern so it starts from the same state that devices start it from.
+    std::vector<std::unique_ptr<CaptureRenderer>> renderers;
+    Player player;
+    size_t offset = 0;
+    for (const std::unique_ptr<Layout>& layout : layouts) {
+      renderers.push_back(std::make_unique<CaptureRenderer>(&colors, offset));
+      player.addStrand(*layout, *renderers.back());
+      offset += layout->pixelCount();
+    }
+    player.begin();
+    constexpr Milliseconds kStartTime = 1;
+    player.loopOne(kStartTime);
+    player.setPattern(pattern, kStartTime);
+    writer.BeginPattern(pattern);
+    for (uint32_t frame = 0; frame < numFrames; frame++) {
+      // Render each frame at the first time that plays it back.
+      const Milliseconds frameTime = static_cast<Milliseconds>((uint64_t{frame} * 1000 + framesPerSecond - 1) /
+                                                               framesPerSecond);
+      if (!player.render(kStartTime + frameTime)) { jll_fatal("Player skipped frame %u", frame); }
+      writer.AddFrame(colors.data());
+    }
+  }
+
+  const std::vector<uint8_t> data = writer.Finish();
+  FILE* file = fopen(outputPath, "wb");
+  if (file == nullptr || fwrite(data.data(), 1, data.size(), file) != data.size() || fclose(file) != 0) {
+    jll_error("Failed to write %s", outputPath);
+    return 1;
+  }
+  jll_info("Wrote %d patterns of %u frames for %zu LEDs to %s, %zu bytes instead of %zu uncompressed", argc - optind,
+           numFrames, numLeds, outputPath, data.size(), (argc - optind) * numFrames * numLeds * sizeof(CRGB));
+  return 0;
+}
+
+}  // namespace jazzlights
+
+int main(int argc, char** argv) { return jazzlights::runMain(argc, argv); }
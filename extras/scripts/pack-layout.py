@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+
+# Tool used to convert Point tables into PackedPoints for PackedLayout.
+# Reads C++ source containing "constexpr Point name[] = {...};" tables, such as
+# src/jazzlights/layout/layout_data_*.cpp or the output of clouds-layout.py,
+# and prints the packed version of each table. Unnamed tables such as the
+# output of vestlayout.py are named after the --name argument:
+#   ./vestlayout.py | ./pack-layout.py --name pixelMap
+
+import argparse
+import math
+import re
+import sys
+from fractions import Fraction
+
+NUMBER = r"[-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?"
+POINT = re.compile(r"EmptyPoint\(\)|\{\s*(" + NUMBER + r")\s*,\s*(" + NUMBER + r")\s*\}")
+NAMED_TABLE = re.compile(r"constexpr\s+Point\s+(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\};", re.DOTALL)
+UNNAMED_TABLE = re.compile(r"\{(.*)\};", re.DOTALL)
+MAX_INDEX = 32767
+COLUMN_LIMIT = 120
+
+
+def parseTable(body):
+    """Returns the points in body, with None for EmptyPoint()."""
+    points = []
+    for match in POINT.finditer(body):
+        if match.group(1) is None:
+            points.append(None)
+        else:
+            points.append((Fraction(match.group(1)), Fraction(match.group(2))))
+    return points
+
+
+def fractionGcd(a, b):
+    return Fraction(
+        math.gcd(a.numerator * b.denominator, b.numerator * a.denominator),
+        a.denominator * b.denominator,
+    )
+
+
+def packAxis(name, values):
+    """Returns (origin, step, indices) such that origin + index * step gives back each value."""
+    if not values:
+        return Fraction(0), Fraction(1), []
+    origin = min(values)
+    step = Fraction(0)
+    for value in values:
+        step = fractionGcd(step, value - origin)
+    if step == 0:
+        step = Fraction(1)
+    if (max(values) - origin) / step > MAX_INDEX:
+        step = (max(values) - origin) / MAX_INDEX
+        sys.stderr.write(
+            "warning: {} coordinates do not fit on a 16-bit grid, rounding them\n".format(name)
+        )
+    indices = [round((value - origin) / step) for value in values]
+    for value, index in zip(values, indices):
+        if float(origin) + index * float(step) != float(value):
+            sys.stderr.write(
+                "warning: {} coordinate {} decodes as {}\n".format(
+                    name, float(value), float(origin) + index * float(step)
+                )
+            )
+    return origin, step, indices
+
+
+def formatList(prefix, values):
+    lines = []
+    line = prefix + "{"
+    indent = " " * len(line)
+    for i, value in enumerate(values):
+        item = str(value) + (", " if i < len(values) - 1 else "};")
+        if len(line) + len(item.rstrip()) > COLUMN_LIMIT:
+            lines.append(line.rstrip())
+            line = indent
+        line += item
+    if not values:
+        line += "};"
+    lines.append(line)
+    return "\n".join(lines)
+
+
+def printPacked(name, points):
+    nonEmpty = [point for point in points if point is not None]
+    xOrigin, xStep, xIndices = packAxis(name, [point[0] for point in nonEmpty])
+    yOrigin, yStep, yIndices = packAxis(name, [point[1] for point in nonEmpty])
+    xs, ys, emptyBits = [], [], [0] * ((len(points) + 7) // 8)
+    indices = iter(zip(xIndices, yIndices))
+    for i, point in enumerate(points):
+        if point is None:
+            xs.append(0)
+            ys.append(0)
+            emptyBits[i // 8] |= 1 << (i % 8)
+        else:
+            x, y = next(indices)
+            xs.append(x)
+            ys.append(y)
+    hasEmpty = len(nonEmpty) < len(points)
+
+    print(formatList("constexpr int16_t {}Xs[] = ".format(name), xs))
+    print(formatList("constexpr int16_t {}Ys[] = ".format(name), ys))
+    if hasEmpty:
+        bits = ["0x{:02x}".format(b) for b in emptyBits]
+        print(formatList("constexpr uint8_t {}EmptyBits[] = ".format(name), bits))
+    print("constexpr PackedPoints {} = {{".format(name))
+    print("    .count = {},".format(len(points)))
+    print("    .origin = {{{}, {}}},".format(float(xOrigin), float(yOrigin)))
+    print("    .xStep = {},".format(float(xStep)))
+    print("    .yStep = {},".format(float(yStep)))
+    print("    .xs = {}Xs,".format(name))
+    print("    .ys = {}Ys,".format(name))
+    print("    .emptyBits = {},".format(name + "EmptyBits" if hasEmpty else "nullptr"))
+    print("};")
+    print('static_assert(JL_LENGTH({0}Xs) == {1} && JL_LENGTH({0}Ys) == {1}, "bad size");'.format(name, len(points)))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("input", nargs="?", help="C++ source or layout script output, defaults to stdin")
+    parser.add_argument("--name", default="pixelMap", help="name of an unnamed table")
+    args = parser.parse_args()
+    text = open(args.input).read() if args.input else sys.stdin.read()
+    tables = [(match.group(1), match.group(2)) for match in NAMED_TABLE.finditer(text)]
+    if not tables:
+        match = UNNAMED_TABLE.search(text)
+        if match is None:
+            sys.exit("no Point table found")
+        tables = [(args.name, match.group(1))]
+    for name, body in tables:
+        printPacked(name, parseTable(body))
+
+
+if __name__ == "__main__":
+    main()
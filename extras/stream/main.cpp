@@ -0,0 +1,338 @@
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jazzlights/layout/layout_file.h"
+#include "jazzlights/layout/matrix.h"
+#include "jazzlights/layout/pixelmap.h"
+#include "jazzlights/network/ddp.h"
+#include "jazzlights/player.h"
+#include "jazzlights/util/log.h"
+#include "jazzlights/util/spsc_ring.h"
+#include "jazzlights/util/time.h"
+
+namespace jazzlights {
+
+using Clock = std::chrono::steady_clock;
+
+// Frames that can be in flight for each device. Devices that frames are not sent to fast enough skip older frames.
+constexpr size_t kQueuedFrames = 4;
+constexpr Milliseconds kStartTime = 1;
+
+class FrameRenderer : public Renderer {
+ public:
+  explicit FrameRenderer(size_t numLeds) : colors(numLeds) {}
+  void renderPixel(size_t index, CRGB color) override { colors[index] = color; }
+  std::vector<CRGB> colors;
+};
+
+// A device that frames are streamed to. Its frames are rendered and packetized by one worker thread and sent by the
+// sender thread, which hand the packets of each frame over to each other through lock-free queues of slots.
+struct Device {
+  std::string name;
+  sockaddr_in address = {};
+  std::vector<Point> points;
+  std::unique_ptr<Layout> layout;
+  std::unique_ptr<FrameRenderer> renderer;
+  std::unique_ptr<Player> player;
+  uint8_t sequence = 0;  // Only used by the sender.
+  std::vector<uint8_t> slots[kQueuedFrames];
+  SpscRing<uint8_t, kQueuedFrames> freeSlots;   // Pushed by the sender, popped by the worker.
+  SpscRing<uint8_t, kQueuedFrames> readySlots;  // Pushed by the worker, popped by the sender.
+  std::atomic<uint32_t> numRendered{0};
+  std::atomic<uint32_t> numSent{0};
+  std::atomic<uint32_t> numSkipped{0};
+};
+
+struct Config {
+  uint32_t framesPerSecond = 30;
+  // Number of frames to stream, 0 to stream forever.
+  uint32_t numFrames = 0;
+  // Whether frames are rendered and sent at framesPerSecond, otherwise as fast as possible.
+  bool paced = true;
+  // Portion of each frame period that the packets of all devices are spread over, to avoid bursts that overflow the
+  // receive buffers of devices.
+  double pacing = 0.5;
+};
+
+// Parses HOST[:PORT]=LAYOUT, where LAYOUT is either WxH for a matrix or the path of a layout file.
+bool ParseDevice(const char* spec, Device* device) {
+  const char* equals = strchr(spec, '=');
+  if (equals == nullptr) { return false; }
+  device->name = std::string(spec, equals - spec);
+  std::string host = device->name;
+  uint16_t port = kDdpPort;
+  const size_t colon = host.find(':');
+  if (colon != std::string::npos) {
+    port = strtoul(host.c_str() + colon + 1, nullptr, 10);
+    host.resize(colon);
+  }
+  device->address.sin_family = AF_INET;
+  device->address.sin_port = htons(port);
+  if (inet_pton(AF_INET, host.c_str(), &device->address.sin_addr) != 1) {
+    jll_error("Invalid IPv4 address %s", host.c_str());
+    return false;
+  }
+  size_t width, height;
+  char extra;
+  if (sscanf(equals + 1, "%zux%zu%c", &width, &height, &extra) == 2) {
+    device->layout = std::make_unique<Matrix>(width, height);
+  } else {
+    if (!ReadLayoutFile(equals + 1, &device->points)) { return false; }
+    device->layout = std::make_unique<PixelMap>(device->points.size(), device->points.data());
+  }
+  return true;
+}
+
+void StartPlayer(Device* device, bool shouldSetPattern, PatternBits pattern) {
+  device->renderer = std::make_unique<FrameRenderer>(device->layout->pixelCount());
+  device->player = std::make_unique<Player>();
+  device->player->addStrand(*device->layout, *device->renderer);
+  device->player->begin();
+  // All players go through the same patterns, so starting them at the same time keeps devices in sync.
+  if (shouldSetPattern) {
+    device->player->loopOne(kStartTime);
+    device->player->setPattern(pattern, kStartTime);
+  } else {
+    device->player->next(kStartTime);
+  }
+  for (uint8_t slot = 0; slot < kQueuedFrames; slot++) { device->freeSlots.TryPush(slot); }
+}
+
+void RunWorker(std::vector<Device*> devices, const Config& config, Clock::time_point startTime,
+               std::atomic<size_t>* numWorkersRunning) {
+  for (uint32_t frame = 0; config.numFrames == 0 || frame < config.numFrames; frame++) {
+    // Patterns are rendered at evenly spaced times, so they look the same however late this thread runs.
+    const uint64_t frameOffsetMillis = uint64_t{frame} * 1000 / config.framesPerSecond;
+    if (config.paced) { std::this_thread::sleep_until(startTime + std::chrono::milliseconds(frameOffsetMillis)); }
+    for (Device* device : devices) {
+      // Render even if the frame will be skipped, since some patterns depend on the previous frame.
+      if (!device->player->render(kStartTime + frameOffsetMillis)) { continue; }
+      device->numRendered++;
+      uint8_t slot;
+      if (!device->freeSlots.TryPop(&slot)) {
+        device->numSkipped++;
+        continue;
+      }
+      WriteDdpFrame(device->renderer->colors.data(), device->renderer->colors.size(), &device->slots[slot]);
+      device->readySlots.TryPush(slot);
+    }
+  }
+  numWorkersRunning->fetch_sub(1);
+}
+
+// Sends the latest frame of every device, interleaving their packets and spreading them over the frame period.
+void RunSender(std::vector<std::unique_ptr<Device>>* devices, int fd, const Config& config,
+               const std::atomic<bool>* workersDone) {
+  const Clock::duration framePeriod = std::chrono::nanoseconds(1000000000 / config.framesPerSecond);
+  std::vector<int> latestSlots(devices->size());
+  while (true) {
+    // Read workersDone first so that we do not miss frames queued right before it was set.
+    const bool lastRound = workersDone->load();
+    size_t numPackets = 0;
+    size_t maxPackets = 0;
+    for (size_t i = 0; i < devices->size(); i++) {
+      Device* device = (*devices)[i].get();
+      latestSlots[i] = -1;
+      uint8_t slot;
+      while (device->readySlots.TryPop(&slot)) {
+        if (latestSlots[i] >= 0) {
+          device->freeSlots.TryPush(latestSlots[i]);
+          device->numSkipped++;
+        }
+        latestSlots[i] = slot;
+      }
+      if (latestSlots[i] >= 0) {
+        const size_t devicePackets = DdpPacketCount(device->layout->pixelCount());
+        numPackets += devicePackets;
+        maxPackets = std::max(maxPackets, devicePackets);
+      }
+    }
+    if (numPackets == 0) {
+      if (lastRound) { break; }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      continue;
+    }
+
+    const Clock::duration packetGap =
+        config.paced ? std::chrono::duration_cast<Clock::duration>(framePeriod * config.pacing / numPackets)
+                     : Clock::duration::zero();
+    Clock::time_point nextSendTime = Clock::now();
+    std::vector<size_t> packetOffsets(devices->size(), 0);
+    for (size_t packet = 0; packet < maxPackets; packet++) {
+      for (size_t i = 0; i < devices->size(); i++) {
+        Device* device = (*devices)[i].get();
+        const size_t numLeds = device->layout->pixelCount();
+        if (latestSlots[i] < 0 || packet >= DdpPacketCount(numLeds)) { continue; }
+        if (packetGap != Clock::duration::zero()) {
+          std::this_thread::sleep_until(nextSendTime);
+          nextSendTime += packetGap;
+        }
+        uint8_t* data = device->slots[latestSlots[i]].data() + packetOffsets[i];
+        const size_t size = DdpPacketSize(numLeds, packet);
+        // Packets are numbered when sent, so that skipped frames do not look like lost packets to devices.
+        device->sequence = SetDdpSequence(data, device->sequence);
+        if (sendto(fd, data, size, 0, reinterpret_cast<const sockaddr*>(&device->address), sizeof(device->address)) <
+            0) {
+          jll_error("Failed to send %zu bytes to %s: %s", size, device->name.c_str(), strerror(errno));
+        }
+        packetOffsets[i] += size;
+      }
+    }
+    for (size_t i = 0; i < devices->size(); i++) {
+      if (latestSlots[i] < 0) { continue; }
+      (*devices)[i]->numSent++;
+      (*devices)[i]->freeSlots.TryPush(latestSlots[i]);
+    }
+  }
+}
+
+void PrintStats(const std::vector<std::unique_ptr<Device>>& devices, double seconds) {
+  for (const std::unique_ptr<Device>& device : devices) {
+    jll_info("%s: %zu LEDs, rendered %.1f FPS, sent %.1f FPS, skipped %u frames", device->name.c_str(),
+             device->layout->pixelCount(), device->numRendered / seconds, device->numSent / seconds,
+             device->numSkipped.load());
+  }
+}
+
+int runMain(int argc, char** argv) {
+  Config config;
+  size_t numThreads = 1;
+  bool shouldSetPattern = false;
+  PatternBits pattern = 0;
+  size_t numBenchmarkDevices = 0;
+  size_t benchmarkWidth = 30;
+  size_t benchmarkHeight = 20;
+  std::vector<std::unique_ptr<Device>> devices;
+  while (true) {
+    int ch = getopt(argc, argv, "d:f:j:p:n:P:b:m:");
+    if (ch == -1) { break; }
+    if (ch == 'd') {
+      devices.push_back(std::make_unique<Device>());
+      if (!ParseDevice(optarg, devices.back().get())) { return 1; }
+    }
+    if (ch == 'f') { config.framesPerSecond = strtoul(optarg, nullptr, 10); }
+    if (ch == 'j') { numThreads = strtoul(optarg, nullptr, 10); }
+    if (ch == 'p') {
+      shouldSetPattern = true;
+      pattern = strtoull(optarg, nullptr, 16);
+    }
+    if (ch == 'n') { config.numFrames = strtoul(optarg, nullptr, 10); }
+    if (ch == 'P') { config.pacing = strtoul(optarg, nullptr, 10) / 100.0; }
+    if (ch == 'b') { numBenchmarkDevices = strtoul(optarg, nullptr, 10); }
+    if (ch == 'm' && sscanf(optarg, "%zux%zu", &benchmarkWidth, &benchmarkHeight) != 2) { return 1; }
+    if (ch == '?') { return 1; }
+  }
+  // The player does not render frames closer than 10ms apart.
+  if ((devices.empty() && numBenchmarkDevices == 0) || config.framesPerSecond == 0 || config.framesPerSecond > 100 ||
+      numThreads == 0 || config.pacing < 0 || config.pacing > 1) {
+    fprintf(stderr,
+            "Usage: %s [-f fps] [-j threads] [-p pattern] [-n frames] [-P pacing%%] -d HOST[:PORT]=WxH|layout.csv...\n"
+            "       %s -b devices [-m WxH] [-f fps] [-j threads] [-p pattern] [-n frames]\n",
+            argv[0], argv[0]);
+    return 1;
+  }
+
+  // The benchmark streams as fast as possible to receivers in this process over loopback.
+  std::vector<std::unique_ptr<FrameRenderer>> benchmarkRenderers;
+  std::vector<std::unique_ptr<DdpReceiver>> benchmarkReceivers;
+  if (numBenchmarkDevices > 0) {
+    config.paced = false;
+    if (config.numFrames == 0) { config.numFrames = 1000; }
+    for (size_t i = 0; i < numBenchmarkDevices; i++) {
+      benchmarkRenderers.push_back(std::make_unique<FrameRenderer>(benchmarkWidth * benchmarkHeight));
+      benchmarkReceivers.push_back(DdpReceiver::Create(0));
+      benchmarkReceivers.back()->AddStrand(benchmarkWidth * benchmarkHeight, benchmarkRenderers.back().get());
+      benchmarkReceivers.back()->Receive(timeMillis());
+      const std::string spec = "127.0.0.1:" + std::to_string(benchmarkReceivers.back()->port()) + "=" +
+                               std::to_string(benchmarkWidth) + "x" + std::to_string(benchmarkHeight);
+      devices.push_back(std::make_unique<Device>());
+      if (!ParseDevice(spec.c_str(), devices.back().get())) { return 1; }
+    }
+  }
+
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    jll_error("Failed to create UDP socket: %s", strerror(errno));
+    return 1;
+  }
+  size_t numLeds = 0;
+  for (std::unique_ptr<Device>& device : devices) {
+    StartPlayer(device.get(), shouldSetPattern, pattern);
+    numLeds += device->layout->pixelCount();
+  }
+  numThreads = std::min(numThreads, devices.size());
+  jll_info("Streaming %zu LEDs to %zu devices at %u FPS using %zu render threads", numLeds, devices.size(),
+           config.framesPerSecond, numThreads);
+
+  std::atomic<bool> benchmarkDone(false);
+  std::thread receiverThread;
+  if (!benchmarkReceivers.empty()) {
+    receiverThread = std::thread([&benchmarkReceivers, &benchmarkDone]() {
+      while (!benchmarkDone.load()) {
+        for (std::unique_ptr<DdpReceiver>& receiver : benchmarkReceivers) { receiver->Receive(timeMillis()); }
+      }
+    });
+  }
+
+  const Clock::time_point startTime = Clock::now();
+  std::atomic<bool> workersDone(false);
+  std::thread senderThread(RunSender, &devices, fd, std::cref(config), &workersDone);
+  std::atomic<size_t> numWorkersRunning(numThreads);
+  std::vector<std::thread> workerThreads;
+  for (size_t t = 0; t < numThreads; t++) {
+    std::vector<Device*> workerDevices;
+    for (size_t i = t; i < devices.size(); i += numThreads) { workerDevices.push_back(devices[i].get()); }
+    workerThreads.emplace_back(RunWorker, workerDevices, std::cref(config), startTime, &numWorkersRunning);
+  }
+  constexpr auto kStatsInterval = std::chrono::seconds(10);
+  Clock::time_point nextStatsTime = startTime + kStatsInterval;
+  while (numWorkersRunning.load() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (config.paced && Clock::now() >= nextStatsTime) {
+      PrintStats(devices, std::chrono::duration<double>(Clock::now() - startTime).count());
+      nextStatsTime += kStatsInterval;
+    }
+  }
+  for (std::thread& workerThread : workerThreads) { workerThread.join(); }
+  workersDone.store(true);
+  senderThread.join();
+  const double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+  close(fd);
+  PrintStats(devices, seconds);
+
+  if (receiverThread.joinable()) {
+    // Give the last packets time to arrive.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    benchmarkDone.store(true);
+    receiverThread.join();
+    uint64_t numReceivedFrames = 0;
+    uint32_t numLostPackets = 0;
+    for (const std::unique_ptr<DdpReceiver>& receiver : benchmarkReceivers) {
+      numReceivedFrames += receiver->numFrames();
+      numLostPackets += receiver->numLostPackets();
+    }
+    const double receivedFramesPerSecond = numReceivedFrames / seconds / benchmarkReceivers.size();
+    jll_info("Received %.1f FPS per device x %zu devices x %zu LEDs = %.2f million LEDs per second, %u packets lost",
+             receivedFramesPerSecond, benchmarkReceivers.size(), benchmarkWidth * benchmarkHeight,
+             receivedFramesPerSecond * numLeds / 1e6, numLostPackets);
+  }
+  return 0;
+}
+
+}  // namespace jazzlights
+
+int main(int argc, char** argv) { return jazzlights::runMain(argc, argv); }
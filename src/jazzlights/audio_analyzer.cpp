@@ -0,0 +1,325 @@
+#include "jazzlights/audio_analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "jazzlights/util/log.h"
+
+#if JL_AUDIO_ANALYZER_USE_ESP_DSP
+#include <esp_dsp.h>
+#endif  // JL_AUDIO_ANALYZER_USE_ESP_DSP
+
+namespace jazzlights {
+
+namespace {
+
+constexpr float kMinBandFrequency = 62.5f;
+constexpr float kMaxBandFrequency = 8000.0f;
+
+float HertzToMel(float hertz) { return 2595.0f * log10f(1.0f + hertz / 700.0f); }
+
+float MelToHertz(float mel) { return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f); }
+
+// Returns the lower edge of band, or the upper edge of the last band when band is kNumBands.
+float BandEdgeFrequency(AudioAnalyzer::BandSpacing spacing, int band) {
+  const float fraction = static_cast<float>(band) / AudioAnalyzer::kNumBands;
+  switch (spacing) {
+    case AudioAnalyzer::BandSpacing::kLogarithmic: {
+      const float log_min = log2f(kMinBandFrequency);
+      const float log_max = log2f(kMaxBandFrequency);
+      return powf(2.0f, log_min + fraction * (log_max - log_min));
+    }
+    case AudioAnalyzer::BandSpacing::kMel: {
+      const float mel_min = HertzToMel(kMinBandFrequency);
+      const float mel_max = HertzToMel(kMaxBandFrequency);
+      return MelToHertz(mel_min + fraction * (mel_max - mel_min));
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+AudioAnalyzer::AudioAnalyzer(const Config& config)
+    : config_(config),
+      agc_window_min_(kDefaultAgcWindowSize * kDefaultConfig.hop_size / std::max(config.hop_size, kMinHopSize)),
+      agc_window_max_(kDefaultAgcWindowSize * kDefaultConfig.hop_size / std::max(config.hop_size, kMinHopSize)),
+      beat_window_size_(kDefaultBeatWindowSize * kDefaultConfig.hop_size / std::max(config.hop_size, kMinHopSize)) {
+  const int fft_size = config_.fft_size;
+  if (fft_size < kMinFFTSize || fft_size > kMaxFFTSize || (fft_size & (fft_size - 1)) != 0) {
+    jll_fatal("Invalid audio FFT size %d", fft_size);
+  }
+  if (config_.hop_size < kMinHopSize || config_.hop_size > fft_size) {
+    jll_fatal("Invalid audio hop size %d for FFT size %d", config_.hop_size, fft_size);
+  }
+  const float frames_per_default_frame = static_cast<float>(config_.hop_size) / kDefaultConfig.hop_size;
+  smoothing_ = powf(0.4f, frames_per_default_frame);
+  peak_decay_ = 0.5f * frames_per_default_frame;  // dB per frame
+  agc_smoothing_ = powf(0.95f, frames_per_default_frame);
+  const float amplitude_scale = static_cast<float>(kDefaultConfig.fft_size) / fft_size;
+  power_scale_ = amplitude_scale * amplitude_scale;
+
+  sample_history_.reset(new float[fft_size]());
+  fft_input_.reset(new float[fft_size * 2]());
+  fft_output_.reset(new float[fft_size / 2]());
+  fft_window_.reset(new float[fft_size]);
+
+  // Map FFT bins to bands.
+  const float bin_width = static_cast<float>(kSampleRate) / fft_size;
+  for (int i = 0; i < kNumBands; i++) {
+    int start_bin = (int)(BandEdgeFrequency(config_.band_spacing, i) / bin_width);
+    int end_bin = (int)(BandEdgeFrequency(config_.band_spacing, i + 1) / bin_width);
+    if (start_bin < 1) start_bin = 1;
+    if (end_bin <= start_bin) end_bin = start_bin + 1;
+    if (end_bin > fft_size / 2) end_bin = fft_size / 2;
+    band_start_bin_[i] = start_bin;
+    band_end_bin_[i] = end_bin;
+  }
+
+#if JL_AUDIO_ANALYZER_USE_ESP_DSP
+  // The real FFT runs a complex FFT of half the size on the packed samples.
+  ESP_ERROR_CHECK(dsps_fft4r_init_fc32(nullptr, fft_size / 2));
+  dsps_wind_hann_f32(fft_window_.get(), fft_size);
+#else   // JL_AUDIO_ANALYZER_USE_ESP_DSP
+  // Same Hann window as dsps_wind_hann_f32.
+  for (int i = 0; i < fft_size; i++) {
+    fft_window_[i] = 0.5 * (1 - cosf(i * 2 * M_PI / static_cast<float>(fft_size - 1)));
+  }
+  fft_twiddles_.reset(new float[fft_size]);
+  for (int i = 0; i < fft_size / 2; i++) {
+    fft_twiddles_[i * 2] = cosf(2 * M_PI * i / fft_size);
+    fft_twiddles_[i * 2 + 1] = -sinf(2 * M_PI * i / fft_size);
+  }
+#endif  // JL_AUDIO_ANALYZER_USE_ESP_DSP
+}
+
+void AudioAnalyzer::RunFFT() {
+  const int fft_size = config_.fft_size;
+  // The window starts at the oldest sample, which sits in the middle of the ring buffer.
+  const int first_length = fft_size - sample_history_index_;
+  const float* history = sample_history_.get();
+  const float* window = fft_window_.get();
+  float* fft = fft_input_.get();
+#if JL_AUDIO_ANALYZER_USE_ESP_DSP
+  // Pack the real samples as fft_size / 2 complex values, then let esp-dsp split the spectrum back out. This halves
+  // the work compared to a complex FFT with zero imaginary parts.
+  dsps_mul_f32(history + sample_history_index_, window, fft, first_length, 1, 1, 1);
+  dsps_mul_f32(history, window + first_length, fft + first_length, sample_history_index_, 1, 1, 1);
+  ESP_ERROR_CHECK(dsps_fft4r_fc32(fft, fft_size / 2));
+  dsps_bit_rev4r_fc32(fft, fft_size / 2);
+  dsps_cplx2real_fc32(fft, fft_size / 2);
+#else   // JL_AUDIO_ANALYZER_USE_ESP_DSP
+  for (int i = 0; i < fft_size; i++) {
+    const int h = i < first_length ? sample_history_index_ + i : i - first_length;
+    fft[i * 2] = history[h] * window[i];
+    fft[i * 2 + 1] = 0.0f;
+  }
+  // Iterative radix-2 decimation-in-time FFT: bit-reverse the input, then run the butterflies.
+  for (int i = 1, j = 0; i < fft_size; i++) {
+    int bit = fft_size >> 1;
+    for (; j & bit; bit >>= 1) { j ^= bit; }
+    j ^= bit;
+    if (i < j) {
+      std::swap(fft[i * 2], fft[j * 2]);
+      std::swap(fft[i * 2 + 1], fft[j * 2 + 1]);
+    }
+  }
+  for (int length = 2; length <= fft_size; length <<= 1) {
+    const int half = length / 2;
+    const int twiddleStep = fft_size / length;
+    for (int start = 0; start < fft_size; start += length) {
+      for (int k = 0; k < half; k++) {
+        const float wr = fft_twiddles_[k * twiddleStep * 2];
+        const float wi = fft_twiddles_[k * twiddleStep * 2 + 1];
+        float* a = &fft[(start + k) * 2];
+        float* b = &fft[(start + k + half) * 2];
+        const float tr = b[0] * wr - b[1] * wi;
+        const float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+#endif  // JL_AUDIO_ANALYZER_USE_ESP_DSP
+
+  // Convert to magnitude (dB). Both FFTs leave bin k at index 2k for k < fft_size / 2.
+  for (int i = 0; i < fft_size / 2; i++) {
+    float real = fft[i * 2];
+    float imag = fft[i * 2 + 1];
+    float power = (real * real + imag * imag) * power_scale_;
+    fft_output_[i] = 10 * log10f(power + 1.0f);
+  }
+}
+
+void AudioAnalyzer::GetVisualizerData(VisualizerData* data) const {
+  memcpy(data->bands, band_magnitudes_, sizeof(band_magnitudes_));
+  memcpy(data->peaks, peak_magnitudes_, sizeof(peak_magnitudes_));
+  data->agc_min = agc_min_;
+  data->agc_max = agc_max_;
+  data->volume = volume_;
+  data->beat = beat_;
+  data->squelch = is_squelched_;
+  data->last_read_time = last_read_time_;
+}
+
+void AudioAnalyzer::ProcessSamples(const int16_t* samples, int numChannels, Milliseconds currentTime) {
+  bool all_zero = true;
+  const int hop_size = config_.hop_size;
+  for (int i = 0; i < hop_size * numChannels; i++) {
+    if (samples[i] != 0) {
+      all_zero = false;
+      break;
+    }
+  }
+  // Replicate M5Unified processing: noise filter and magnification
+  const int32_t noise_filter_level = 16;
+  const float magnification = 16.0f;
+  for (int i = 0; i < hop_size; i++) {
+    int32_t val = samples[i * numChannels];
+    // IIR filter: v = (val * (256 - alpha) + prev * alpha + 128) >> 8
+    int32_t v = (val * (256 - noise_filter_level) + (int32_t)prev_sample_ * noise_filter_level + 128) >> 8;
+    prev_sample_ = (float)v;
+    float fval = (float)v * magnification;
+
+    sample_history_[sample_history_index_] = fval;
+    sample_history_index_ = (sample_history_index_ + 1) % config_.fft_size;
+  }
+
+  // Apply window and perform FFT
+  RunFFT();
+
+  float new_bands[kNumBands];
+  for (int i = 0; i < kNumBands; i++) {
+    float sum = 0;
+    int count = 0;
+    for (int b = band_start_bin_[i]; b < band_end_bin_[i]; b++) {
+      sum += fft_output_[b];
+      count++;
+    }
+    new_bands[i] = (count > 0) ? (sum / count) : 0;
+  }
+
+  // Squelch: If maximum band magnitude is below threshold, zero out everything
+  float max_new_band_mag = 0;
+  for (int i = 0; i < kNumBands; i++) {
+    if (new_bands[i] > max_new_band_mag) { max_new_band_mag = new_bands[i]; }
+  }
+
+  if (!all_zero) { last_read_time_ = currentTime; }
+  if (max_new_band_mag < squelch_threshold_) {
+    memset(band_magnitudes_, 0, sizeof(band_magnitudes_));
+    memset(peak_magnitudes_, 0, sizeof(peak_magnitudes_));
+    memset(prev_bands_, 0, sizeof(prev_bands_));
+    volume_ = 0;
+    beat_ = false;
+    is_squelched_ = true;
+    // We still want to update beat buffer to avoid large flux when sound returns
+    PushBeatFlux(0);
+    return;
+  }
+
+  // Smoothing and Peak Decay
+  is_squelched_ = false;
+  for (int i = 0; i < kNumBands; i++) {
+    band_magnitudes_[i] = band_magnitudes_[i] * smoothing_ + new_bands[i] * (1.0f - smoothing_);
+    if (new_bands[i] > peak_magnitudes_[i]) {
+      peak_magnitudes_[i] = new_bands[i];
+    } else {
+      peak_magnitudes_[i] -= peak_decay_;
+      if (peak_magnitudes_[i] < 0) peak_magnitudes_[i] = 0;
+    }
+  }
+
+  // AGC Tracking: Update 5-second window
+  {
+    float max_band_mag = 0;
+    for (int i = 0; i < kNumBands; i++) {
+      if (band_magnitudes_[i] > max_band_mag) max_band_mag = band_magnitudes_[i];
+    }
+    // Only frames with sound count towards the AGC range.
+    if (max_band_mag > 0) {
+      agc_window_min_.Push(max_band_mag);
+      agc_window_max_.Push(max_band_mag);
+    }
+
+    if (!agc_window_min_.empty()) {
+      float current_min = std::min(agc_window_min_.value(), 100.0f);
+      float current_max = std::max(agc_window_max_.value(), -100.0f);
+      if (current_max - current_min < 4.0f) {
+        float center = (current_max + current_min) / 2.0f;
+        current_min = center - 2.0f;
+        current_max = center + 2.0f;
+      }
+      agc_min_ = agc_min_ * agc_smoothing_ + current_min * (1.0f - agc_smoothing_);
+      agc_max_ = agc_max_ * agc_smoothing_ + current_max * (1.0f - agc_smoothing_);
+    }
+  }
+
+  // Calculate overall volume (average normalized magnitude)
+  // Uses current agc_min/max if enabled, otherwise defaults
+  float v_min = agc_enabled_ ? agc_min_ : 40.0f;
+  float v_max = agc_enabled_ ? agc_max_ : 100.0f;
+  float range = v_max - v_min;
+  if (range < 1.0f) range = 1.0f;
+  float totalNormMag = 0;
+  for (int i = 0; i < kNumBands; i++) {
+    float norm = (band_magnitudes_[i] - v_min) / range;
+    if (norm < 0) norm = 0;
+    if (norm > 1.0f) norm = 1.0f;
+    totalNormMag += norm;
+  }
+  volume_ = totalNormMag / kNumBands;
+  is_squelched_ = (volume_ < 0.4f);
+
+  // Beat detection: Spectral Flux on first 8 bands (bass/low-mids)
+  float flux = 0;
+  for (int i = 0; i < 8; i++) {
+    float diff = new_bands[i] - prev_bands_[i];
+    if (diff > 0) flux += diff;
+    prev_bands_[i] = new_bands[i];
+  }
+
+  float beat_energy = 0;
+  for (int i = 0; i < 8; i++) { beat_energy += new_bands[i]; }
+  beat_energy /= 8.0f;
+
+  // Compare flux to average flux in the window
+  const float avg_flux = (beat_flux_count_ > 0) ? (beat_flux_sum_ / beat_flux_count_) : 0;
+
+  beat_ = false;
+  // Trigger if flux is significantly above average OR we have a very sharp spike
+  if ((flux > avg_flux * 1.3f || flux > avg_flux + 1.5f) && flux > 0.15f && beat_energy > agc_min_ - 25.0f &&
+      currentTime - last_beat_time_ > 140) {
+    beat_ = true;
+    last_beat_time_ = currentTime;
+  }
+
+  PushBeatFlux(flux);
+}
+
+void AudioAnalyzer::PushBeatFlux(float flux) {
+  const float evicted = beat_buffer_[beat_index_];
+  if (evicted > 0) {
+    beat_flux_sum_ -= evicted;
+    beat_flux_count_--;
+  }
+  beat_buffer_[beat_index_] = flux;
+  if (flux > 0) {
+    beat_flux_sum_ += flux;
+    beat_flux_count_++;
+  }
+  beat_index_ = (beat_index_ + 1) % beat_window_size_;
+  if (beat_index_ == 0) {
+    // Recompute the sum once per window so that floating-point rounding errors cannot accumulate.
+    beat_flux_sum_ = 0;
+    for (int i = 0; i < beat_window_size_; i++) {
+      if (beat_buffer_[i] > 0) { beat_flux_sum_ += beat_buffer_[i]; }
+    }
+  }
+}
+
+}  // namespace jazzlights
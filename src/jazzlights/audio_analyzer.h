@@ -0,0 +1,159 @@
+#ifndef JAZZLIGHTS_AUDIO_ANALYZER_H
+#define JAZZLIGHTS_AUDIO_ANALYZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "jazzlights/config.h"
+#include "jazzlights/util/sliding_window.h"
+#include "jazzlights/util/time.h"
+
+// esp-dsp is only a dependency of audio visualizer builds.
+#ifndef JL_AUDIO_ANALYZER_USE_ESP_DSP
+#if defined(ESP32) && JL_AUDIO_VISUALIZER
+#define JL_AUDIO_ANALYZER_USE_ESP_DSP 1
+#else  // ESP32 && JL_AUDIO_VISUALIZER
+#define JL_AUDIO_ANALYZER_USE_ESP_DSP 0
+#endif  // ESP32 && JL_AUDIO_VISUALIZER
+#endif  // JL_AUDIO_ANALYZER_USE_ESP_DSP
+
+namespace jazzlights {
+
+// Turns blocks of microphone samples into band magnitudes, automatic gain control bounds and beat detection. This
+// does not depend on any hardware: the Audio class feeds it from the I2S microphone on device, and host tools can feed
+// it recordings. The FFT uses esp-dsp's real FFT on ESP32 audio builds and a portable implementation everywhere else.
+//
+// Each analysis covers the last fft_size samples, and a new analysis runs every hop_size samples. The default
+// configuration matches the original 256-sample analysis without any overlap. Larger FFTs give finer frequency
+// resolution in the bass, and a hop smaller than the FFT makes consecutive windows overlap so that beats are detected
+// with a latency of one hop instead of one full window.
+//
+// This class does not do any locking, it is meant to be owned by a single thread.
+class AudioAnalyzer {
+ public:
+  static constexpr uint32_t kSampleRate = 16000;
+  static constexpr int kNumBands = 32;
+  static constexpr int kMinFFTSize = 128;
+  static constexpr int kMaxFFTSize = 1024;
+  // Smallest supported hop, which bounds the size of the AGC and beat windows.
+  static constexpr int kMinHopSize = 128;
+
+  enum class BandSpacing : uint8_t {
+    kLogarithmic,
+    kMel,
+  };
+
+  struct Config {
+    // Number of samples in each FFT, must be a power of two between kMinFFTSize and kMaxFFTSize.
+    int fft_size;
+    // Number of new samples per analysis, between kMinHopSize and fft_size. Windows overlap when this is smaller than
+    // fft_size, for example a hop of fft_size / 4 gives 75% overlap.
+    int hop_size;
+    // How the FFT bins between 62.5Hz and 8kHz are grouped into bands.
+    BandSpacing band_spacing;
+  };
+
+  // 256-sample FFT without overlap, one analysis every 16ms.
+  static constexpr Config kDefaultConfig = {256, 256, BandSpacing::kLogarithmic};
+  // 512-sample FFT with 75% overlap and mel-spaced bands, one analysis every 8ms with 31.25Hz bins.
+  static constexpr Config kHighResolutionConfig = {512, 128, BandSpacing::kMel};
+
+  struct VisualizerData {
+    float bands[kNumBands];
+    float peaks[kNumBands];
+    float agc_min;
+    float agc_max;
+    float volume;
+    bool beat;
+    bool squelch;
+    Milliseconds last_read_time;
+  };
+
+  explicit AudioAnalyzer(const Config& config = kDefaultConfig);
+  // Disallow copy and move since the FFT buffers are large.
+  AudioAnalyzer(const AudioAnalyzer&) = delete;
+  AudioAnalyzer(AudioAnalyzer&&) = delete;
+  AudioAnalyzer& operator=(const AudioAnalyzer&) = delete;
+  AudioAnalyzer& operator=(AudioAnalyzer&&) = delete;
+
+  const Config& config() const { return config_; }
+  // Duration of audio that each call to ProcessSamples() consumes.
+  Milliseconds FrameDuration() const { return config_.hop_size * 1000 / kSampleRate; }
+
+  // Consumes hop_size frames of interleaved samples with numChannels channels and analyzes the last fft_size samples.
+  // Only the first channel is analyzed. currentTime is used for beat rate limiting and to report when we last received
+  // non-silent samples.
+  void ProcessSamples(const int16_t* samples, int numChannels, Milliseconds currentTime);
+
+  void GetVisualizerData(VisualizerData* data) const;
+
+  bool IsAgcEnabled() const { return agc_enabled_; }
+  void SetAgcEnabled(bool enabled) { agc_enabled_ = enabled; }
+
+ private:
+  // Windows the contents of sample_history_ into fft_input_ and transforms it, leaving the power of each bin in
+  // fft_output_.
+  void RunFFT();
+  // Adds flux to the beat window, evicting the oldest entry.
+  void PushBeatFlux(float flux);
+
+  const Config config_;
+  // Per-analysis constants derived from the hop size so that smoothing and decay keep the same time constants as the
+  // default configuration.
+  float smoothing_;
+  float peak_decay_;
+  float agc_smoothing_;
+  // Scales FFT power so that a given tone reads the same number of dB regardless of fft_size.
+  float power_scale_;
+
+  float band_magnitudes_[kNumBands] = {0};
+  float peak_magnitudes_[kNumBands] = {0};
+  float agc_min_ = 40.0f;
+  float agc_max_ = 100.0f;
+  bool agc_enabled_ = false;
+  float squelch_threshold_ = 75.0f;
+  float volume_ = 0;
+  bool beat_ = false;
+  bool is_squelched_ = false;
+  Milliseconds last_beat_time_ = 0;
+  float prev_bands_[8] = {0};
+  float prev_sample_ = 0;
+  Milliseconds last_read_time_ = -1;
+
+  // Ring buffer of the last fft_size filtered samples, the oldest one is at sample_history_index_.
+  std::unique_ptr<float[]> sample_history_;
+  int sample_history_index_ = 0;
+  // Interleaved real and imaginary parts, fft_size complex values.
+  std::unique_ptr<float[]> fft_input_;
+  // Power in dB of each of the fft_size / 2 bins.
+  std::unique_ptr<float[]> fft_output_;
+  std::unique_ptr<float[]> fft_window_;
+#if !JL_AUDIO_ANALYZER_USE_ESP_DSP
+  // cos and -sin of 2*pi*k/fft_size for the portable FFT, interleaved.
+  std::unique_ptr<float[]> fft_twiddles_;
+#endif  // !JL_AUDIO_ANALYZER_USE_ESP_DSP
+
+  // Range of FFT bins [start, end) averaged into each band. Only depends on the configuration so it is computed once.
+  uint16_t band_start_bin_[kNumBands];
+  uint16_t band_end_bin_[kNumBands];
+
+  // Loudest band of each non-squelched frame over the last ~5 seconds.
+  static constexpr int kDefaultAgcWindowSize = 312;  // ~5 seconds at 16ms per sample
+  static constexpr int kMaxAgcWindowSize = kDefaultAgcWindowSize * kDefaultConfig.hop_size / kMinHopSize;
+  SlidingWindowMin<float, kMaxAgcWindowSize> agc_window_min_;
+  SlidingWindowMax<float, kMaxAgcWindowSize> agc_window_max_;
+
+  static constexpr int kDefaultBeatWindowSize = 60;  // ~1 second at 16ms per sample
+  static constexpr int kMaxBeatWindowSize = kDefaultBeatWindowSize * kDefaultConfig.hop_size / kMinHopSize;
+  const int beat_window_size_;
+  float beat_buffer_[kMaxBeatWindowSize] = {0};
+  int beat_index_ = 0;
+  // Sum and number of the positive entries of beat_buffer_, maintained incrementally.
+  float beat_flux_sum_ = 0;
+  int beat_flux_count_ = 0;
+};
+
+}  // namespace jazzlights
+
+#endif  // JAZZLIGHTS_AUDIO_ANALYZER_H
@@ -2,6 +2,8 @@
 #define JL_EFFECT_COLOREDBURSTS_H
 
 #include "jazzlights/effect/effect.h"
+#include "jazzlights/effect/grid_kernels.h"
+#include "jazzlights/effect/line_raster.h"
 #include "jazzlights/fastled_wrapper.h"
 #include "jazzlights/palette.h"
 #include "jazzlights/pseudorandom.h"
@@ -57,9 +59,7 @@ class ColoredBursts : public EffectWithPaletteXYIndexAndState<ColoredBurstsState
   void innerRewind(const Frame& f, ColoredBurstsState* state) const override {
     state->hue++;
     // Slightly fade all pixels.
-    for (size_t x = 0; x < w(f); x++) {
-      for (size_t y = 0; y < h(f); y++) { ps(f, x, y).nscale8(state->fadeScale); }
-    }
+    GridScale8(cells(f), w(f) * h(f), state->fadeScale);
 
     int x1 = jlbeatsin(2 + state->speed, f.time, 0, (w(f) - 1));
     int y1 = jlbeatsin(5 + state->speed, f.time, 0, (h(f) - 1));
@@ -70,20 +70,8 @@ class ColoredBursts : public EffectWithPaletteXYIndexAndState<ColoredBurstsState
       curX1 = x1;
       curY1 = y1;
     }
-    const int xMark = 4;
-    const int yMark = 4;
-    int x1Min = std::min(curX1, x1);
-    int x1Max = std::max(curX1, x1);
-    if (x1Max - x1Min > xMark) {
-      x1Min = x1;
-      x1Max = x1;
-    }
-    int y1Min = std::min(curY1, y1);
-    int y1Max = std::max(curY1, y1);
-    if (y1Max - y1Min > yMark) {
-      y1Min = y1;
-      y1Max = y1;
-    }
+    const int fromX1 = sweepStart(curX1, x1);
+    const int fromY1 = sweepStart(curY1, y1);
 
     for (uint8_t i = 0; i < state->numLines; i++) {
       int x2 = jlbeatsin(1 + state->speed, f.time, 0, (w(f) - 1), i * 24);
@@ -96,24 +84,15 @@ class ColoredBursts : public EffectWithPaletteXYIndexAndState<ColoredBurstsState
         curX2 = x2;
         curY2 = y2;
       }
-      int x2Min = std::min(curX2, x2);
-      int x2Max = std::max(curX2, x2);
-      if (x2Max - x2Min > xMark) {
-        x2Min = x2;
-        x2Max = x2;
-      }
-      int y2Min = std::min(curY2, y2);
-      int y2Max = std::max(curY2, y2);
-      if (y2Max - y2Min > yMark) {
-        y2Min = y2;
-        y2Max = y2;
-      }
-      for (int x1t = x1Min; x1t <= x1Max; x1t++) {
-        for (int x2t = x2Min; x2t <= x2Max; x2t++) {
-          for (int y1t = y1Min; y1t <= y1Max; y1t++) {
-            for (int y2t = y2Min; y2t <= y2Max; y2t++) { drawLine(f, state, x1t, x2t, y1t, y2t, color); }
-          }
-        }
+      const int fromX2 = sweepStart(curX2, x2);
+      const int fromY2 = sweepStart(curY2, y2);
+      // Sweep the line from where it was last frame to where it is now, one cell of movement at a time, so that it
+      // leaves a continuous trail.
+      const int sweepSteps = std::max(std::max(std::abs(x1 - fromX1), std::abs(y1 - fromY1)),
+                                      std::max(std::abs(x2 - fromX2), std::abs(y2 - fromY2)));
+      for (int step = 0; step <= sweepSteps; step++) {
+        drawLine(f, state, sweepPosition(fromX1, x1, step, sweepSteps), sweepPosition(fromY1, y1, step, sweepSteps),
+                 sweepPosition(fromX2, x2, step, sweepSteps), sweepPosition(fromY2, y2, step, sweepSteps), color);
       }
       curX2 = x2;
       curY2 = y2;
@@ -124,37 +103,20 @@ class ColoredBursts : public EffectWithPaletteXYIndexAndState<ColoredBurstsState
   }
 
  private:
-  void drawLine(const Frame& f, ColoredBurstsState* state, int x1, int x2, int y1, int y2, CRGB color) const {
-    int xsteps = std::abs(x1 - y1) + 1;
-    int ysteps = std::abs(x2 - y2) + 1;
-    bool steppingX = xsteps >= ysteps;
-    int steps = steppingX ? xsteps : ysteps;
-
-    for (int i = 1; i <= steps; i++) {
-      int dx = x1 + (x2 - x1) * i / steps;
-      int dy = y1 + (y2 - y1) * i / steps;
-      ps(f, dx, dy) += color;
-      if (state->grad) { ps(f, dx, dy) %= (i * 255 / steps); }
-      if (steppingX) {
-        if (dx < x1 && dx < x2) {
-          ps(f, dx + 1, dy) += color;
-          if (state->grad) { ps(f, dx + 1, dy) %= (i * 255 / steps); }
-        }
-        if (dx > x1 && dx > x2) {
-          ps(f, dx - 1, dy) += color;
-          if (state->grad) { ps(f, dx - 1, dy) %= (i * 255 / steps); }
-        }
-      } else {
-        if (dy < y1 && dy < y2) {
-          ps(f, dx, dy + 1) += color;
-          if (state->grad) { ps(f, dx, dy + 1) %= (i * 255 / steps); }
-        }
-        if (dy > y1 && dy > y2) {
-          ps(f, dx, dy - 1) += color;
-          if (state->grad) { ps(f, dx, dy - 1) %= (i * 255 / steps); }
-        }
-      }
-    }
+  // Endpoints that moved further than this since the last frame jump instead of sweeping.
+  static constexpr int kMaxSweep = 4;
+
+  static int sweepStart(int previous, int current) {
+    return std::abs(current - previous) > kMaxSweep ? current : previous;
+  }
+
+  static int sweepPosition(int from, int to, int step, int steps) {
+    if (steps == 0) { return to; }
+    return from + (to - from) * step / steps;
+  }
+
+  void drawLine(const Frame& f, ColoredBurstsState* state, int x1, int y1, int x2, int y2, CRGB color) const {
+    DrawLine(cells(f), w(f), h(f), x1, y1, x2, y2, color, state->grad);
 
     if (state->dot) {  // add white point at the ends of line
       ps(f, x1, y1) += CRGB::White;
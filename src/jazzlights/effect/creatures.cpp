@@ -203,6 +203,8 @@ void Creatures::begin(const Frame& frame) const {
       distance(state(frame)->origin, leftbottom(frame)),
       distance(state(frame)->origin, rightbottom(frame)),
   });
+  ComputePixelField(frame, PixelFieldType::kDistance, state(frame)->origin, 255 / state(frame)->maxDistance,
+                    rainbowHueOffsets(frame));
 }
 
 // Called once for each point in time to prepare the state before calling color() for each pixel.
@@ -260,9 +262,8 @@ CRGB Creatures::color(const Frame& frame, const Pixel& px) const {
   }
   if (state(frame)->rainbow) {
     // The rainbow effect determines the hue based on the distance from the rainbow origin point.
-    const double d = distance(px.coord, state(frame)->origin);
-    return ColorFromPalette(RainbowColors_p,
-                            state(frame)->initialHue + int32_t(255 * d / state(frame)->maxDistance) % 255);
+    const int32_t hueOffset = int32_t(rainbowHueOffsets(frame)[px.cumulativeIndex]);
+    return ColorFromPalette(RainbowColors_p, state(frame)->initialHue + hueOffset % 255);
   }
 #if JL_CREATURE_CYBERPUNK
   static const CRGBPalette16* kCyberPunkPalette = GetCyberPunkPalette();
@@ -5,6 +5,7 @@
 
 #include "jazzlights/config.h"
 #include "jazzlights/effect/effect.h"
+#include "jazzlights/effect/pixel_field.h"
 
 #if JL_IS_CONFIG(CREATURE)
 
@@ -56,7 +57,7 @@ class Creatures : public Effect {
 
   std::string effectName(PatternBits /*pattern*/) const override { return "creatures"; }
 
-  size_t contextSize(const Frame& /*frame*/) const override { return sizeof(CreaturesState); }
+  size_t contextSize(const Frame& frame) const override { return sizeof(CreaturesState) + PixelFieldSize(frame); }
 
   void begin(const Frame& frame) const override;
   void rewind(const Frame& frame) const override;
@@ -78,6 +79,8 @@ class Creatures : public Effect {
     static_assert(alignof(CreaturesState) <= kMaxStateAlignment, "Need to increase kMaxStateAlignment");
     return static_cast<CreaturesState*>(frame.context);
   }
+  // Rainbow hue offset of each pixel, indexed by cumulative index. Stored right after the state.
+  float* rainbowHueOffsets(const Frame& frame) const { return reinterpret_cast<float*>(state(frame) + 1); }
 };
 
 }  // namespace jazzlights
@@ -47,10 +47,15 @@ class XYIndexStateEffect : public Effect {
   virtual void innerRewind(const Frame& frame, STATE* state) const = 0;
   virtual CRGB innerColor(const Frame& frame, STATE* state, const Pixel& px) const = 0;
 
-  size_t contextSize(const Frame& frame) const override {
-    return offsetof(XYIndexState, pixels) + sizeof(PER_PIXEL_TYPE) * width(frame) * height(frame);
+  // Effects that need more memory than STATE and the per-pixel grid, for example one entry per column, can request it
+  // here. It is available through extraContext() and is not initialized.
+  virtual size_t extraContextSize(const Frame& frame) const {
+    (void)frame;
+    return 0;
   }
 
+  size_t contextSize(const Frame& frame) const override { return extraContextOffset(frame) + extraContextSize(frame); }
+
   CRGB color(const Frame& frame, const Pixel& px) const override {
     *pos(frame) = frame.xyIndexStore->FromPixel(px);
     return innerColor(frame, state(frame), px);
@@ -84,7 +89,12 @@ class XYIndexStateEffect : public Effect {
     return pixels(f)[y * w(f) + x];
   }
   PER_PIXEL_TYPE& ps(const Frame& f) const { return ps(f, x(f), y(f)); }
+  // Row-major per-pixel data for whole-grid passes such as the ones in grid_kernels.h: (x, y) is at y * w(f) + x.
+  PER_PIXEL_TYPE* cells(const Frame& f) const { return pixels(f); }
   STATE* state(const Frame& frame) const { return &xyindexState(frame)->state; }
+  void* extraContext(const Frame& frame) const {
+    return static_cast<uint8_t*>(frame.context) + extraContextOffset(frame);
+  }
 
  private:
   struct XYIndexState {
@@ -100,6 +110,10 @@ class XYIndexStateEffect : public Effect {
   size_t height(const Frame& frame) const { return frame.xyIndexStore->yValuesCount(); }
   XYIndex* pos(const Frame& frame) const { return &(xyindexState(frame)->pos); }
   PER_PIXEL_TYPE* pixels(const Frame& frame) const { return xyindexState(frame)->pixels; }
+  size_t extraContextOffset(const Frame& frame) const {
+    const size_t gridEnd = offsetof(XYIndexState, pixels) + sizeof(PER_PIXEL_TYPE) * width(frame) * height(frame);
+    return (gridEnd + kMaxStateAlignment - 1) & ~(kMaxStateAlignment - 1);
+  }
 };
 
 struct EmptyState {};
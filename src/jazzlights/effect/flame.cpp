@@ -3,6 +3,7 @@
 #include <assert.h>
 
 #include "jazzlights/config.h"
+#include "jazzlights/effect/grid_kernels.h"
 #include "jazzlights/player.h"
 
 namespace jazzlights {
@@ -32,24 +33,14 @@ void Flame::innerBegin(const Frame& f, FlameState* state) const {
 }
 
 void Flame::innerRewind(const Frame& f, FlameState* state) const {
+  // Step 1.  Cool down every cell a little
+  GridSubtractRandom(cells(f), w(f) * h(f), state->maxDim, f.predictableRandom);
+
+  // Step 2.  Heat from each cell drifts 'up' and diffuses a little
+  GridBlurShiftRows(cells(f), w(f), h(f));
+
+  // Step 3.  Randomly ignite new 'sparks' of heat near the bottom
   for (size_t x = 0; x < w(f); x++) {
-    // Step 1.  Cool down every cell a little
-    for (size_t y = 0; y < h(f); y++) {
-      ps(f, x, y) = qsub8(ps(f, x, y), f.predictableRandom->GetRandomNumberBetween(0, state->maxDim));
-    }
-
-    // Step 2.  Heat from each cell drifts 'up' and diffuses a little
-    for (size_t y2 = h(f) - 1; y2 >= 3; y2--) {
-      ps(f, x, y2) = (static_cast<uint16_t>(ps(f, x, y2 - 1)) + static_cast<uint16_t>(ps(f, x, y2 - 2)) +
-                      static_cast<uint16_t>(ps(f, x, y2 - 3))) /
-                     3;
-    }
-    if (h(f) > 2) {
-      ps(f, x, 2) = (static_cast<uint16_t>(ps(f, x, 1)) + static_cast<uint16_t>(ps(f, x, 0))) / 2;
-      ps(f, x, 1) = ps(f, x, 0);
-    }
-
-    // Step 3.  Randomly ignite new 'sparks' of heat near the bottom
     ps(f, x, 0) = f.predictableRandom->GetRandomNumberBetween(kIgnitionMin, kIgnitionMax);
   }
 }
@@ -0,0 +1,137 @@
+#include "jazzlights/effect/grid_kernels.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace jazzlights {
+namespace {
+
+#if JL_GRID_KERNELS_SWAR
+
+constexpr uint32_t kLowBits = 0x01010101;
+constexpr uint32_t kHighBits = 0x80808080;
+constexpr uint32_t kEvenBytes = 0x00FF00FF;
+
+// Expands the high bit of each byte to the whole byte.
+uint32_t ByteMask(uint32_t highBits) { return (highBits >> 7) * 0xFF; }
+
+// Multiplies each byte by multiplier and keeps the high byte of each product. Multiplying bytes 0 and 2 together (and
+// then 1 and 3) cannot carry across lanes since 255 * 256 fits in 16 bits.
+uint32_t Scale8Word(uint32_t word, uint32_t multiplier) {
+  const uint32_t even = (((word & kEvenBytes) * multiplier) >> 8) & kEvenBytes;
+  const uint32_t odd = (((word >> 8) & kEvenBytes) * multiplier) & ~kEvenBytes;
+  return even | odd;
+}
+
+// Per-byte a - b, clamped to zero.
+uint32_t SubtractSaturatingWord(uint32_t a, uint32_t b) {
+  // Subtract the low seven bits of each byte without letting borrows cross bytes, then fix up the high bits.
+  const uint32_t difference = ((a | kHighBits) - (b & ~kHighBits)) ^ ((a ^ ~b) & kHighBits);
+  // A byte borrowed out of its high bit exactly when a < b.
+  const uint32_t borrows = ((~a & b) | (~(a ^ b) & difference)) & kHighBits;
+  return difference & ~ByteMask(borrows);
+}
+
+// Returns 0xFF in each byte of word that differs from the matching byte of value, and 0 elsewhere.
+uint32_t NotEqualMask(uint32_t word, uint32_t value) {
+  const uint32_t bits = word ^ value;
+  return ByteMask((((bits & ~kHighBits) + ~kHighBits) | bits) & kHighBits);
+}
+
+// Replaces each of the count bytes with scalarOp(byte), except for aligned runs of four bytes which go through wordOp
+// instead. wordOp must produce the same result as scalarOp on each byte of its 32-bit argument.
+template <typename ScalarOp, typename WordOp>
+void TransformBytes(uint8_t* cells, size_t count, ScalarOp scalarOp, WordOp wordOp) {
+  for (; count > 0 && reinterpret_cast<uintptr_t>(cells) % sizeof(uint32_t) != 0; cells++, count--) {
+    *cells = scalarOp(*cells);
+  }
+  for (; count >= sizeof(uint32_t); cells += sizeof(uint32_t), count -= sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word, __builtin_assume_aligned(cells, sizeof(uint32_t)), sizeof(word));
+    word = wordOp(word);
+    memcpy(__builtin_assume_aligned(cells, sizeof(uint32_t)), &word, sizeof(word));
+  }
+  for (; count > 0; cells++, count--) { *cells = scalarOp(*cells); }
+}
+
+#endif  // JL_GRID_KERNELS_SWAR
+
+}  // namespace
+
+void GridScale8(uint8_t* cells, size_t count, uint8_t scale) {
+  auto scalarOp = [scale](uint8_t cell) { return scale8(cell, scale); };
+#if JL_GRID_KERNELS_SWAR
+  // FastLED's scale8 multiplies by scale + 1 when FASTLED_SCALE8_FIXED is set, detect which one we have.
+  const uint32_t multiplier = scale8(255, 255) == 255 ? scale + 1u : scale;
+  TransformBytes(cells, count, scalarOp, [multiplier](uint32_t word) { return Scale8Word(word, multiplier); });
+#else   // JL_GRID_KERNELS_SWAR
+  for (size_t i = 0; i < count; i++) { cells[i] = scalarOp(cells[i]); }
+#endif  // JL_GRID_KERNELS_SWAR
+}
+
+void GridScale8(CRGB* cells, size_t count, uint8_t scale) {
+  static_assert(sizeof(CRGB) == 3, "CRGB must be three packed channels");
+  // nscale8 scales each channel independently, so the colors can be processed as a flat array of channels.
+  GridScale8(reinterpret_cast<uint8_t*>(cells), count * sizeof(CRGB), scale);
+}
+
+void GridSubtractSaturating(uint8_t* cells, size_t count, uint8_t amount, uint8_t skip) {
+  auto scalarOp = [amount, skip](uint8_t cell) { return cell == skip ? cell : qsub8(cell, amount); };
+#if JL_GRID_KERNELS_SWAR
+  const uint32_t amounts = amount * kLowBits;
+  const uint32_t skips = skip * kLowBits;
+  TransformBytes(cells, count, scalarOp, [amounts, skips](uint32_t word) {
+    const uint32_t update = NotEqualMask(word, skips);
+    return (SubtractSaturatingWord(word, amounts) & update) | (word & ~update);
+  });
+#else   // JL_GRID_KERNELS_SWAR
+  for (size_t i = 0; i < count; i++) { cells[i] = scalarOp(cells[i]); }
+#endif  // JL_GRID_KERNELS_SWAR
+}
+
+void GridSubtractRandom(uint8_t* cells, size_t count, uint8_t maxAmount, Random* random) {
+  // Drawing the random numbers dominates, so there is nothing to gain from processing multiple cells at once.
+  for (size_t i = 0; i < count; i++) { cells[i] = qsub8(cells[i], random->GetRandomNumberBetween(0, maxAmount)); }
+}
+
+void GridBlurShiftRows(uint8_t* cells, size_t width, size_t height) {
+  if (height < 3) { return; }
+  // Go from the last row backwards so that each row is computed from rows that have not been shifted yet.
+  for (size_t y = height - 1; y >= 3; y--) {
+    uint8_t* row = cells + y * width;
+    const uint8_t* below1 = row - width;
+    const uint8_t* below2 = below1 - width;
+    const uint8_t* below3 = below2 - width;
+    for (size_t x = 0; x < width; x++) {
+      row[x] = (static_cast<uint16_t>(below1[x]) + static_cast<uint16_t>(below2[x]) +
+                static_cast<uint16_t>(below3[x])) /
+               3;
+    }
+  }
+  uint8_t* row2 = cells + 2 * width;
+  uint8_t* row1 = cells + width;
+  for (size_t x = 0; x < width; x++) {
+    row2[x] = (static_cast<uint16_t>(row1[x]) + static_cast<uint16_t>(cells[x])) / 2;
+  }
+  memcpy(row1, cells, width);
+}
+
+void GridShiftMarkers(uint8_t* cells, size_t width, size_t height, uint8_t marker, uint8_t trail) {
+  if (height == 0) { return; }
+  // Markers in the last row fall off the grid.
+  uint8_t* lastRow = cells + (height - 1) * width;
+  for (size_t x = 0; x < width; x++) { lastRow[x] = lastRow[x] == marker ? trail : lastRow[x]; }
+  // Go from the last row backwards so that a marker only moves once. The selects are branchless so that they can be
+  // vectorized.
+  for (size_t y = height - 1; y-- > 0;) {
+    uint8_t* row = cells + y * width;
+    uint8_t* next = row + width;
+    for (size_t x = 0; x < width; x++) {
+      const bool isMarker = row[x] == marker;
+      next[x] = isMarker ? marker : next[x];
+      row[x] = isMarker ? trail : row[x];
+    }
+  }
+}
+
+}  // namespace jazzlights
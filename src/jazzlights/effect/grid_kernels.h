@@ -0,0 +1,48 @@
+#ifndef JL_EFFECT_GRID_KERNELS_H
+#define JL_EFFECT_GRID_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "jazzlights/fastled_wrapper.h"
+#include "jazzlights/pseudorandom.h"
+
+// Xtensa has no SIMD that the compiler can use, so on ESP32 the byte-wise kernels process four cells at a time packed
+// in a 32-bit word. Elsewhere they are plain loops that the compiler auto-vectorizes.
+#ifndef JL_GRID_KERNELS_SWAR
+#ifdef __XTENSA__
+#define JL_GRID_KERNELS_SWAR 1
+#else  // __XTENSA__
+#define JL_GRID_KERNELS_SWAR 0
+#endif  // __XTENSA__
+#endif  // JL_GRID_KERNELS_SWAR
+
+namespace jazzlights {
+
+// Whole-grid passes for XYIndexStateEffect per-pixel state, which is stored row-major: cell (x, y) lives at
+// cells[y * width + x]. These run once per frame over the entire grid, so they avoid per-cell bounds checks and index
+// math. All of them produce exactly the same results as applying the corresponding FastLED function to each cell.
+
+// Applies scale8(cell, scale) to each of the count cells.
+void GridScale8(uint8_t* cells, size_t count, uint8_t scale);
+
+// Applies nscale8(scale) to each of the count colors.
+void GridScale8(CRGB* cells, size_t count, uint8_t scale);
+
+// Applies qsub8(cell, amount) to each of the count cells, except for those equal to skip which are left untouched.
+void GridSubtractSaturating(uint8_t* cells, size_t count, uint8_t amount, uint8_t skip);
+
+// Applies qsub8(cell, random) to each of the count cells in order, where random is drawn from [0, maxAmount].
+void GridSubtractRandom(uint8_t* cells, size_t count, uint8_t maxAmount, Random* random);
+
+// Moves every row one row towards higher y while blurring it vertically: each row y >= 1 becomes the average of the up
+// to three rows that were immediately below it. Row 0 is left untouched, and so are grids with fewer than three rows.
+void GridBlurShiftRows(uint8_t* cells, size_t width, size_t height);
+
+// Moves every cell equal to marker one row towards higher y and leaves trail in its place. Markers in the last row
+// fall off the grid.
+void GridShiftMarkers(uint8_t* cells, size_t width, size_t height, uint8_t marker, uint8_t trail);
+
+}  // namespace jazzlights
+
+#endif  // JL_EFFECT_GRID_KERNELS_H
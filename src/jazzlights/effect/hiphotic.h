@@ -2,6 +2,7 @@
 #define JL_EFFECT_HIPHOTIC_H
 
 #include "jazzlights/effect/effect.h"
+#include "jazzlights/effect/separable_tables.h"
 #include "jazzlights/fastled_wrapper.h"
 #include "jazzlights/palette.h"
 #include "jazzlights/pseudorandom.h"
@@ -22,11 +23,11 @@ struct HiphoticState {
 class Hiphotic : public EffectWithPaletteAndState<HiphoticState> {
  public:
   std::string effectNamePrefix(PatternBits /*pattern*/) const override { return "hiphotic"; }
+  size_t extraContextSize(const Frame& frame) const override { return SeparableTables<uint8_t>::Size(frame); }
   ColorWithPalette innerColor(const Frame& frame, const Pixel& px, HiphoticState* state) const override {
-    const float x = (px.coord.x - frame.viewport.origin.x) / frame.viewport.size.width;
-    const float y = (px.coord.y - frame.viewport.origin.y) / frame.viewport.size.height;
-    return sin8(cos8(x * state->xScale + state->offset / 3) + sin8(y * state->yScale + state->offset / 4) +
-                state->offset);
+    const SeparableTables<uint8_t> tables(frame, state + 1);
+    const XYIndex xyIndex = frame.xyIndexStore->FromPixel(px);
+    return sin8(tables.column(xyIndex) + tables.row(xyIndex) + state->offset);
   }
   void innerBegin(const Frame& frame, HiphoticState* state) const override {
     state->offsetScale = frame.predictableRandom->GetRandomNumberBetween(6, 10);
@@ -35,6 +36,16 @@ class Hiphotic : public EffectWithPaletteAndState<HiphoticState> {
   }
   void innerRewind(const Frame& frame, HiphoticState* state) const override {
     state->offset = frame.time / state->offsetScale;
+    // The x and y terms are independent so we only compute them once per column and once per row.
+    SeparableTables<uint8_t> tables(frame, state + 1);
+    tables.FillColumns([&frame, state](Coord xCoord) -> uint8_t {
+      const float x = (xCoord - frame.viewport.origin.x) / frame.viewport.size.width;
+      return cos8(x * state->xScale + state->offset / 3);
+    });
+    tables.FillRows([&frame, state](Coord yCoord) -> uint8_t {
+      const float y = (yCoord - frame.viewport.origin.y) / frame.viewport.size.height;
+      return sin8(y * state->yScale + state->offset / 4);
+    });
   }
 };
 
@@ -0,0 +1,167 @@
+#ifndef JL_EFFECT_LINE_RASTER_H
+#define JL_EFFECT_LINE_RASTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "jazzlights/fastled_wrapper.h"
+
+namespace jazzlights {
+
+// Line rasterizers for XY grids such as the per-pixel state of XYIndexStateEffect. Lines are clipped to the grid in
+// constant time along their major axis, so drawing a line costs one step per cell of the line within the grid's extent
+// on that axis, regardless of the area of the grid.
+
+// Returns the index of the last cell of the line from (x0, y0) to (x1, y1), where cell 0 is (x0, y0).
+inline int LineSteps(int x0, int y0, int x1, int y1) {
+  const int dx = std::abs(x1 - x0);
+  const int dy = std::abs(y1 - y0);
+  return dx > dy ? dx : dy;
+}
+
+// Used by the rasterizers below. Describes a line in terms of its major axis, along which it moves by one cell per
+// step, and its minor axis, and computes which steps are within the grid along the major axis.
+struct LineAxes {
+  LineAxes(int x0, int y0, int x1, int y1, int width, int height) {
+    const int dx = std::abs(x1 - x0);
+    const int dy = std::abs(y1 - y0);
+    xMajor = dx >= dy;
+    majorStart = xMajor ? x0 : y0;
+    minorStart = xMajor ? y0 : x0;
+    majorDelta = xMajor ? dx : dy;
+    minorDelta = xMajor ? dy : dx;
+    majorSign = (xMajor ? x1 >= x0 : y1 >= y0) ? 1 : -1;
+    minorSign = (xMajor ? y1 >= y0 : x1 >= x0) ? 1 : -1;
+    majorLimit = xMajor ? width : height;
+    minorLimit = xMajor ? height : width;
+    // Only keep the steps whose major coordinate is on the grid.
+    if (majorSign > 0) {
+      firstStep = -majorStart;
+      lastStep = majorLimit - 1 - majorStart;
+    } else {
+      firstStep = majorStart - (majorLimit - 1);
+      lastStep = majorStart;
+    }
+    if (firstStep < 0) { firstStep = 0; }
+    if (lastStep > majorDelta) { lastStep = majorDelta; }
+  }
+
+  bool xMajor;
+  int majorStart;
+  int minorStart;
+  int majorDelta;
+  int minorDelta;
+  int majorSign;
+  int minorSign;
+  int majorLimit;
+  int minorLimit;
+  int firstStep;
+  int lastStep;
+};
+
+// Calls visit(x, y, step) for each cell of the line from (x0, y0) to (x1, y1) that lies within [0, width) x
+// [0, height), in order from step 0 at (x0, y0) to step LineSteps() at (x1, y1). Uses Bresenham's algorithm with ties
+// rounded away from the start, so each step moves exactly one cell along the longer axis.
+template <typename Visit>
+void RasterizeLine(int x0, int y0, int x1, int y1, int width, int height, Visit visit) {
+  const LineAxes line(x0, y0, x1, y1, width, height);
+  if (line.firstStep > line.lastStep) { return; }
+  // The minor offset at step k is floor((2 * k * minorDelta + majorDelta) / (2 * majorDelta)). Compute it directly for
+  // the first visible step, then track the remainder incrementally. The remainder stays below 2 * majorDelta, so only
+  // the initial product needs 64 bits.
+  const int denominator = 2 * line.majorDelta;
+  const int64_t initialNumerator = 2 * static_cast<int64_t>(line.firstStep) * line.minorDelta + line.majorDelta;
+  int minor = line.minorStart;
+  int numerator = 0;
+  if (denominator > 0) {
+    minor += line.minorSign * static_cast<int>(initialNumerator / denominator);
+    numerator = static_cast<int>(initialNumerator % denominator);
+  }
+  int major = line.majorStart + line.majorSign * line.firstStep;
+  const int minorIncrement = 2 * line.minorDelta;
+  // Skip the steps before the line enters the grid along the minor axis, then draw until it leaves.
+  int step = line.firstStep;
+  for (; step <= line.lastStep && (minor < 0 || minor >= line.minorLimit); step++) {
+    major += line.majorSign;
+    numerator += minorIncrement;
+    if (numerator >= denominator) {
+      numerator -= denominator;
+      minor += line.minorSign;
+    }
+  }
+  for (; step <= line.lastStep && minor >= 0 && minor < line.minorLimit; step++) {
+    if (line.xMajor) {
+      visit(major, minor, step);
+    } else {
+      visit(minor, major, step);
+    }
+    major += line.majorSign;
+    numerator += minorIncrement;
+    if (numerator >= denominator) {
+      numerator -= denominator;
+      minor += line.minorSign;
+    }
+  }
+}
+
+// Calls visit(x, y, step, coverage) for the cells of an anti-aliased line from (x0, y0) to (x1, y1), clipped to
+// [0, width) x [0, height). Uses Xiaolin Wu's algorithm: each step covers the two cells that straddle the ideal line
+// along the minor axis, and their coverages add up to 255.
+template <typename Visit>
+void RasterizeLineAntialiased(int x0, int y0, int x1, int y1, int width, int height, Visit visit) {
+  const LineAxes line(x0, y0, x1, y1, width, height);
+  if (line.firstStep > line.lastStep) { return; }
+  // Minor position in 16.16 fixed point.
+  const int64_t gradient =
+      line.majorDelta > 0 ? (static_cast<int64_t>(line.minorSign * line.minorDelta) << 16) / line.majorDelta : 0;
+  int64_t position = (static_cast<int64_t>(line.minorStart) << 16) + gradient * line.firstStep;
+  int major = line.majorStart + line.majorSign * line.firstStep;
+  auto visitCell = [&](int minor, int step, uint8_t coverage) {
+    if (coverage == 0 || minor < 0 || minor >= line.minorLimit) { return; }
+    if (line.xMajor) {
+      visit(major, minor, step, coverage);
+    } else {
+      visit(minor, major, step, coverage);
+    }
+  };
+  for (int step = line.firstStep; step <= line.lastStep; step++, major += line.majorSign, position += gradient) {
+    const int minor = static_cast<int>(position >> 16);
+    const uint8_t fraction = static_cast<uint8_t>((position >> 8) & 0xFF);
+    visitCell(minor, step, 255 - fraction);
+    visitCell(minor + 1, step, fraction);
+  }
+}
+
+// Adds color to each cell of the line in a row-major grid of colors, clipped to the grid. With gradient, each cell is
+// then dimmed in proportion to how far along the line it is, so the line fades in from its start. The start cell itself
+// is skipped in that case since it would be fully dimmed.
+inline void DrawLine(CRGB* cells, int width, int height, int x0, int y0, int x1, int y1, CRGB color, bool gradient) {
+  const int steps = LineSteps(x0, y0, x1, y1);
+  RasterizeLine(x0, y0, x1, y1, width, height, [&](int x, int y, int step) {
+    CRGB& cell = cells[y * width + x];
+    if (!gradient || steps == 0) {
+      cell += color;
+      return;
+    }
+    if (step == 0) { return; }
+    cell += color;
+    cell %= static_cast<uint8_t>(step * 255 / steps);
+  });
+}
+
+// Anti-aliased version of DrawLine(), each cell gets color scaled by its coverage.
+inline void DrawLineAntialiased(CRGB* cells, int width, int height, int x0, int y0, int x1, int y1, CRGB color,
+                                bool gradient) {
+  const int steps = LineSteps(x0, y0, x1, y1);
+  RasterizeLineAntialiased(x0, y0, x1, y1, width, height, [&](int x, int y, int step, uint8_t coverage) {
+    CRGB scaled = color;
+    scaled.nscale8_video(coverage);
+    if (gradient && steps > 0) { scaled.nscale8_video(static_cast<uint8_t>(step * 255 / steps)); }
+    cells[y * width + x] += scaled;
+  });
+}
+
+}  // namespace jazzlights
+
+#endif  // JL_EFFECT_LINE_RASTER_H
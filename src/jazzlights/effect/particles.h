@@ -0,0 +1,251 @@
+#ifndef JL_EFFECT_PARTICLES_H
+#define JL_EFFECT_PARTICLES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "jazzlights/frame.h"
+#include "jazzlights/pseudorandom.h"
+#include "jazzlights/util/geom.h"
+#include "jazzlights/util/time.h"
+
+namespace jazzlights {
+
+// Fixed-size pool of particles for effects that draw many small moving things. Particles are stored as one array per
+// field and the pool is trivially destructible, so it can be part of an effect's state in the frame context. Particles
+// move in a straight line from where they spawned, so their position only depends on the time, not on the frame rate.
+// Update() bins them into a grid of cells at least as wide as the radius of a particle, which lets ForEachNear() only
+// look at the cells around a pixel: the cost per pixel depends on how dense the particles are, not how many there are.
+template <size_t kCapacity, size_t kMaxCells = 256>
+class ParticlePool {
+ public:
+  static_assert(kCapacity <= UINT16_MAX && kMaxCells < UINT16_MAX, "ParticlePool indices are 16 bits");
+
+  // Call from begin(). Particles only affect pixels within radius of them.
+  void Reset(const Box& viewport, Coord radius) {
+    count_ = 0;
+    radius_ = std::max(radius, 1e-6);
+    originX_ = left(viewport);
+    originY_ = top(viewport);
+    cellSize_ = std::max<Coord>(radius_, std::sqrt(width(viewport) * height(viewport) / kMaxCells));
+    while (true) {
+      columns_ = static_cast<size_t>(width(viewport) / cellSize_) + 1;
+      rows_ = static_cast<size_t>(height(viewport) / cellSize_) + 1;
+      if (columns_ * rows_ <= kMaxCells) { break; }
+      cellSize_ *= 1.25;
+    }
+    std::fill(cellStarts_, cellStarts_ + columns_ * rows_ + 1, 0);
+  }
+
+  // Adds a particle that is at position at time birth and dies at birth + lifetime. Velocity is in units per second.
+  // When the pool is full, this first removes the particles that died by birth, and returns false if none did. The
+  // particle is not visible to ForEachNear() until the next Update().
+  bool Spawn(Point position, Point velocity, Milliseconds birth, Milliseconds lifetime, uint8_t hue) {
+    if (count_ >= kCapacity) {
+      for (size_t i = 0; i < count_;) {
+        if (birth - birth_[i] >= lifetime_[i]) {
+          Remove(i);
+        } else {
+          i++;
+        }
+      }
+      if (count_ >= kCapacity) { return false; }
+    }
+    startX_[count_] = position.x;
+    startY_[count_] = position.y;
+    velocityX_[count_] = velocity.x / static_cast<Coord>(ONE_SECOND);
+    velocityY_[count_] = velocity.y / static_cast<Coord>(ONE_SECOND);
+    birth_[count_] = birth;
+    lifetime_[count_] = std::max<Milliseconds>(lifetime, 1);
+    hue_[count_] = hue;
+    count_++;
+    return true;
+  }
+
+  // Call from rewind(). Moves the particles to where they are at time, removes the ones that died and rebins the rest.
+  void Update(Milliseconds time) {
+    for (size_t i = 0; i < count_;) {
+      const Milliseconds age = time - birth_[i];
+      if (age >= lifetime_[i]) {
+        Remove(i);
+        continue;
+      }
+      x_[i] = startX_[i] + velocityX_[i] * age;
+      y_[i] = startY_[i] + velocityY_[i] * age;
+      progress_[i] = std::max(static_cast<float>(age) / lifetime_[i], 0.0f);
+      i++;
+    }
+    // Counting sort of the particles by cell.
+    const size_t cellCount = columns_ * rows_;
+    std::fill(cellStarts_, cellStarts_ + cellCount + 1, 0);
+    for (size_t i = 0; i < count_; i++) {
+      cell_[i] = CellFor(y_[i], originY_, rows_) * columns_ + CellFor(x_[i], originX_, columns_);
+      cellStarts_[cell_[i] + 1]++;
+    }
+    for (size_t cell = 0; cell < cellCount; cell++) { cellStarts_[cell + 1] += cellStarts_[cell]; }
+    uint16_t nextInCell[kMaxCells];
+    std::copy(cellStarts_, cellStarts_ + cellCount, nextInCell);
+    for (size_t i = 0; i < count_; i++) { binned_[nextInCell[cell_[i]]++] = i; }
+  }
+
+  // Calls callback(i, distanceSquared) for every particle within radius of point.
+  template <typename Callback>
+  void ForEachNear(Point point, Callback callback) const {
+    if (count_ == 0 || IsEmpty(point)) { return; }
+    const float px = point.x;
+    const float py = point.y;
+    const float radiusSquared = radius_ * radius_;
+    const size_t firstColumn = CellFor(px - radius_, originX_, columns_);
+    const size_t lastColumn = CellFor(px + radius_, originX_, columns_);
+    const size_t lastRow = CellFor(py + radius_, originY_, rows_);
+    for (size_t row = CellFor(py - radius_, originY_, rows_); row <= lastRow; row++) {
+      const uint16_t end = cellStarts_[row * columns_ + lastColumn + 1];
+      for (uint16_t b = cellStarts_[row * columns_ + firstColumn]; b < end; b++) {
+        const uint16_t i = binned_[b];
+        const float dx = x_[i] - px;
+        const float dy = y_[i] - py;
+        const float distanceSquared = dx * dx + dy * dy;
+        if (distanceSquared <= radiusSquared) { callback(i, distanceSquared); }
+      }
+    }
+  }
+
+  size_t count() const { return count_; }
+  Coord radius() const { return radius_; }
+  // These describe particle i as of the last Update().
+  Point position(size_t i) const { return {x_[i], y_[i]}; }
+  // How far the particle is through its lifetime, in [0, 1).
+  float progress(size_t i) const { return progress_[i]; }
+  uint8_t hue(size_t i) const { return hue_[i]; }
+
+ private:
+  size_t CellFor(float v, float origin, size_t count) const {
+    const float cell = std::floor((v - origin) / cellSize_);
+    if (!(cell > 0)) { return 0; }
+    if (cell >= count) { return count - 1; }
+    return static_cast<size_t>(cell);
+  }
+
+  // Moves the last particle into slot i.
+  void Remove(size_t i) {
+    count_--;
+    startX_[i] = startX_[count_];
+    startY_[i] = startY_[count_];
+    velocityX_[i] = velocityX_[count_];
+    velocityY_[i] = velocityY_[count_];
+    birth_[i] = birth_[count_];
+    lifetime_[i] = lifetime_[count_];
+    hue_[i] = hue_[count_];
+  }
+
+  size_t count_;
+  float radius_;
+  float originX_;
+  float originY_;
+  float cellSize_;
+  size_t columns_;
+  size_t rows_;
+  float startX_[kCapacity];
+  float startY_[kCapacity];
+  float velocityX_[kCapacity];  // Units per millisecond.
+  float velocityY_[kCapacity];
+  Milliseconds birth_[kCapacity];
+  Milliseconds lifetime_[kCapacity];
+  uint8_t hue_[kCapacity];
+  // Computed by Update().
+  float x_[kCapacity];
+  float y_[kCapacity];
+  float progress_[kCapacity];
+  uint16_t cell_[kCapacity];
+  // Particles sorted by cell. Those in cell c are binned_[cellStarts_[c]] to binned_[cellStarts_[c + 1] - 1].
+  uint16_t binned_[kCapacity];
+  uint16_t cellStarts_[kMaxCells + 1];
+};
+
+struct ParticleEmitterParams {
+  // Particles spawn at a uniformly random spot within spread of position.
+  Point position;
+  Coord spread;
+  // Particles move in a uniformly random direction at a speed between these, in units per second.
+  Coord minSpeed;
+  Coord maxSpeed;
+  Milliseconds minLifetime;
+  Milliseconds maxLifetime;
+  // Time between two particles.
+  Milliseconds interval;
+  // Particles get a hue between hue and hue + hueSpread.
+  uint8_t hue;
+  uint8_t hueSpread;
+};
+
+// Spawns particles into a ParticlePool at a steady rate. The Player reseeds frame.predictableRandom from the frame time
+// before each rewind(), so drawing from it there would make particles depend on when frames happen to be rendered.
+// Instead Begin() takes one seed from it, and each particle is picked from that seed and the particle's sequence
+// number. Devices that follow the same pattern therefore spawn the same particles whatever their frame rate. That
+// holds even once the pool is full: particles are spawned in order of birth and Spawn() frees the slots of those that
+// died before each birth, so the same particles get dropped as if each one had been spawned right when it was born.
+class ParticleEmitter {
+ public:
+  // Call from begin().
+  void Begin(const Frame& frame, const ParticleEmitterParams& params) {
+    params_ = params;
+    params_.interval = std::max<Milliseconds>(params_.interval, 1);
+    seed_ = frame.predictableRandom->GetRandom32bits();
+    emitted_ = 0;
+    dropped_ = 0;
+  }
+
+  // Call from rewind() before pool->Update(time). Spawns the particles that were due by time.
+  template <size_t kCapacity, size_t kMaxCells>
+  void Emit(Milliseconds time, ParticlePool<kCapacity, kMaxCells>* pool) {
+    if (time < 0) { return; }
+    // Skip the particles that would already be dead, for example after a jump forward in time.
+    const Milliseconds firstAlive = time - params_.maxLifetime;
+    if (firstAlive > 0) { emitted_ = std::max<uint32_t>(emitted_, firstAlive / params_.interval); }
+    for (; static_cast<Milliseconds>(emitted_) <= time / params_.interval; emitted_++) {
+      const Milliseconds birth = emitted_ * params_.interval;
+      const Milliseconds lifetime =
+          params_.minLifetime + static_cast<Milliseconds>((params_.maxLifetime - params_.minLifetime) * Random(5));
+      // Frames further apart than the lifetime would otherwise fill the pool with particles Update() then removes.
+      if (birth + lifetime <= time) { continue; }
+      const float angle = Random(1) * 2 * static_cast<float>(M_PI);
+      const float offset = params_.spread * std::sqrt(Random(2));
+      const float offsetAngle = Random(3) * 2 * static_cast<float>(M_PI);
+      const float speed = params_.minSpeed + (params_.maxSpeed - params_.minSpeed) * Random(4);
+      const uint8_t hue = params_.hue + static_cast<uint8_t>((params_.hueSpread + 1) * Random(6));
+      const Point position = {params_.position.x + offset * std::cos(offsetAngle),
+                              params_.position.y + offset * std::sin(offsetAngle)};
+      if (!pool->Spawn(position, {speed * std::cos(angle), speed * std::sin(angle)}, birth, lifetime, hue)) {
+        dropped_++;
+      }
+    }
+  }
+
+  const ParticleEmitterParams& params() const { return params_; }
+  // Number of particles since Begin() that did not fit in the pool.
+  uint32_t dropped() const { return dropped_; }
+
+ private:
+  // Returns a value in [0, 1) that only depends on seed_, emitted_ and field.
+  float Random(uint32_t field) const {
+    // Finalizer of MurmurHash3.
+    uint32_t h = seed_ ^ (emitted_ * 0x9E3779B9u) ^ (field * 0x85EBCA77u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return (h >> 8) / static_cast<float>(1 << 24);
+  }
+
+  ParticleEmitterParams params_;
+  uint32_t seed_;
+  uint32_t emitted_;
+  uint32_t dropped_;
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_EFFECT_PARTICLES_H
@@ -0,0 +1,33 @@
+#include "jazzlights/effect/pixel_field.h"
+
+#include <cmath>
+
+namespace jazzlights {
+namespace {
+
+double PixelFieldValue(const Frame& frame, PixelFieldType type, Point origin, Point p) {
+  switch (type) {
+    case PixelFieldType::kDistance: return distance(p, origin);
+    case PixelFieldType::kAngle: return atan2(p.y - origin.y, p.x - origin.x);
+    case PixelFieldType::kNormalizedX:
+      if (frame.viewport.size.width <= 0) { return 0; }
+      return (p.x - frame.viewport.origin.x) / frame.viewport.size.width;
+    case PixelFieldType::kNormalizedY:
+      if (frame.viewport.size.height <= 0) { return 0; }
+      return (p.y - frame.viewport.origin.y) / frame.viewport.size.height;
+  }
+  return 0;
+}
+
+}  // namespace
+
+void ComputePixelField(const Frame& frame, PixelFieldType type, Point origin, double scale, float* field) {
+  size_t visited = ForEachPixel(frame, [&](size_t cumulativeIndex, const Strand& /*strand*/, Point p) {
+    const double value = IsEmpty(p) ? 0.0 : PixelFieldValue(frame, type, origin, p) * scale;
+    field[cumulativeIndex] = static_cast<float>(value);
+  });
+  // Keep the field fully initialized even if we were not given the strands.
+  for (; visited < frame.pixelCount; visited++) { field[visited] = 0.0f; }
+}
+
+}  // namespace jazzlights
@@ -0,0 +1,49 @@
+#ifndef JL_EFFECT_PIXEL_FIELD_H
+#define JL_EFFECT_PIXEL_FIELD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "jazzlights/frame.h"
+#include "jazzlights/layout/layout.h"
+#include "jazzlights/util/geom.h"
+
+namespace jazzlights {
+
+// A pixel field is a per-pixel value that only depends on the position of the pixel and on parameters that the effect
+// picks in begin(). Effects compute it once into their context when the pattern begins, and then read it by cumulative
+// pixel index in color() instead of recomputing it for every pixel of every frame.
+enum class PixelFieldType : uint8_t {
+  kDistance,     // Distance from the origin.
+  kAngle,        // Angle around the origin in radians, in [-pi, pi].
+  kNormalizedX,  // Position along the viewport width, in [0, 1]. The origin is ignored.
+  kNormalizedY,  // Position along the viewport height, in [0, 1]. The origin is ignored.
+};
+
+// Calls callback(cumulativeIndex, strand, coord) for the first frame.pixelCount pixels of the frame's strands, in
+// cumulative index order and including pixels with empty coordinates. Returns the number of pixels visited, which is
+// less than frame.pixelCount when the frame has no strands.
+template <typename Callback>
+size_t ForEachPixel(const Frame& frame, Callback callback) {
+  if (frame.strands == nullptr) { return 0; }
+  size_t cumulativeIndex = 0;
+  for (const Strand& s : *frame.strands) {
+    const size_t numPixels = s.layout.pixelCount();
+    for (size_t index = 0; index < numPixels && cumulativeIndex < frame.pixelCount; index++) {
+      callback(cumulativeIndex, s, s.layout.at(index));
+      cumulativeIndex++;
+    }
+  }
+  return cumulativeIndex;
+}
+
+// Number of bytes of effect context needed to hold a pixel field.
+inline size_t PixelFieldSize(const Frame& frame) { return sizeof(float) * frame.pixelCount; }
+
+// Fills field, which must hold PixelFieldSize(frame) bytes, with the value of type for each pixel multiplied by scale.
+// Pixels with empty coordinates are set to zero.
+void ComputePixelField(const Frame& frame, PixelFieldType type, Point origin, double scale, float* field);
+
+}  // namespace jazzlights
+
+#endif  // JL_EFFECT_PIXEL_FIELD_H
@@ -2,6 +2,7 @@
 #define JL_EFFECT_PLASMA_H
 
 #include "jazzlights/effect/effect.h"
+#include "jazzlights/effect/separable_tables.h"
 #include "jazzlights/fastled_wrapper.h"
 #include "jazzlights/palette.h"
 #include "jazzlights/util/geom.h"
@@ -23,9 +24,11 @@ struct SpinPlasmaState {
 class SpinPlasma : public EffectWithPaletteAndState<SpinPlasmaState> {
  public:
   std::string effectNamePrefix(PatternBits /*pattern*/) const override { return "sp"; }
-  ColorWithPalette innerColor(const Frame& /*frame*/, const Pixel& px, SpinPlasmaState* state) const override {
-    return sin8(sqrt(square((static_cast<float>(px.coord.x) - state->plasmaCenterX) * state->xMultiplier) +
-                     square((static_cast<float>(px.coord.y) - state->plasmaCenterY) * state->yMultiplier)));
+  size_t extraContextSize(const Frame& frame) const override { return SeparableTables<float>::Size(frame); }
+  ColorWithPalette innerColor(const Frame& frame, const Pixel& px, SpinPlasmaState* state) const override {
+    const SeparableTables<float> tables(frame, state + 1);
+    const XYIndex xyIndex = frame.xyIndexStore->FromPixel(px);
+    return sin8(sqrt(tables.column(xyIndex) + tables.row(xyIndex)));
   }
   void innerBegin(const Frame& frame, SpinPlasmaState* state) const override {
     const float multiplier = frame.predictableRandom->GetRandomNumberBetween(100, 500);
@@ -42,6 +45,14 @@ class SpinPlasma : public EffectWithPaletteAndState<SpinPlasmaState> {
         state->rotationCenterX + (static_cast<float>(cos8(offset)) - 127.0) / (state->xMultiplier * 2.0);
     state->plasmaCenterY =
         state->rotationCenterY + (static_cast<float>(sin8(offset)) - 127.0) / (state->yMultiplier * 2.0);
+    // Precompute the squared x and y distances to the plasma center once per column and once per row.
+    SeparableTables<float> tables(frame, state + 1);
+    tables.FillColumns([state](Coord x) -> float {
+      return square((static_cast<float>(x) - state->plasmaCenterX) * state->xMultiplier);
+    });
+    tables.FillRows([state](Coord y) -> float {
+      return square((static_cast<float>(y) - state->plasmaCenterY) * state->yMultiplier);
+    });
   }
 };
 
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 
+#include "jazzlights/effect/pixel_field.h"
 #include "jazzlights/palette.h"
 
 namespace jazzlights {
@@ -21,6 +22,8 @@ class Rings : public EffectWithPaletteAndState<RingsState> {
 
   std::string effectNamePrefix(PatternBits /*pattern*/) const override { return "rings"; }
 
+  size_t extraContextSize(const Frame& frame) const override { return PixelFieldSize(frame); }
+
   void innerBegin(const Frame& frame, RingsState* state) const override {
     new (state) RingsState;  // Default-initialize the state.
     state->startHue = frame.predictableRandom->GetRandomByte();
@@ -35,6 +38,8 @@ class Rings : public EffectWithPaletteAndState<RingsState> {
         distance(state->origin, rightbottom(frame)),
     });
     state->backwards = frame.predictableRandom->GetRandomByte() & 1;
+    // The origin does not move, so each pixel's hue offset can be computed once here instead of on every frame.
+    ComputePixelField(frame, PixelFieldType::kDistance, state->origin, 255 / state->maxDistance, hueOffsets(state));
   }
 
   void innerRewind(const Frame& frame, RingsState* state) const override {
@@ -46,9 +51,11 @@ class Rings : public EffectWithPaletteAndState<RingsState> {
   }
 
   ColorWithPalette innerColor(const Frame& /*frame*/, const Pixel& px, RingsState* state) const override {
-    const double d = distance(px.coord, state->origin);
-    return (state->initialHue + int32_t(255 * d / state->maxDistance)) % 255;
+    return (state->initialHue + int32_t(hueOffsets(state)[px.cumulativeIndex])) % 255;
   }
+
+ private:
+  float* hueOffsets(RingsState* state) const { return reinterpret_cast<float*>(state + 1); }
 };
 
 }  // namespace jazzlights
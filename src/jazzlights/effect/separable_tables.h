@@ -0,0 +1,55 @@
+#ifndef JL_EFFECT_SEPARABLE_TABLES_H
+#define JL_EFFECT_SEPARABLE_TABLES_H
+
+#include <cstddef>
+#include <type_traits>
+
+#include "jazzlights/frame.h"
+#include "jazzlights/types.h"
+
+namespace jazzlights {
+
+// Per-frame lookup tables for effects whose per-pixel value combines a term that only depends on x with a term that
+// only depends on y. The effect fills one entry per grid column and per grid row in rewind(), so that color() only
+// needs two loads instead of evaluating both terms for every pixel. The tables live in the effect context, which must
+// hold Size(frame) bytes.
+template <typename T>
+class SeparableTables {
+  static_assert(std::is_trivially_destructible<T>::value, "T must be trivially destructible");
+
+ public:
+  static size_t Size(const Frame& frame) {
+    return sizeof(T) * (frame.xyIndexStore->xValuesCount() + frame.xyIndexStore->yValuesCount());
+  }
+
+  SeparableTables(const Frame& frame, void* memory)
+      : xyIndexStore_(frame.xyIndexStore),
+        columns_(static_cast<T*>(memory)),
+        rows_(columns_ + frame.xyIndexStore->xValuesCount()) {}
+
+  // Sets each column entry to xFunction(x) where x is the coordinate of that column.
+  template <typename F>
+  void FillColumns(F xFunction) {
+    const size_t count = xyIndexStore_->xValuesCount();
+    for (size_t xIndex = 0; xIndex < count; xIndex++) { columns_[xIndex] = xFunction(xyIndexStore_->xValue(xIndex)); }
+  }
+
+  // Sets each row entry to yFunction(y) where y is the coordinate of that row.
+  template <typename F>
+  void FillRows(F yFunction) {
+    const size_t count = xyIndexStore_->yValuesCount();
+    for (size_t yIndex = 0; yIndex < count; yIndex++) { rows_[yIndex] = yFunction(xyIndexStore_->yValue(yIndex)); }
+  }
+
+  T column(const XYIndex& xyIndex) const { return columns_[xyIndex.xIndex]; }
+  T row(const XYIndex& xyIndex) const { return rows_[xyIndex.yIndex]; }
+
+ private:
+  const XYIndexStore* xyIndexStore_;
+  T* columns_;
+  T* rows_;
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_EFFECT_SEPARABLE_TABLES_H
@@ -2,9 +2,12 @@
 
 #if JL_AUDIO_VISUALIZER
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
+#include "jazzlights/effect/pixel_field.h"
+
 namespace jazzlights {
 namespace {
 const TProgmemRGBPalette16* SoundReactivePaletteFromOurColorPalette(OurColorPalette ocp) {
@@ -112,9 +115,65 @@ const TProgmemRGBPalette16* SoundReactivePaletteFromOurColorPalette(OurColorPale
 CRGB ColorFromSoundReactivePalette(OurColorPalette ocp, uint8_t color) {
   return ColorFromPalette(*SoundReactivePaletteFromOurColorPalette(ocp), color);
 }
+
+SoundPixelMapping ComputePixelMapping(const Frame& frame, Point coord, size_t strandIndex, OurColorPalette ocp,
+                                      CRGB brightestColor) {
+  SoundPixelMapping mapping;
+  // Map horizontal position to regions: Bass (0-20%), Mids (20-70%), Highs (70-100%)
+  // Vary the regions slightly per strand
+  double xOffset = (static_cast<double>(strandIndex % 3) - 1.0) * 0.05;
+  double xRel = (coord.x - frame.viewport.origin.x) / frame.viewport.size.width + xOffset;
+  if (xRel < 0) xRel = 0;
+  if (xRel > 0.999) xRel = 0.999;
+
+  double xBand;
+  int bandMax;
+  if (xRel < 0.2) {
+    // Bass Region (0-20%): Bands 0-3
+    double bassRel = xRel / 0.2;
+    xBand = bassRel * 3.0;
+    bandMax = 3;
+    mapping.baseColor = brightestColor;
+  } else if (xRel < 0.7) {
+    // Mids Region (20-70%): Bands 4-19
+    double midsRel = (xRel - 0.2) / 0.5;
+    xBand = 4.0 + midsRel * 15.0;
+    bandMax = 19;
+    // Vary the color index per strand
+    uint8_t colorIdx = static_cast<uint8_t>(midsRel * 170.0) + (strandIndex * 16);
+    mapping.baseColor = ColorFromSoundReactivePalette(ocp, colorIdx);
+  } else {
+    // Highs Region (70-100%): Bands 20-31
+    double highsRel = (xRel - 0.7) / 0.3;
+    xBand = 20.0 + highsRel * 11.0;
+    bandMax = 31;
+    // Vary the color index per strand
+    uint8_t colorIdx = 171 + static_cast<uint8_t>(highsRel * 84.0) + (strandIndex * 16);
+    mapping.baseColor = ColorFromSoundReactivePalette(ocp, colorIdx);
+  }
+  int bandLow = static_cast<int>(xBand);
+  double frac = xBand - bandLow;
+  if (bandLow >= bandMax) {
+    bandLow = bandMax - 1;
+    frac = 1.0;
+  }
+  mapping.bandLow = bandLow;
+  mapping.frac = static_cast<uint8_t>(std::min(frac * 256.0, 255.0));
+
+  // Center-out vertical position (0 at center, 1 at edges)
+  // Vary the center slightly per strand
+  double yOffset = (static_cast<double>(strandIndex % 5) - 2.0) * 0.1 * frame.viewport.size.height;
+  double centerY = frame.viewport.origin.y + frame.viewport.size.height / 2.0 + yOffset;
+  double yRel = 2.0 * fabs(coord.y - centerY) / frame.viewport.size.height;
+  if (yRel > 1.0) yRel = 1.0;
+  mapping.yRel = static_cast<uint8_t>(lround(yRel * 255.0));
+  return mapping;
+}
 }  // namespace
 
-size_t SoundEffect::extraContextSize(const Frame& frame) const { return sizeof(CRGB) * frame.pixelCount; }
+size_t SoundEffect::extraContextSize(const Frame& frame) const {
+  return (sizeof(SoundPixelMapping) + sizeof(CRGB)) * frame.pixelCount;
+}
 
 void SoundEffect::innerBegin(const Frame& frame, SoundState* state) const {
   Audio::Get().GetVisualizerData(&state->audioData);
@@ -161,7 +220,14 @@ void SoundEffect::innerBegin(const Frame& frame, SoundState* state) const {
 #endif
 
   // Initialize per-pixel state
-  memset(lastColors(state), 0, sizeof(CRGB) * frame.pixelCount);
+  SoundPixelMapping* mappings = pixelMappings(state);
+  std::fill_n(mappings, frame.pixelCount, SoundPixelMapping());
+  ForEachPixel(frame, [&](size_t cumulativeIndex, const Strand& strand, Point coord) {
+    if (!IsEmpty(coord)) {
+      mappings[cumulativeIndex] = ComputePixelMapping(frame, coord, strand.index, ocp, state->brightestColor);
+    }
+  });
+  memset(lastColors(frame, state), 0, sizeof(CRGB) * frame.pixelCount);
 }
 
 void SoundEffect::innerRewind(const Frame& /*frame*/, SoundState* state) const {
@@ -179,64 +245,20 @@ void SoundEffect::innerRewind(const Frame& /*frame*/, SoundState* state) const {
 ColorWithPalette SoundEffect::innerColor(const Frame& frame, const Pixel& px, SoundState* state) const {
   // Squelch: Turn off LEDs if the overall volume is very low
   if (state->isSquelched) {
-    CRGB* prevColors = lastColors(state);
+    CRGB* prevColors = lastColors(frame, state);
     prevColors[px.cumulativeIndex] = CRGB::Black;
     return ColorWithPalette::OverrideColor(CRGB::Black);
   }
 
-  CRGB color = CRGB::Black;
+  const SoundPixelMapping& mapping = pixelMappings(state)[px.cumulativeIndex];
+  CRGB color = mapping.baseColor;
   float normalizedMag = 0;
   float transient = 0;
-
-  // Map horizontal position to regions: Bass (0-20%), Mids (20-70%), Highs (70-100%)
-  // Vary the regions slightly per strand
-  double xOffset = (static_cast<double>(px.strand->index % 3) - 1.0) * 0.05;
-  double xRel = (px.coord.x - frame.viewport.origin.x) / frame.viewport.size.width + xOffset;
-  if (xRel < 0) xRel = 0;
-  if (xRel > 0.999) xRel = 0.999;
-
-  float magnitude = 0;
-  float prevMagnitude = 0;
-  OurColorPalette ocp = palette(frame);
-
-  if (xRel < 0.2) {
-    // Bass Region (0-20%): Bands 0-3
-    double bassRel = xRel / 0.2;
-    double xBand = bassRel * 3.0;
-    int bandLow = static_cast<int>(xBand);
-    int bandHigh = bandLow + 1;
-    if (bandHigh > 3) bandHigh = 3;
-    float frac = xBand - bandLow;
-    magnitude = state->audioData.bands[bandLow] * (1.0f - frac) + state->audioData.bands[bandHigh] * frac;
-    prevMagnitude = state->prevBands[bandLow] * (1.0f - frac) + state->prevBands[bandHigh] * frac;
-    color = state->brightestColor;
-  } else if (xRel < 0.7) {
-    // Mids Region (20-70%): Bands 4-19
-    double midsRel = (xRel - 0.2) / 0.5;
-    double xBand = 4.0 + midsRel * 15.0;
-    int bandLow = static_cast<int>(xBand);
-    int bandHigh = bandLow + 1;
-    if (bandHigh > 19) bandHigh = 19;
-    float frac = xBand - bandLow;
-    magnitude = state->audioData.bands[bandLow] * (1.0f - frac) + state->audioData.bands[bandHigh] * frac;
-    prevMagnitude = state->prevBands[bandLow] * (1.0f - frac) + state->prevBands[bandHigh] * frac;
-    // Vary the color index per strand
-    uint8_t colorIdx = static_cast<uint8_t>(midsRel * 170.0) + (px.strand->index * 16);
-    color = ColorFromSoundReactivePalette(ocp, colorIdx);
-  } else {
-    // Highs Region (70-100%): Bands 20-31
-    double highsRel = (xRel - 0.7) / 0.3;
-    double xBand = 20.0 + highsRel * 11.0;
-    int bandLow = static_cast<int>(xBand);
-    int bandHigh = bandLow + 1;
-    if (bandHigh > 31) bandHigh = 31;
-    float frac = xBand - bandLow;
-    magnitude = state->audioData.bands[bandLow] * (1.0f - frac) + state->audioData.bands[bandHigh] * frac;
-    prevMagnitude = state->prevBands[bandLow] * (1.0f - frac) + state->prevBands[bandHigh] * frac;
-    // Vary the color index per strand
-    uint8_t colorIdx = 171 + static_cast<uint8_t>(highsRel * 84.0) + (px.strand->index * 16);
-    color = ColorFromSoundReactivePalette(ocp, colorIdx);
-  }
+  const float frac = mapping.frac * (1.0f / 256);
+  const int bandHigh = mapping.bandLow + 1;
+  const float magnitude =
+      state->audioData.bands[mapping.bandLow] * (1.0f - frac) + state->audioData.bands[bandHigh] * frac;
+  const float prevMagnitude = state->prevBands[mapping.bandLow] * (1.0f - frac) + state->prevBands[bandHigh] * frac;
 
   // Get magnitude for this band (expected to be roughly between agc_min and agc_max)
   float range = state->audioData.agc_max - state->audioData.agc_min;
@@ -251,14 +273,7 @@ ColorWithPalette SoundEffect::innerColor(const Frame& frame, const Pixel& px, So
   transient = (magnitude - prevMagnitude) / range;
   if (transient < 0) transient = 0;
 
-  // Center-out vertical position (0 at center, 1 at edges)
-  // Vary the center slightly per strand
-  double yOffset = (static_cast<double>(px.strand->index % 5) - 2.0) * 0.1 * frame.viewport.size.height;
-  double centerY = frame.viewport.origin.y + frame.viewport.size.height / 2.0 + yOffset;
-  double yRel = 2.0 * fabs(px.coord.y - centerY) / frame.viewport.size.height;
-  if (yRel > 1.0) yRel = 1.0;
-
-  if (yRel < normalizedMag) {
+  if (mapping.yRel * (1.0f / 255) < normalizedMag) {
     // Inside the bar: brightness proportional to magnitude
     uint8_t barBrightness = static_cast<uint8_t>(255.0f * normalizedMag);
     if (barBrightness < 48 && normalizedMag > 0.02f) barBrightness = 48;  // Was 32/0.05f
@@ -332,7 +347,7 @@ ColorWithPalette SoundEffect::innerColor(const Frame& frame, const Pixel& px, So
 #endif
   }
 
-  CRGB* prevColors = lastColors(state);
+  CRGB* prevColors = lastColors(frame, state);
   CRGB& lastColor = prevColors[px.cumulativeIndex];
   // Asymmetrical smoothing: faster on the way up, slower on the way down
   uint8_t blendAmount = 64;  // Was 48
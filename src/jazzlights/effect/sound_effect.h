@@ -16,6 +16,19 @@ struct SoundState {
   bool isSquelched = false;
 };
 
+// How a pixel maps to the audio bands. This only depends on the pixel's position, its strand and the palette, so it
+// is computed once in begin(). Everything is quantized to bytes: together with its last color a pixel takes 9 bytes of
+// effect context, which is 450 bytes for the 50 pixels of the audio visualizer layout and 3.2kB for the 360 of a vest.
+struct SoundPixelMapping {
+  CRGB baseColor;
+  // The pixel interpolates between bandLow and bandLow + 1, frac / 256 is the weight of the latter.
+  uint8_t bandLow;
+  uint8_t frac;
+  // Vertical distance from the center of the bars, from 0 at the center to 255 at the edges.
+  uint8_t yRel;
+};
+static_assert(sizeof(SoundPixelMapping) == 6, "SoundPixelMapping should be packed");
+
 class SoundEffect : public EffectWithPaletteAndState<SoundState> {
  public:
   void innerBegin(const Frame& frame, SoundState* state) const override;
@@ -25,7 +38,11 @@ class SoundEffect : public EffectWithPaletteAndState<SoundState> {
   size_t extraContextSize(const Frame& frame) const override;
 
  private:
-  CRGB* lastColors(SoundState* state) const { return reinterpret_cast<CRGB*>(state + 1); }
+  // The extra context holds one SoundPixelMapping per pixel followed by one CRGB per pixel.
+  SoundPixelMapping* pixelMappings(SoundState* state) const { return reinterpret_cast<SoundPixelMapping*>(state + 1); }
+  CRGB* lastColors(const Frame& frame, SoundState* state) const {
+    return reinterpret_cast<CRGB*>(pixelMappings(state) + frame.pixelCount);
+  }
 };
 
 }  // namespace jazzlights
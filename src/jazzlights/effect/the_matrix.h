@@ -1,7 +1,10 @@
 #ifndef JL_EFFECT_THEMATRIX_H
 #define JL_EFFECT_THEMATRIX_H
 
+#include <cstring>
+
 #include "jazzlights/effect/effect.h"
+#include "jazzlights/effect/grid_kernels.h"
 #include "jazzlights/pseudorandom.h"
 
 namespace jazzlights {
@@ -19,14 +22,26 @@ enum : uint8_t {
   kMatrixTrail = kMatrixSpawn - 10,
 };
 
+// Range of rows [begin, end) of a column outside of which all cells are zero.
+struct MatrixColumn {
+  uint16_t begin;
+  uint16_t end;
+};
+
 class TheMatrix : public XYIndexStateEffect<MatrixState, uint8_t> {
  public:
+  size_t extraContextSize(const Frame& f) const override { return sizeof(MatrixColumn) * w(f); }
+
   void innerBegin(const Frame& f, MatrixState* state) const override {
     state->fallInterval = f.predictableRandom->GetRandomNumberBetween(20, 40);
     state->spawnRate = f.predictableRandom->GetRandomNumberBetween(192, 255);
     state->fadeRate = f.predictableRandom->GetRandomNumberBetween(10, 40);
     state->maxTicks = f.predictableRandom->GetRandomNumberBetween(1, 5);
     state->currentTicks = 0;
+    // The per-pixel data is not initialized for us, and the column ranges rely on everything else being black.
+    memset(cells(f), 0, w(f) * h(f));
+    MatrixColumn* columns = this->columns(f);
+    for (size_t x = 0; x < w(f); x++) { columns[x] = {0, 0}; }
     // Progress the effect 2*h times to get pixels on all rows.
     for (size_t y = 0; y < 2 * h(f); y++) { progressEffect(f, state); }
   }
@@ -51,36 +66,52 @@ class TheMatrix : public XYIndexStateEffect<MatrixState, uint8_t> {
   std::string effectName(PatternBits /*pattern*/) const override { return "the-matrix"; }
 
  private:
+  MatrixColumn* columns(const Frame& f) const { return static_cast<MatrixColumn*>(extraContext(f)); }
+
   void progressEffect(const Frame& f, MatrixState* state) const {
-    for (size_t y = h(f) - 1;; y--) {
+    // Most of the grid is usually black, so only visit the rows of each column that can hold non-zero cells. When
+    // most of the grid is live, whole-grid passes are cheaper than walking columns.
+    MatrixColumn* columns = this->columns(f);
+    size_t liveCells = 0;
+    for (size_t x = 0; x < w(f); x++) { liveCells += columns[x].end - columns[x].begin; }
+    if (liveCells * 2 > w(f) * h(f)) {
+      // Move spawn pixels down, leaving a trail pixel behind.
+      GridShiftMarkers(cells(f), w(f), h(f), kMatrixSpawn, kMatrixTrail);
+      // Fade all trail pixels.
+      GridSubtractSaturating(cells(f), w(f) * h(f), state->fadeRate, /*skip=*/kMatrixSpawn);
+    } else {
       for (size_t x = 0; x < w(f); x++) {
-        if (ps(f, x, y) == kMatrixSpawn) {
-          ps(f, x, y) = kMatrixTrail;  // Create trail pixel.
-          if (y < h(f) - 1) {
-            ps(f, x, y + 1) = kMatrixSpawn;  // Move spawn down.
+        for (size_t y = columns[x].end; y-- > columns[x].begin;) {
+          uint8_t& cell = ps(f, x, y);
+          if (cell == kMatrixSpawn) {
+            // Create trail pixel, already faded like the whole-grid passes would.
+            cell = qsub8(kMatrixTrail, state->fadeRate);
+            if (y < h(f) - 1) {
+              ps(f, x, y + 1) = kMatrixSpawn;  // Move spawn down.
+            }
+          } else {
+            cell = qsub8(cell, state->fadeRate);  // Fade trail pixel.
           }
         }
       }
-      if (y == 0) { break; }
     }
 
-    // Fade all trail pixels.
+    // Trim the ranges to their non-zero cells, and extend them to include spawns that moved down.
     for (size_t x = 0; x < w(f); x++) {
-      for (size_t y = 0; y < h(f); y++) {
-        if (ps(f, x, y) != kMatrixSpawn) {
-          if (ps(f, x, y) > state->fadeRate) {
-            ps(f, x, y) -= state->fadeRate;
-          } else {
-            ps(f, x, y) = 0;
-          }
-        }
-      }
+      MatrixColumn& column = columns[x];
+      if (column.end > column.begin && column.end < h(f)) { column.end++; }
+      while (column.begin < column.end && ps(f, x, column.begin) == 0) { column.begin++; }
+      while (column.end > column.begin && ps(f, x, column.end - 1) == 0) { column.end--; }
+      if (column.begin == column.end) { column = {0, 0}; }
     }
 
     // Spawn new pixel.
     if (f.predictableRandom->GetRandomByte() < state->spawnRate) {
       size_t spawnX = f.predictableRandom->GetRandomNumberBetween(0, w(f) - 1);
       ps(f, spawnX, 0) = kMatrixSpawn;
+      MatrixColumn& column = columns[spawnX];
+      if (column.begin == column.end) { column.end = 1; }
+      column.begin = 0;
     }
   }
 };
@@ -37,6 +37,7 @@ class FastLedRenderer : public Renderer {
   }
 
   void renderPixel(size_t index, CRGB color) override;
+  CRGB* pixelBuffer() override { return ledsPlayer_; }
 
   uint32_t GetPowerAtFullBrightness() const;
 
@@ -11,6 +11,7 @@
 namespace jazzlights {
 
 class PredictableRandom;
+class LazySpatialIndex;
 
 struct Frame {
  public:
@@ -21,6 +22,11 @@ struct Frame {
   void* context = nullptr;
   Milliseconds time;
   size_t pixelCount;
+  // All strands, in cumulative pixel index order. Lets effects precompute per-pixel data in begin().
+  const std::vector<Strand>* strands = nullptr;
+  // Finds nearby pixels by their actual coordinates, for effects that need neighbors. Built the first time an effect
+  // calls spatialIndex->Get().
+  const LazySpatialIndex* spatialIndex = nullptr;
 };
 
 constexpr Coord width(const Frame& frame) { return frame.viewport.size.width; }
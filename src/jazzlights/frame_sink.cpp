@@ -0,0 +1,213 @@
+#include "jazzlights/frame_sink.h"
+
+#ifndef ESP32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "jazzlights/util/log.h"
+
+namespace jazzlights {
+
+namespace {
+
+size_t SlotSize(size_t width, size_t height) {
+  const size_t size = kSharedFrameRingAlignment + width * height * sizeof(CRGB);
+  return (size + kSharedFrameRingAlignment - 1) / kSharedFrameRingAlignment * kSharedFrameRingAlignment;
+}
+
+SharedFrameRingHeader* RingHeader(void* memory) { return static_cast<SharedFrameRingHeader*>(memory); }
+
+SharedFrameSlotHeader* SlotHeader(void* memory, uint64_t frameNumber) {
+  const SharedFrameRingHeader* header = RingHeader(memory);
+  return reinterpret_cast<SharedFrameSlotHeader*>(static_cast<uint8_t*>(memory) + kSharedFrameRingAlignment +
+                                                  ((frameNumber - 1) % header->slotCount) * header->slotSize);
+}
+
+uint8_t* SlotPixels(SharedFrameSlotHeader* slot) {
+  return reinterpret_cast<uint8_t*>(slot) + kSharedFrameRingAlignment;
+}
+
+// BT.601 studio-range conversion in 8-bit fixed point, as used by most video tools.
+uint8_t RgbToY(CRGB c) { return static_cast<uint8_t>(((66 * c.r + 129 * c.g + 25 * c.b + 128) >> 8) + 16); }
+uint8_t RgbToU(CRGB c) { return static_cast<uint8_t>(((-38 * c.r - 74 * c.g + 112 * c.b + 128) >> 8) + 128); }
+uint8_t RgbToV(CRGB c) { return static_cast<uint8_t>(((112 * c.r - 94 * c.g - 18 * c.b + 128) >> 8) + 128); }
+
+}  // namespace
+
+bool ParseFrameFormat(const char* name, FrameFormat* format) {
+  if (strcmp(name, "raw") == 0) {
+    *format = FrameFormat::kRaw;
+  } else if (strcmp(name, "ppm") == 0) {
+    *format = FrameFormat::kPpm;
+  } else if (strcmp(name, "y4m") == 0) {
+    *format = FrameFormat::kY4m;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+FileFrameSink::FileFrameSink(FILE* file, FrameFormat format, size_t width, size_t height, uint32_t framesPerSecond)
+    : file_(file), format_(format), width_(width), height_(height), framesPerSecond_(framesPerSecond) {
+  if (format_ == FrameFormat::kY4m) { planes_.resize(3 * width_ * height_); }
+}
+
+bool FileFrameSink::WriteFrame(const CRGB* pixels) {
+  const size_t numPixels = width_ * height_;
+  switch (format_) {
+    case FrameFormat::kRaw: break;
+    case FrameFormat::kPpm:
+      if (fprintf(file_, "P6\n%zu %zu\n255\n", width_, height_) < 0) { return false; }
+      break;
+    case FrameFormat::kY4m: {
+      if (!wroteStreamHeader_) {
+        if (fprintf(file_, "YUV4MPEG2 W%zu H%zu F%u:1 Ip A1:1 C444\n", width_, height_, framesPerSecond_) < 0) {
+          return false;
+        }
+        wroteStreamHeader_ = true;
+      }
+      if (fputs("FRAME\n", file_) < 0) { return false; }
+      uint8_t* y = planes_.data();
+      uint8_t* u = y + numPixels;
+      uint8_t* v = u + numPixels;
+      for (size_t i = 0; i < numPixels; i++) {
+        y[i] = RgbToY(pixels[i]);
+        u[i] = RgbToU(pixels[i]);
+        v[i] = RgbToV(pixels[i]);
+      }
+      return fwrite(planes_.data(), 1, planes_.size(), file_) == planes_.size();
+    }
+  }
+  return fwrite(pixels, sizeof(CRGB), numPixels, file_) == numPixels;
+}
+
+std::unique_ptr<SharedMemoryFrameSink> SharedMemoryFrameSink::Create(const std::string& name, size_t width,
+                                                                     size_t height, size_t slotCount) {
+  const size_t slotSize = SlotSize(width, height);
+  if (width == 0 || height == 0 || slotCount == 0 || slotSize > UINT32_MAX || slotCount > UINT32_MAX) {
+    jll_error("Invalid shared memory frame ring %zux%zu with %zu slots", width, height, slotCount);
+    return nullptr;
+  }
+  const size_t memorySize = kSharedFrameRingAlignment + slotCount * slotSize;
+  // Never take over an existing object, it could belong to another writer that is still running.
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0 && errno == EEXIST) {
+    jll_error("Shared memory %s already exists, it is either in use by another writer or left behind by one that "
+              "crashed, in which case remove /dev/shm%s",
+              name.c_str(), name.c_str());
+    return nullptr;
+  }
+  if (fd < 0) {
+    jll_error("shm_open(%s) failed: %s", name.c_str(), strerror(errno));
+    return nullptr;
+  }
+  if (ftruncate(fd, static_cast<off_t>(memorySize)) != 0) {
+    jll_error("ftruncate(%s, %zu) failed: %s", name.c_str(), memorySize, strerror(errno));
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+  void* memory = mmap(nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    jll_error("mmap(%s, %zu) failed: %s", name.c_str(), memorySize, strerror(errno));
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+  // The object starts out zeroed, so framesWritten and all frameNumbers are already 0. Set the magic last so readers
+  // never see a partially initialized header.
+  SharedFrameRingHeader* header = RingHeader(memory);
+  header->width = static_cast<uint32_t>(width);
+  header->height = static_cast<uint32_t>(height);
+  header->slotCount = static_cast<uint32_t>(slotCount);
+  header->slotSize = static_cast<uint32_t>(slotSize);
+  header->magic.store(kSharedFrameRingMagic, std::memory_order_release);
+  return std::unique_ptr<SharedMemoryFrameSink>(new SharedMemoryFrameSink(name, memory, memorySize));
+}
+
+SharedMemoryFrameSink::SharedMemoryFrameSink(const std::string& name, void* memory, size_t memorySize)
+    : name_(name), memory_(memory), memorySize_(memorySize) {}
+
+SharedMemoryFrameSink::~SharedMemoryFrameSink() {
+  munmap(memory_, memorySize_);
+  shm_unlink(name_.c_str());
+}
+
+bool SharedMemoryFrameSink::WriteFrame(const CRGB* pixels) {
+  SharedFrameRingHeader* header = RingHeader(memory_);
+  const uint64_t frameNumber = header->framesWritten.load(std::memory_order_relaxed) + 1;
+  SharedFrameSlotHeader* slot = SlotHeader(memory_, frameNumber);
+  // Mark the slot as being written before touching its pixels, this works like a sequence lock.
+  slot->frameNumber.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(SlotPixels(slot), pixels, header->width * header->height * sizeof(CRGB));
+  slot->frameNumber.store(frameNumber, std::memory_order_release);
+  header->framesWritten.store(frameNumber, std::memory_order_release);
+  return true;
+}
+
+std::unique_ptr<SharedMemoryFrameReader> SharedMemoryFrameReader::Open(const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    jll_error("shm_open(%s) failed: %s", name.c_str(), strerror(errno));
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kSharedFrameRingAlignment) {
+    jll_error("Shared memory %s is too small to be a frame ring", name.c_str());
+    close(fd);
+    return nullptr;
+  }
+  const size_t memorySize = static_cast<size_t>(st.st_size);
+  void* memory = mmap(nullptr, memorySize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    jll_error("mmap(%s, %zu) failed: %s", name.c_str(), memorySize, strerror(errno));
+    return nullptr;
+  }
+  const SharedFrameRingHeader* header = RingHeader(memory);
+  // Only read the other fields once the magic shows that the writer finished setting them.
+  if (header->magic.load(std::memory_order_relaxed) != kSharedFrameRingMagic) {
+    jll_error("Shared memory %s is not a frame ring", name.c_str());
+    munmap(memory, memorySize);
+    return nullptr;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const size_t ringSize = kSharedFrameRingAlignment + static_cast<size_t>(header->slotCount) * header->slotSize;
+  if (header->slotCount == 0 || header->slotSize < SlotSize(header->width, header->height) || ringSize > memorySize) {
+    jll_error("Shared memory %s is not a valid frame ring", name.c_str());
+    munmap(memory, memorySize);
+    return nullptr;
+  }
+  return std::unique_ptr<SharedMemoryFrameReader>(new SharedMemoryFrameReader(memory, memorySize));
+}
+
+SharedMemoryFrameReader::SharedMemoryFrameReader(void* memory, size_t memorySize)
+    : memory_(memory), memorySize_(memorySize) {}
+
+SharedMemoryFrameReader::~SharedMemoryFrameReader() { munmap(memory_, memorySize_); }
+
+size_t SharedMemoryFrameReader::width() const { return RingHeader(memory_)->width; }
+
+size_t SharedMemoryFrameReader::height() const { return RingHeader(memory_)->height; }
+
+uint64_t SharedMemoryFrameReader::ReadLatestFrame(CRGB* pixels) const {
+  SharedFrameRingHeader* header = RingHeader(memory_);
+  const uint64_t frameNumber = header->framesWritten.load(std::memory_order_acquire);
+  if (frameNumber == 0) { return 0; }
+  SharedFrameSlotHeader* slot = SlotHeader(memory_, frameNumber);
+  if (slot->frameNumber.load(std::memory_order_acquire) != frameNumber) { return 0; }
+  memcpy(pixels, SlotPixels(slot), header->width * header->height * sizeof(CRGB));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot->frameNumber.load(std::memory_order_relaxed) != frameNumber) { return 0; }
+  return frameNumber;
+}
+
+}  // namespace jazzlights
+
+#endif  // ESP32
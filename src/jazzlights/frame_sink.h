@@ -0,0 +1,137 @@
+#ifndef JL_FRAME_SINK_H
+#define JL_FRAME_SINK_H
+
+#ifndef ESP32
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jazzlights/fastled_wrapper.h"
+
+namespace jazzlights {
+
+// Destinations for the images produced by SoftwareRenderer, for recording patterns or feeding them to other programs.
+// Frames are packed RGB24 images of a size fixed at construction.
+class FrameSink {
+ public:
+  virtual ~FrameSink() = default;
+  // Returns false if the frame could not be written.
+  virtual bool WriteFrame(const CRGB* pixels) = 0;
+};
+
+enum class FrameFormat : uint8_t {
+  // Frames back to back without any header, for tools that are told the size, such as
+  // `ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH`.
+  kRaw,
+  // One binary PPM image per frame, readable one at a time by most image tools and by `ffmpeg -f image2pipe`.
+  kPpm,
+  // YUV4MPEG2 stream with 4:4:4 BT.601 studio-range frames, which video tools read without being told the size.
+  kY4m,
+};
+
+// Returns false if name is not one of "raw", "ppm" or "y4m".
+bool ParseFrameFormat(const char* name, FrameFormat* format);
+
+// Writes frames to a file or pipe. Does not take ownership of file.
+class FileFrameSink : public FrameSink {
+ public:
+  FileFrameSink(FILE* file, FrameFormat format, size_t width, size_t height, uint32_t framesPerSecond);
+
+  bool WriteFrame(const CRGB* pixels) override;
+
+ private:
+  FILE* file_;
+  const FrameFormat format_;
+  const size_t width_;
+  const size_t height_;
+  const uint32_t framesPerSecond_;
+  bool wroteStreamHeader_ = false;
+  // Y, U and V planes of the current frame for kY4m.
+  std::vector<uint8_t> planes_;
+};
+
+// Memory layout of the ring of frames that SharedMemoryFrameSink shares with other processes. It starts with a
+// SharedFrameRingHeader followed by slotCount slots, each slot is a SharedFrameSlotHeader followed by the pixels. Both
+// headers take kSharedFrameRingAlignment bytes and slots are padded to a multiple of it.
+//
+// Readers load framesWritten, read the slot of the latest frame, and then check that its frameNumber matched that
+// frame both before and after copying the pixels. Otherwise the writer wrapped around and reused the slot during the
+// copy and the reader should try again.
+static constexpr uint32_t kSharedFrameRingMagic = 0x524C464A;  // "JFLR" in little endian.
+static constexpr size_t kSharedFrameRingAlignment = 64;
+
+struct SharedFrameRingHeader {
+  // Written last, once the fields below are set.
+  std::atomic<uint32_t> magic;
+  uint32_t width;
+  uint32_t height;
+  uint32_t slotCount;
+  // Size of each slot including its header.
+  uint32_t slotSize;
+  uint32_t reserved;
+  // Number of frames written so far, frame n (starting at 1) is in slot (n - 1) % slotCount.
+  std::atomic<uint64_t> framesWritten;
+};
+
+struct SharedFrameSlotHeader {
+  // Number of the frame in this slot, or 0 while it is being written.
+  std::atomic<uint64_t> frameNumber;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "Frame ring atomics must be usable across processes");
+static_assert(sizeof(SharedFrameRingHeader) <= kSharedFrameRingAlignment);
+static_assert(sizeof(SharedFrameSlotHeader) <= kSharedFrameRingAlignment);
+
+// Writes frames into a POSIX shared memory object so that other processes on the same machine can display or analyze
+// them without any copies through pipes. The writer never waits for readers, slow readers skip frames.
+class SharedMemoryFrameSink : public FrameSink {
+ public:
+  // name is a POSIX shared memory name such as "/jazzlights". Returns nullptr on failure, including when an object with
+  // that name already exists.
+  static std::unique_ptr<SharedMemoryFrameSink> Create(const std::string& name, size_t width, size_t height,
+                                                       size_t slotCount = 4);
+  // Removes the shared memory object, readers that already mapped it keep their mapping.
+  ~SharedMemoryFrameSink() override;
+
+  bool WriteFrame(const CRGB* pixels) override;
+
+ private:
+  SharedMemoryFrameSink(const std::string& name, void* memory, size_t memorySize);
+
+  const std::string name_;
+  void* const memory_;
+  const size_t memorySize_;
+};
+
+// Reads frames written by a SharedMemoryFrameSink, possibly in another process.
+class SharedMemoryFrameReader {
+ public:
+  // Returns nullptr if there is no valid frame ring with that name.
+  static std::unique_ptr<SharedMemoryFrameReader> Open(const std::string& name);
+  ~SharedMemoryFrameReader();
+
+  size_t width() const;
+  size_t height() const;
+
+  // Copies the most recent frame into pixels, which must hold width() * height() pixels, and returns its number.
+  // Returns 0 if no frame was written yet or if the writer overwrote the frame while it was being copied.
+  uint64_t ReadLatestFrame(CRGB* pixels) const;
+
+ private:
+  SharedMemoryFrameReader(void* memory, size_t memorySize);
+
+  void* const memory_;
+  const size_t memorySize_;
+};
+
+}  // namespace jazzlights
+
+#endif  // ESP32
+
+#endif  // JL_FRAME_SINK_H
@@ -6,7 +6,7 @@
     JL_IS_CONFIG(RHINO_STAFF)
 
 #include "jazzlights/layout/matrix.h"
-#include "jazzlights/layout/pixelmap.h"
+#include "jazzlights/layout/packed_layout.h"
 
 namespace jazzlights {
 namespace {
@@ -50,109 +50,27 @@ Matrix pixels(/*w=*/35, /*h=*/1);
 #endif  // ORRERY_PLANET
 
 #if JL_IS_CONFIG(NEW_HAT)
-constexpr Point pixelMap[] = {
-    { 0.00, 0.00},
-    { 1.00, 0.00},
-    { 2.00, 0.00},
-    { 3.00, 0.00},
-    { 4.00, 0.00},
-    { 5.00, 0.00},
-    { 6.00, 0.00},
-    { 7.00, 0.00},
-    { 8.00, 0.00},
-    { 9.00, 0.00},
-    {10.00, 0.00},
-    {11.00, 0.00},
-    {12.00, 0.00},
-    {13.00, 0.00},
-    {14.00, 0.00},
-    {15.00, 0.00},
-    {16.00, 0.00},
-    {17.00, 0.00},
-    {18.00, 0.00},
-    {19.00, 0.00},
-    {20.00, 0.00},
-    {21.00, 0.00},
-    {22.00, 0.00},
-    {23.00, 0.00},
-    {24.00, 0.00},
-    {25.00, 0.00},
-    {26.00, 0.00},
-    {27.00, 0.00},
-    {28.00, 0.00},
-    {29.00, 0.00},
-    {30.00, 0.00},
-    {31.00, 0.00},
-    {32.00, 0.00},
-    {33.00, 0.00},
-    {34.00, 0.00},
-    {35.00, 0.00},
-    {36.00, 0.00},
-    {37.00, 0.00},
-    {38.00, 0.00},
-    {39.00, 0.00},
-    {40.00, 0.00},
-    {41.00, 0.00},
-    {42.00, 0.00},
-    {43.00, 0.00},
-    {44.00, 0.00},
-    {45.00, 0.00},
-    {46.00, 0.00},
-    {47.00, 0.00},
-    {48.00, 0.00},
-    {47.00, 0.00},
-    {46.00, 0.00},
-    {45.00, 0.00},
-    {44.00, 0.00},
-    {43.00, 0.00},
-    {42.00, 0.00},
-    {41.00, 0.00},
-    {40.00, 0.00},
-    {39.00, 0.00},
-    {38.00, 0.00},
-    {37.00, 0.00},
-    {36.00, 0.00},
-    {35.00, 0.00},
-    {34.00, 0.00},
-    {33.00, 0.00},
-    {32.00, 0.00},
-    {31.00, 0.00},
-    {30.00, 0.00},
-    {29.00, 0.00},
-    {28.00, 0.00},
-    {27.00, 0.00},
-    {26.00, 0.00},
-    {25.00, 0.00},
-    {24.00, 0.00},
-    {23.00, 0.00},
-    {22.00, 0.00},
-    {21.00, 0.00},
-    {20.00, 0.00},
-    {19.00, 0.00},
-    {18.00, 0.00},
-    {17.00, 0.00},
-    {16.00, 0.00},
-    {15.00, 0.00},
-    {14.00, 0.00},
-    {13.00, 0.00},
-    {12.00, 0.00},
-    {11.00, 0.00},
-    {10.00, 0.00},
-    { 9.00, 0.00},
-    { 8.00, 0.00},
-    { 7.00, 0.00},
-    { 6.00, 0.00},
-    { 5.00, 0.00},
-    { 4.00, 0.00},
-    { 3.00, 0.00},
-    { 2.00, 0.00},
-    { 1.00, 0.00},
-    { 0.00, 0.00},
-    { 1.00, 0.00},
+constexpr int16_t pixelMapXs[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+                                  24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44,
+                                  45, 46, 47, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31,
+                                  30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9,
+                                  8, 7, 6, 5, 4, 3, 2, 1, 0, 1};
+constexpr int16_t pixelMapYs[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+constexpr PackedPoints pixelMap = {
+    .count = 98,
+    .origin = {0.0, 0.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = pixelMapXs,
+    .ys = pixelMapYs,
+    .emptyBits = nullptr,
 };
 
-static_assert(JL_LENGTH(pixelMap) == 98, "bad size");
-PixelMap pixels(JL_LENGTH(pixelMap), pixelMap);
+static_assert(JL_LENGTH(pixelMapXs) == 98 && JL_LENGTH(pixelMapYs) == 98, "bad size");
+PackedLayout pixels(pixelMap);
 #endif  // NEW_HAT
 
 #if JL_IS_CONFIG(RHINO_HAT)
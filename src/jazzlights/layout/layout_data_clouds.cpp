@@ -3,218 +3,88 @@
 #if JL_IS_CONFIG(CLOUDS)
 
 #include "jazzlights/layout/matrix.h"
-#include "jazzlights/layout/pixelmap.h"
+#include "jazzlights/layout/packed_layout.h"
 
 namespace jazzlights {
 namespace {
 
-constexpr Point cloudPixelMap[] = {
-    {1.00,  0.00},
-    {1.00,  1.00},
-    {1.00,  2.00},
-    {1.00,  3.00},
-    {1.00,  4.00},
-    {1.00,  5.00},
-    {1.00,  6.00},
-    {1.00,  7.00},
-    {1.00,  8.00},
-    {1.00,  9.00},
-    {1.00, 10.00},
-    {1.00, 11.00},
-    {1.00, 12.00},
-    {1.00, 13.00},
-    {1.00, 14.00},
-    {1.00, 15.00},
-    {1.00, 16.00},
-    EmptyPoint(),  EmptyPoint(),  {2.00,  0.00},
-    {2.00,  1.00},
-    {2.00,  2.00},
-    {2.00,  3.00},
-    {2.00,  4.00},
-    {2.00,  5.00},
-    {2.00,  6.00},
-    {2.00,  7.00},
-    {2.00,  8.00},
-    {2.00,  9.00},
-    {2.00, 10.00},
-    {2.00, 11.00},
-    {2.00, 12.00},
-    {2.00, 13.00},
-    {2.00, 14.00},
-    EmptyPoint(),
-    EmptyPoint(),  EmptyPoint(),  {3.00,  0.00},
-    {3.00,  1.00},
-    {3.00,  2.00},
-    {3.00,  3.00},
-    {3.00,  4.00},
-    {3.00,  5.00},
-    {3.00,  6.00},
-    {3.00,  7.00},
-    {3.00,  8.00},
-    {3.00,  9.00},
-    {3.00, 10.00},
-    {3.00, 11.00},
-    {3.00, 12.00},
-    EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  {4.00,  0.00},
-    {4.00,  1.00},
-    {4.00,  2.00},
-    {4.00,  3.00},
-    {4.00,  4.00},
-    {4.00,  5.00},
-    {4.00,  6.00},
-    {4.00,  7.00},
-    {4.00,  8.00},
-    {4.00,  9.00},
-    {4.00, 10.00},
-    EmptyPoint(),  EmptyPoint(),  {5.00,  0.00},
-    {5.00,  1.00},
-    {5.00,  2.00},
-    {5.00,  3.00},
-    {5.00,  4.00},
-    {5.00,  5.00},
-    {5.00,  6.00},
-    {5.00,  7.00},
-    {5.00,  8.00},
-    {5.00,  9.00},
-    {5.00, 10.00},
-    {5.00, 11.00},
-    {5.00, 12.00},
-    {5.00, 13.00},
-    EmptyPoint(),  EmptyPoint(),  {6.00,  0.00},
-    {6.00,  1.00},
-    {6.00,  2.00},
-    {6.00,  3.00},
-    {6.00,  4.00},
-    {6.00,  5.00},
-    {6.00,  6.00},
-    EmptyPoint(),  {7.00,  0.00},
-    {7.00,  1.00},
-    {7.00,  2.00},
-    {7.00,  3.00},
-    {7.00,  4.00},
-    {7.00,  5.00},
-    {7.00,  6.00},
-    {7.00,  7.00},
-    {7.00,  8.00},
-    {7.00,  9.00},
+constexpr int16_t cloudPixelMapXs[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                       1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 3,
+                                       3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0,
+                                       0, 5, 5, 5, 5, 5, 5, 5, 0, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6};
+constexpr int16_t cloudPixelMapYs[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 0, 0, 0, 1, 2, 3, 4, 5,
+                                       6, 7, 8, 9, 10, 11, 12, 13, 14, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                       12, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8,
+                                       9, 10, 11, 12, 13, 0, 0, 0, 1, 2, 3, 4, 5, 6, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+constexpr uint8_t cloudPixelMapEmptyBits[] = {0x00, 0x00, 0x06, 0x00, 0x1c, 0x00, 0x1c, 0x00, 0x03, 0x00, 0x03, 0x02,
+                                              0x00};
+constexpr PackedPoints cloudPixelMap = {
+    .count = 100,
+    .origin = {1.0, 0.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = cloudPixelMapXs,
+    .ys = cloudPixelMapYs,
+    .emptyBits = cloudPixelMapEmptyBits,
 };
 
-static_assert(JL_LENGTH(cloudPixelMap) == 100, "bad size");
-PixelMap cloudPixels(JL_LENGTH(cloudPixelMap), cloudPixelMap);
-
-constexpr Point ceiling1PixelMap[] = {
-    {1.00,  -1.00},
-    {1.00,  -2.00},
-    {1.00,  -3.00},
-    {1.00,  -4.00},
-    {1.00,  -5.00},
-    {1.00,  -6.00},
-    {1.00,  -7.00},
-    {1.00,  -8.00},
-    {1.00,  -9.00},
-    {1.00, -10.00},
-    {1.00, -11.00},
-    {1.00, -12.00},
-    {1.00, -13.00},
-    {1.00, -14.00},
-    {1.00, -15.00},
-    {1.00, -16.00},
-    {1.00, -17.00},
-    {1.00, -18.00},
-    {1.00, -19.00},
-    {1.00, -20.00},
-    {1.00, -21.00},
-    {1.00, -22.00},
-    {1.00, -23.00},
-    {1.00, -24.00},
-    {1.00, -25.00},
-    {1.00, -26.00},
-    {1.00, -27.00},
-    {1.00, -28.00},
-    {1.00, -29.00},
-    {1.00, -30.00},
-    {1.00, -31.00},
-    {1.00, -32.00},
-    {1.00, -33.00},
-    {1.00, -34.00},
-    {1.00, -35.00},
-    {1.00, -36.00},
-    {1.00, -37.00},
-    {1.00, -38.00},
-    {1.00, -39.00},
-    {1.00, -40.00},
-    {1.00, -41.00},
-    {1.00, -42.00},
-    EmptyPoint(),   EmptyPoint(),   EmptyPoint(),   EmptyPoint(),
+static_assert(JL_LENGTH(cloudPixelMapXs) == 100 && JL_LENGTH(cloudPixelMapYs) == 100, "bad size");
+PackedLayout cloudPixels(cloudPixelMap);
+
+constexpr int16_t ceiling1PixelMapXs[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+constexpr int16_t ceiling1PixelMapYs[] = {41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23,
+                                          22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1,
+                                          0, 0, 0, 0, 0};
+constexpr uint8_t ceiling1PixelMapEmptyBits[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x3c};
+constexpr PackedPoints ceiling1PixelMap = {
+    .count = 46,
+    .origin = {1.0, -42.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = ceiling1PixelMapXs,
+    .ys = ceiling1PixelMapYs,
+    .emptyBits = ceiling1PixelMapEmptyBits,
 };
 
-static_assert(JL_LENGTH(ceiling1PixelMap) == 46, "bad size");
-PixelMap ceiling1Pixels(JL_LENGTH(ceiling1PixelMap), ceiling1PixelMap);
-
-constexpr Point ceiling2PixelMap[] = {
-    {2.00,  -1.00},
-    {2.00,  -2.00},
-    {2.00,  -3.00},
-    {2.00,  -4.00},
-    {2.00,  -5.00},
-    {2.00,  -6.00},
-    {2.00,  -7.00},
-    {2.00,  -8.00},
-    {2.00,  -9.00},
-    {2.00, -10.00},
-    {2.00, -11.00},
-    {2.00, -12.00},
-    {2.00, -13.00},
-    {2.00, -14.00},
-    {2.00, -15.00},
-    {2.00, -16.00},
-    {2.00, -17.00},
-    {2.00, -18.00},
-    {2.00, -19.00},
-    {2.00, -20.00},
-    {2.00, -21.00},
-    {2.00, -22.00},
-    {2.00, -23.00},
-    {2.00, -24.00},
-    {2.00, -25.00},
-    {2.00, -26.00},
-    {2.00, -27.00},
-    {2.00, -28.00},
-    {2.00, -29.00},
-    {2.00, -30.00},
-    {2.00, -31.00},
-    {2.00, -32.00},
-    {2.00, -33.00},
-    {2.00, -34.00},
-    {2.00, -35.00},
-    {2.00, -36.00},
-    {2.00, -37.00},
-    {2.00, -38.00},
-    EmptyPoint(),   EmptyPoint(),   EmptyPoint(),   EmptyPoint(),
+static_assert(JL_LENGTH(ceiling1PixelMapXs) == 46 && JL_LENGTH(ceiling1PixelMapYs) == 46, "bad size");
+PackedLayout ceiling1Pixels(ceiling1PixelMap);
+
+constexpr int16_t ceiling2PixelMapXs[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+constexpr int16_t ceiling2PixelMapYs[] = {37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19,
+                                          18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0};
+constexpr uint8_t ceiling2PixelMapEmptyBits[] = {0x00, 0x00, 0x00, 0x00, 0xc0, 0x03};
+constexpr PackedPoints ceiling2PixelMap = {
+    .count = 42,
+    .origin = {2.0, -38.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = ceiling2PixelMapXs,
+    .ys = ceiling2PixelMapYs,
+    .emptyBits = ceiling2PixelMapEmptyBits,
 };
 
-static_assert(JL_LENGTH(ceiling2PixelMap) == 42, "bad size");
-PixelMap ceiling2Pixels(JL_LENGTH(ceiling2PixelMap), ceiling2PixelMap);
-
-constexpr Point ceiling3PixelMap[] = {
-    {3.00,  -1.00},
-    {3.00,  -2.00},
-    {3.00,  -3.00},
-    {3.00,  -4.00},
-    {3.00,  -5.00},
-    {3.00,  -6.00},
-    {3.00,  -7.00},
-    {3.00,  -8.00},
-    {3.00,  -9.00},
-    {3.00, -10.00},
-    EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),
-    EmptyPoint(),  EmptyPoint(),  EmptyPoint(),   EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),
-    EmptyPoint(),  EmptyPoint(),  EmptyPoint(),   EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),
-    EmptyPoint(),  EmptyPoint(),  EmptyPoint(),   EmptyPoint(),
+static_assert(JL_LENGTH(ceiling2PixelMapXs) == 42 && JL_LENGTH(ceiling2PixelMapYs) == 42, "bad size");
+PackedLayout ceiling2Pixels(ceiling2PixelMap);
+
+constexpr int16_t ceiling3PixelMapXs[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          0, 0, 0, 0, 0, 0};
+constexpr int16_t ceiling3PixelMapYs[] = {9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          0, 0, 0, 0, 0, 0};
+constexpr uint8_t ceiling3PixelMapEmptyBits[] = {0x00, 0xfc, 0xff, 0xff};
+constexpr PackedPoints ceiling3PixelMap = {
+    .count = 32,
+    .origin = {3.0, -10.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = ceiling3PixelMapXs,
+    .ys = ceiling3PixelMapYs,
+    .emptyBits = ceiling3PixelMapEmptyBits,
 };
 
-static_assert(JL_LENGTH(ceiling3PixelMap) == 32, "bad size");
-PixelMap ceiling3Pixels(JL_LENGTH(ceiling3PixelMap), ceiling3PixelMap);
+static_assert(JL_LENGTH(ceiling3PixelMapXs) == 32 && JL_LENGTH(ceiling3PixelMapYs) == 32, "bad size");
+PackedLayout ceiling3Pixels(ceiling3PixelMap);
 
 }  // namespace
 
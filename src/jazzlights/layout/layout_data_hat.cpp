@@ -2,67 +2,30 @@
 
 #if JL_IS_CONFIG(HAT)
 
-#include "jazzlights/layout/pixelmap.h"
+#include "jazzlights/layout/packed_layout.h"
 
 namespace jazzlights {
 namespace {
 
-constexpr Point pixelMap[] = {
-    { 0.00, 0.00},
-    { 1.00, 0.00},
-    { 2.00, 0.00},
-    { 3.00, 0.00},
-    { 4.00, 0.00},
-    { 5.00, 0.00},
-    { 6.00, 0.00},
-    { 7.00, 0.00},
-    { 8.00, 0.00},
-    { 9.00, 0.00},
-    {10.00, 0.00},
-    {11.00, 0.00},
-    {12.00, 0.00},
-    {13.00, 0.00},
-    {14.00, 0.00},
-    {15.00, 0.00},
-    {16.00, 0.00},
-    {17.00, 0.00},
-    {18.00, 0.00},
-    {19.00, 0.00},
-    {20.00, 0.00},
-    {21.00, 0.00},
-    {22.00, 0.00},
-    {23.00, 0.00},
-    {22.00, 0.00},
-    {21.00, 0.00},
-    {20.00, 0.00},
-    {19.00, 0.00},
-    {18.00, 0.00},
-    {17.00, 0.00},
-    {16.00, 0.00},
-    {15.00, 0.00},
-    {14.00, 0.00},
-    {13.00, 0.00},
-    {12.00, 0.00},
-    {11.00, 0.00},
-    {10.00, 0.00},
-    { 9.00, 0.00},
-    { 8.00, 0.00},
-    { 7.00, 0.00},
-    { 6.00, 0.00},
-    { 5.00, 0.00},
-    { 4.00, 0.00},
-    { 3.00, 0.00},
-    { 2.00, 0.00},
-    { 1.00, 0.00},
-    { 0.00, 0.00},
-    { 1.00, 0.00},
-    EmptyPoint(),
-    EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),
-    EmptyPoint(),  EmptyPoint(),  EmptyPoint(),  EmptyPoint(),
+constexpr int16_t pixelMapXs[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+                                  22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1,
+                                  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+constexpr int16_t pixelMapYs[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                  0, 0};
+constexpr uint8_t pixelMapEmptyBits[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x0f};
+constexpr PackedPoints pixelMap = {
+    .count = 60,
+    .origin = {0.0, 0.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = pixelMapXs,
+    .ys = pixelMapYs,
+    .emptyBits = pixelMapEmptyBits,
 };
 
-static_assert(JL_LENGTH(pixelMap) == 60, "bad size");
-PixelMap pixels(JL_LENGTH(pixelMap), pixelMap);
+static_assert(JL_LENGTH(pixelMapXs) == 60 && JL_LENGTH(pixelMapYs) == 60, "bad size");
+PackedLayout pixels(pixelMap);
 
 }  // namespace
 
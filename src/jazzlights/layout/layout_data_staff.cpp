@@ -2,91 +2,44 @@
 
 #if JL_IS_CONFIG(STAFF)
 
-#include "jazzlights/layout/pixelmap.h"
+#include "jazzlights/layout/packed_layout.h"
 
 namespace jazzlights {
 namespace {
 
-constexpr Point pixelMap[] = {
-    {2.00,  1.00},
-    {2.00,  2.00},
-    {2.00,  3.00},
-    {2.00,  4.00},
-    {2.00,  5.00},
-    {2.00,  6.00},
-    {2.00,  7.00},
-    {2.00,  8.00},
-    {2.00,  9.00},
-    {2.00, 10.00},
-    {2.00, 11.00},
-    {2.00, 12.00},
-    {2.00, 13.00},
-    {2.00, 14.00},
-    {2.00, 15.00},
-    {2.00, 16.00},
-    {2.00, 17.00},
-    {2.00, 18.00},
-    {2.00, 19.00},
-    {2.00, 20.00},
-    {2.00, 21.00},
-    {2.00, 22.00},
-    {2.00, 23.00},
-    {2.00, 24.00},
-    {2.00, 25.00},
-    {2.00, 26.00},
-    {2.00, 27.00},
-    {2.00, 28.00},
-    {2.00, 29.00},
-    {2.00, 30.00},
-    {2.00, 31.00},
-    {2.00, 32.00},
-    {2.00, 33.00},
-    {2.00, 34.00},
-    {2.00, 35.00},
-    {2.00, 36.00},
+constexpr int16_t pixelMapXs[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                  0, 0, 0, 0, 0, 0, 0};
+constexpr int16_t pixelMapYs[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+                                  24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35};
+constexpr PackedPoints pixelMap = {
+    .count = 36,
+    .origin = {2.0, 1.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = pixelMapXs,
+    .ys = pixelMapYs,
+    .emptyBits = nullptr,
 };
 
-static_assert(JL_LENGTH(pixelMap) == 36, "bad size");
-PixelMap pixels(JL_LENGTH(pixelMap), pixelMap);
-
-constexpr Point pixelMap2[] = {
-    {0.00,  0.00},
-    {1.00,  0.00},
-    {2.00,  0.00},
-    {3.00,  0.00},
-    {4.00,  0.00},
-    {3.00,  0.00},
-    {2.00,  0.00},
-    {1.00,  0.00},
-    {0.00, -1.00},
-    {1.00, -1.00},
-    {2.00, -1.00},
-    {3.00, -1.00},
-    {4.00, -1.00},
-    {3.00, -1.00},
-    {2.00, -1.00},
-    {1.00, -1.00},
-    {0.00, -2.00},
-    {1.00, -2.00},
-    {2.00, -2.00},
-    {3.00, -2.00},
-    {4.00, -2.00},
-    {3.00, -2.00},
-    {2.00, -2.00},
-    {1.00, -2.00},
-    {0.00, -3.00},
-    {1.00, -3.00},
-    {2.00, -3.00},
-    {3.00, -3.00},
-    {4.00, -3.00},
-    {3.00, -3.00},
-    {2.00, -3.00},
-    {1.00, -3.00},
-    {0.00, -4.00},
+static_assert(JL_LENGTH(pixelMapXs) == 36 && JL_LENGTH(pixelMapYs) == 36, "bad size");
+PackedLayout pixels(pixelMap);
+
+constexpr int16_t pixelMap2Xs[] = {0, 1, 2, 3, 4, 3, 2, 1, 0, 1, 2, 3, 4, 3, 2, 1, 0, 1, 2, 3, 4, 3, 2, 1, 0, 1, 2, 3,
+                                   4, 3, 2, 1, 0};
+constexpr int16_t pixelMap2Ys[] = {4, 4, 4, 4, 4, 4, 4, 4, 3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1,
+                                   1, 1, 1, 1, 0};
+constexpr PackedPoints pixelMap2 = {
+    .count = 33,
+    .origin = {0.0, -4.0},
+    .xStep = 1.0,
+    .yStep = 1.0,
+    .xs = pixelMap2Xs,
+    .ys = pixelMap2Ys,
+    .emptyBits = nullptr,
 };
 
-static_assert(JL_LENGTH(pixelMap2) == 33, "bad size");
-PixelMap pixels2(JL_LENGTH(pixelMap2), pixelMap2);
+static_assert(JL_LENGTH(pixelMap2Xs) == 33 && JL_LENGTH(pixelMap2Ys) == 33, "bad size");
+PackedLayout pixels2(pixelMap2);
 
 }  // namespace
 
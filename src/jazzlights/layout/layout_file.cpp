@@ -0,0 +1,30 @@
+#include "jazzlights/layout/layout_file.h"
+
+#ifndef ESP32
+
+#include <cstdio>
+
+#include "jazzlights/util/log.h"
+
+namespace jazzlights {
+
+bool ReadLayoutFile(const char* path, std::vector<Point>* points) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    jll_error("Failed to open layout %s", path);
+    return false;
+  }
+  double x, y;
+  int matched;
+  while ((matched = fscanf(file, " %lf , %lf", &x, &y)) == 2) { points->push_back({x, y}); }
+  fclose(file);
+  if (matched != EOF || points->empty()) {
+    jll_error("Failed to parse layout %s after %zu LEDs", path, points->size());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace jazzlights
+
+#endif  // ESP32
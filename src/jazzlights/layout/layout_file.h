@@ -0,0 +1,20 @@
+#ifndef JL_LAYOUT_LAYOUT_FILE_H
+#define JL_LAYOUT_LAYOUT_FILE_H
+
+#ifndef ESP32
+
+#include <vector>
+
+#include "jazzlights/layout/layout.h"
+
+namespace jazzlights {
+
+// Reads a layout with one "x,y" line per LED, in the same units as the layouts in layout_data.cpp. Used by host tools
+// that need the layouts of devices, returns false on failure.
+bool ReadLayoutFile(const char* path, std::vector<Point>* points);
+
+}  // namespace jazzlights
+
+#endif  // ESP32
+
+#endif  // JL_LAYOUT_LAYOUT_FILE_H
@@ -0,0 +1,48 @@
+#ifndef JL_LAYOUT_PACKED_LAYOUT_H
+#define JL_LAYOUT_PACKED_LAYOUT_H
+
+#include <cstdint>
+
+#include "jazzlights/layout/layout.h"
+
+namespace jazzlights {
+
+// Pixel positions on a grid, stored as 16-bit grid coordinates instead of Points. A pixel takes 4 bytes instead of 16,
+// plus one bit in emptyBits. Generate these from Point tables with extras/scripts/pack-layout.py.
+struct PackedPoints {
+  size_t count;
+  // Position of grid coordinates {0, 0}.
+  Point origin;
+  // Distance between consecutive grid coordinates along each axis.
+  Coord xStep;
+  Coord yStep;
+  // Grid coordinates of each pixel, kept in separate arrays so code that processes all pixels can read them directly.
+  const int16_t* xs;
+  const int16_t* ys;
+  // Bit i % 8 of byte i / 8 is set if pixel i has no position, as with EmptyPoint(). Null if no pixel is empty.
+  const uint8_t* emptyBits;
+};
+
+class PackedLayout : public Layout {
+ public:
+  explicit PackedLayout(const PackedPoints& points) : points_(points) {}
+
+  size_t pixelCount() const override { return points_.count; }
+
+  Point at(size_t i) const override {
+    if (isEmpty(i)) { return EmptyPoint(); }
+    return {points_.origin.x + points_.xs[i] * points_.xStep, points_.origin.y + points_.ys[i] * points_.yStep};
+  }
+
+  bool isEmpty(size_t i) const {
+    return points_.emptyBits != nullptr && (points_.emptyBits[i / 8] & (1 << (i % 8))) != 0;
+  }
+
+  const PackedPoints& points() const { return points_; }
+
+ private:
+  const PackedPoints points_;
+};
+
+}  // namespace jazzlights
+#endif  // JL_LAYOUT_PACKED_LAYOUT_H
@@ -0,0 +1,277 @@
+#include "jazzlights/network/ddp.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+
+#ifdef ESP32
+#include <lwip/inet.h>
+#include <lwip/sockets.h>
+#else  // ESP32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif  // ESP32
+
+#include "jazzlights/network/network.h"
+#include "jazzlights/util/log.h"
+
+namespace jazzlights {
+namespace {
+
+static_assert(sizeof(CRGB) == 3, "DDP RGB data is written directly over CRGB arrays");
+
+// Data types that carry 8-bit RGB. Older senders leave the data type undefined or only set the RGB type bits.
+bool IsRgb24DataType(uint8_t dataType) { return dataType == kDdpDataTypeRgb24 || dataType == 0x01 || dataType == 0; }
+
+// Late packets in a row after which we assume the sender restarted its sequence numbers.
+constexpr uint8_t kMaxConsecutiveLatePackets = 3;
+constexpr Milliseconds kSocketRetryInterval = 1000;
+
+}  // namespace
+
+bool ReadDdpHeader(const uint8_t* data, size_t size, DdpHeader* header) {
+  NetworkReader reader(data, size);
+  if (!reader.ReadUint8(&header->flags) || !reader.ReadUint8(&header->sequence) ||
+      !reader.ReadUint8(&header->dataType) || !reader.ReadUint8(&header->destination) ||
+      !reader.ReadUint32(&header->offset) || !reader.ReadUint16(&header->length)) {
+    return false;
+  }
+  if ((header->flags & kDdpFlagsVersionMask) != kDdpFlagsVersion1) { return false; }
+  header->sequence &= kDdpSequenceMask;
+  return size >= header->wireLength();
+}
+
+void WriteDdpHeader(const DdpHeader& header, uint8_t* data) {
+  NetworkWriter writer(data, kDdpHeaderLength);
+  writer.WriteUint8(header.flags & ~kDdpFlagTimecode);
+  writer.WriteUint8(header.sequence & kDdpSequenceMask);
+  writer.WriteUint8(header.dataType);
+  writer.WriteUint8(header.destination);
+  writer.WriteUint32(header.offset);
+  writer.WriteUint16(header.length);
+}
+
+size_t DdpPacketCount(size_t numLeds) {
+  // Empty frames still need a packet to push them.
+  return std::max<size_t>(1, (numLeds * sizeof(CRGB) + kDdpMaxDataLength - 1) / kDdpMaxDataLength);
+}
+
+size_t DdpPacketSize(size_t numLeds, size_t index) {
+  const size_t dataOffset = index * kDdpMaxDataLength;
+  return kDdpHeaderLength + std::min(kDdpMaxDataLength, numLeds * sizeof(CRGB) - dataOffset);
+}
+
+void WriteDdpFrame(const CRGB* colors, size_t numLeds, std::vector<uint8_t>* packets) {
+  const size_t numPackets = DdpPacketCount(numLeds);
+  const size_t numBytes = numLeds * sizeof(CRGB);
+  packets->resize(numPackets * kDdpHeaderLength + numBytes);
+  uint8_t* packet = packets->data();
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(colors);
+  for (size_t index = 0; index < numPackets; index++) {
+    DdpHeader header;
+    header.flags = kDdpFlagsVersion1 | (index == numPackets - 1 ? kDdpFlagPush : 0);
+    header.offset = index * kDdpMaxDataLength;
+    header.length = DdpPacketSize(numLeds, index) - kDdpHeaderLength;
+    WriteDdpHeader(header, packet);
+    if (header.length > 0) { memcpy(packet + kDdpHeaderLength, data + header.offset, header.length); }
+    packet += kDdpHeaderLength + header.length;
+  }
+}
+
+uint8_t SetDdpSequence(uint8_t* packet, uint8_t previousSequence) {
+  const uint8_t sequence = previousSequence % 15 + 1;
+  packet[1] = sequence;
+  return sequence;
+}
+
+// static
+std::unique_ptr<DdpReceiver> DdpReceiver::Create(uint16_t port) {
+  return std::unique_ptr<DdpReceiver>(new DdpReceiver(port));
+}
+
+DdpReceiver::DdpReceiver(uint16_t port) : requestedPort_(port) {}
+
+DdpReceiver::~DdpReceiver() { CloseSocket(); }
+
+void DdpReceiver::AddStrand(size_t numLeds, Renderer* renderer) {
+  Strand strand = {
+      .start = totalBytes_,
+      .numLeds = numLeds,
+      .renderer = renderer,
+      .pixelBuffer = renderer->pixelBuffer(),
+      .staging = {},
+  };
+  if (strand.pixelBuffer == nullptr) { strand.staging.resize(numLeds); }
+  strands_.push_back(std::move(strand));
+  totalBytes_ += numLeds * sizeof(CRGB);
+}
+
+bool DdpReceiver::OpenSocket(Milliseconds currentTime) {
+  if (lastSocketAttemptTime_ >= 0 && currentTime - lastSocketAttemptTime_ < kSocketRetryInterval) { return false; }
+  lastSocketAttemptTime_ = currentTime;
+  socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+  do {
+    if (socket_ < 0) {
+      jll_error("%u DdpReceiver failed to create UDP socket: %s", currentTime, strerror(errno));
+      break;
+    }
+    int one = 1;
+    if (setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0) {
+      jll_error("%u DdpReceiver failed to set reuseaddr option: %s", currentTime, strerror(errno));
+      break;
+    }
+    int flags = fcntl(socket_, F_GETFL) | O_NONBLOCK;
+    if (fcntl(socket_, F_SETFL, flags) < 0) {
+      jll_error("%u DdpReceiver failed to set nonblocking mode: %s", currentTime, strerror(errno));
+      break;
+    }
+    sockaddr_in sin = {};
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(requestedPort_);
+    sin.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(socket_, reinterpret_cast<sockaddr*>(&sin), sizeof(sin)) < 0) {
+      jll_error("%u DdpReceiver failed to bind to port %u: %s", currentTime, requestedPort_, strerror(errno));
+      break;
+    }
+    socklen_t sinLength = sizeof(sin);
+    if (getsockname(socket_, reinterpret_cast<sockaddr*>(&sin), &sinLength) < 0) {
+      jll_error("%u DdpReceiver failed to get bound port: %s", currentTime, strerror(errno));
+      break;
+    }
+    boundPort_ = ntohs(sin.sin_port);
+    jll_info("%u DdpReceiver listening on port %u for %zu LEDs", currentTime, boundPort_, totalBytes_ / sizeof(CRGB));
+    return true;
+  } while (false);
+  CloseSocket();
+  return false;
+}
+
+void DdpReceiver::CloseSocket() {
+  if (socket_ >= 0) { close(socket_); }
+  socket_ = -1;
+  boundPort_ = 0;
+}
+
+bool DdpReceiver::AcceptPacket(const DdpHeader& header, Milliseconds currentTime) {
+  if ((header.flags & (kDdpFlagQuery | kDdpFlagReply | kDdpFlagStorage)) != 0 ||
+      (header.destination != kDdpDestinationDefault && header.destination != 0) || !IsRgb24DataType(header.dataType) ||
+      header.length > kDdpMaxDataLength) {
+    // We only support pixel data for the default output, which is all that video mapping tools send.
+    numDroppedPackets_++;
+    return false;
+  }
+  if (!IsStreaming(currentTime)) {
+    jll_info("%u DdpReceiver stream started", currentTime);
+    lastSequence_ = 0;
+    consecutiveLatePackets_ = 0;
+  }
+  lastPacketTime_ = currentTime;
+  if (header.sequence == 0) { return true; }
+  if (lastSequence_ != 0) {
+    // Sequence numbers go from 1 to 15, so there are 15 of them to wrap around.
+    const uint8_t ahead = (header.sequence + 15 - lastSequence_) % 15;
+    if ((ahead == 0 || ahead > 7) && consecutiveLatePackets_ < kMaxConsecutiveLatePackets) {
+      consecutiveLatePackets_++;
+      numDroppedPackets_++;
+      return false;
+    }
+    if (ahead > 1 && ahead <= 7) { numLostPackets_ += ahead - 1; }
+  }
+  consecutiveLatePackets_ = 0;
+  lastSequence_ = header.sequence;
+  return true;
+}
+
+void DdpReceiver::ComputeIovecs(const DdpHeader& header) {
+  iovecs_.clear();
+  iovecs_.push_back({.iov_base = headerBytes_, .iov_len = header.wireLength()});
+  size_t offset = header.offset;
+  size_t remaining = header.length;
+  for (Strand& strand : strands_) {
+    const size_t strandEnd = strand.start + strand.numLeds * sizeof(CRGB);
+    if (remaining == 0 || offset >= strandEnd) { continue; }
+    const size_t length = std::min(remaining, strandEnd - offset);
+    CRGB* pixels = strand.pixelBuffer != nullptr ? strand.pixelBuffer : strand.staging.data();
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(pixels);
+    iovecs_.push_back({.iov_base = bytes + (offset - strand.start), .iov_len = length});
+    offset += length;
+    remaining -= length;
+  }
+  if (remaining > 0) { iovecs_.push_back({.iov_base = discard_, .iov_len = remaining}); }
+}
+
+bool DdpReceiver::FinishPacket(const DdpHeader& header) {
+  if ((header.flags & kDdpFlagPush) == 0) { return false; }
+  for (Strand& strand : strands_) {
+    if (strand.pixelBuffer != nullptr) { continue; }
+    for (size_t index = 0; index < strand.numLeds; index++) {
+      strand.renderer->renderPixel(index, strand.staging[index]);
+    }
+  }
+  numFrames_++;
+  return true;
+}
+
+bool DdpReceiver::HandlePacket(const uint8_t* packet, size_t size, Milliseconds currentTime) {
+  DdpHeader header;
+  if (!ReadDdpHeader(packet, size, &header) || size < header.wireLength() + header.length) {
+    numDroppedPackets_++;
+    return false;
+  }
+  if (!AcceptPacket(header, currentTime)) { return false; }
+  ComputeIovecs(header);
+  const uint8_t* payload = packet + header.wireLength();
+  for (size_t i = 1; i < iovecs_.size(); i++) {
+    memcpy(iovecs_[i].iov_base, payload, iovecs_[i].iov_len);
+    payload += iovecs_[i].iov_len;
+  }
+  return FinishPacket(header);
+}
+
+bool DdpReceiver::Receive(Milliseconds currentTime) {
+  if (socket_ < 0 && !OpenSocket(currentTime)) { return false; }
+  bool completedFrame = false;
+  while (true) {
+    // Peek at the header first, so that we can then receive the payload directly where it belongs.
+    const ssize_t peeked = recv(socket_, headerBytes_, sizeof(headerBytes_), MSG_PEEK);
+    if (peeked < 0) {
+      if (errno != EWOULDBLOCK && errno != EAGAIN) {
+        jll_error("%u DdpReceiver failed to receive: %s", currentTime, strerror(errno));
+        CloseSocket();
+      }
+      break;
+    }
+    DdpHeader header;
+    const bool validHeader = ReadDdpHeader(headerBytes_, peeked, &header);
+    if (!validHeader) { numDroppedPackets_++; }
+    if (!validHeader || !AcceptPacket(header, currentTime)) {
+      // Consume the packet. The part that does not fit in the buffer is discarded.
+      (void)recv(socket_, headerBytes_, 1, 0);
+      continue;
+    }
+    ComputeIovecs(header);
+    msghdr message = {};
+    message.msg_iov = iovecs_.data();
+    message.msg_iovlen = iovecs_.size();
+    const ssize_t received = recvmsg(socket_, &message, 0);
+    if (received < 0) {
+      jll_error("%u DdpReceiver failed to receive: %s", currentTime, strerror(errno));
+      CloseSocket();
+      break;
+    }
+    if (static_cast<size_t>(received) < header.wireLength() + header.length) {
+      // Whatever part of the payload arrived was already written, but the frame is not complete.
+      numDroppedPackets_++;
+      continue;
+    }
+    if (FinishPacket(header)) { completedFrame = true; }
+  }
+  return completedFrame;
+}
+
+}  // namespace jazzlights
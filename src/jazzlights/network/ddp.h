@@ -0,0 +1,156 @@
+#ifndef JL_NETWORK_DDP_H
+#define JL_NETWORK_DDP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "jazzlights/fastled_wrapper.h"
+#include "jazzlights/renderer.h"
+#include "jazzlights/util/time.h"
+
+// Devices can show pixel frames streamed over UDP instead of their local patterns, see DdpReceiver.
+#ifndef JL_DDP_RECEIVER
+#define JL_DDP_RECEIVER 0
+#endif  // JL_DDP_RECEIVER
+
+struct iovec;
+
+namespace jazzlights {
+
+// Distributed Display Protocol, as sent by xLights, WLED and most video mapping tools. Each UDP packet starts with a
+// 10-byte header, optionally followed by a 4-byte timecode, and then carries length bytes of RGB data to write at
+// offset bytes into the device's pixels. The packet that completes a frame has the push flag set.
+// http://www.3waylabs.com/ddp/
+static constexpr uint16_t kDdpPort = 4048;
+static constexpr size_t kDdpHeaderLength = 10;
+static constexpr size_t kDdpTimecodeLength = 4;
+// Largest amount of pixel data per packet that senders use, 480 RGB pixels fit in a standard Ethernet MTU.
+static constexpr size_t kDdpMaxDataLength = 1440;
+static constexpr uint8_t kDdpFlagsVersionMask = 0xC0;
+static constexpr uint8_t kDdpFlagsVersion1 = 0x40;
+static constexpr uint8_t kDdpFlagTimecode = 0x10;
+static constexpr uint8_t kDdpFlagStorage = 0x08;
+static constexpr uint8_t kDdpFlagReply = 0x04;
+static constexpr uint8_t kDdpFlagQuery = 0x02;
+static constexpr uint8_t kDdpFlagPush = 0x01;
+static constexpr uint8_t kDdpSequenceMask = 0x0F;
+static constexpr uint8_t kDdpDataTypeRgb24 = 0x0B;
+static constexpr uint8_t kDdpDestinationDefault = 1;
+
+struct DdpHeader {
+  uint8_t flags = kDdpFlagsVersion1;
+  // 1 to 15 and wrapping around, 0 means the sender does not number its packets.
+  uint8_t sequence = 0;
+  uint8_t dataType = kDdpDataTypeRgb24;
+  uint8_t destination = kDdpDestinationDefault;
+  uint32_t offset = 0;
+  uint16_t length = 0;
+
+  // Length of the header on the wire, including the timecode if present.
+  size_t wireLength() const {
+    return (flags & kDdpFlagTimecode) != 0 ? kDdpHeaderLength + kDdpTimecodeLength : kDdpHeaderLength;
+  }
+};
+
+// Parses the header at the start of a packet, returns false if it is not a DDP version 1 header.
+bool ReadDdpHeader(const uint8_t* data, size_t size, DdpHeader* header);
+// Writes header without timecode to data, which must hold kDdpHeaderLength bytes.
+void WriteDdpHeader(const DdpHeader& header, uint8_t* data);
+
+// Number of packets that WriteDdpFrame uses for numLeds colors.
+size_t DdpPacketCount(size_t numLeds);
+// Size of packet index out of the DdpPacketCount(numLeds) packets of a frame.
+size_t DdpPacketSize(size_t numLeds, size_t index);
+// Replaces packets with the packets that carry a frame of numLeds colors, back to back, for hosts that stream frames
+// to devices. Every packet but the last one carries kDdpMaxDataLength bytes, and the last one has the push flag.
+// Packets are not numbered, senders that skip frames can number the packets they do send with SetDdpSequence.
+void WriteDdpFrame(const CRGB* colors, size_t numLeds, std::vector<uint8_t>* packets);
+// Numbers packet with the sequence number that follows previousSequence and returns it, pass 0 for the first packet.
+uint8_t SetDdpSequence(uint8_t* packet, uint8_t previousSequence);
+
+// Receives DDP frames and writes them straight into the pixels of the renderers, in the same order as Player renders
+// strands. Renderers that expose their pixelBuffer() receive the packet payloads directly from the socket without
+// any intermediate copy, the others are given the colors through renderPixel when a frame is complete.
+// Colors of a frame are written as packets arrive, so a packet lost in the middle of a frame leaves the colors of the
+// previous frame in its part of the pixels. Packets that arrive after a later one are dropped, since they would
+// overwrite newer colors. This class is not thread-safe, it is meant to be used on the primary runloop.
+class DdpReceiver {
+ public:
+  // Stream frames are shown until no packet was received for this long, then local patterns resume.
+  static constexpr Milliseconds kStreamTimeout = 2000;
+
+  // The socket is opened on the first call to Receive(), so this can be called before networks are up. Port 0 picks
+  // any available port, which is mostly useful for tests.
+  static std::unique_ptr<DdpReceiver> Create(uint16_t port = kDdpPort);
+  ~DdpReceiver();
+  // Disallow copy and move.
+  DdpReceiver(const DdpReceiver&) = delete;
+  DdpReceiver(DdpReceiver&&) = delete;
+  DdpReceiver& operator=(const DdpReceiver&) = delete;
+  DdpReceiver& operator=(DdpReceiver&&) = delete;
+
+  // Appends a strand of numLeds pixels after the ones already added.
+  void AddStrand(size_t numLeds, Renderer* renderer);
+
+  // Reads all pending packets from the socket. Returns whether a frame was completed since the last call.
+  bool Receive(Milliseconds currentTime);
+  // Handles one packet received by other means. Returns whether it completed a frame.
+  bool HandlePacket(const uint8_t* packet, size_t size, Milliseconds currentTime);
+
+  // Whether frames are being streamed, in which case they should be shown instead of local patterns.
+  bool IsStreaming(Milliseconds currentTime) const {
+    return lastPacketTime_ >= 0 && currentTime - lastPacketTime_ < kStreamTimeout;
+  }
+  // Port the socket is bound to, or 0 if it is not open.
+  uint16_t port() const { return boundPort_; }
+
+  // Counters for debugging.
+  uint32_t numFrames() const { return numFrames_; }
+  uint32_t numLostPackets() const { return numLostPackets_; }
+  uint32_t numDroppedPackets() const { return numDroppedPackets_; }
+
+ private:
+  // Bytes of one strand in the concatenation of all strands.
+  struct Strand {
+    size_t start;
+    size_t numLeds;
+    Renderer* renderer;
+    // The pixelBuffer() of renderer, or nullptr if colors are written to staging and then given to renderPixel.
+    CRGB* pixelBuffer;
+    std::vector<CRGB> staging;
+  };
+
+  explicit DdpReceiver(uint16_t port);
+  bool OpenSocket(Milliseconds currentTime);
+  void CloseSocket();
+  // Checks header and updates sequencing state. Returns whether its payload should be written.
+  bool AcceptPacket(const DdpHeader& header, Milliseconds currentTime);
+  // Fills iovecs_ with where the header and then each part of the payload described by header go. Bytes past the last
+  // strand go to discard_.
+  void ComputeIovecs(const DdpHeader& header);
+  // Handles the end of an accepted packet. Returns whether it completed a frame.
+  bool FinishPacket(const DdpHeader& header);
+
+  const uint16_t requestedPort_;
+  uint16_t boundPort_ = 0;
+  int socket_ = -1;
+  Milliseconds lastSocketAttemptTime_ = -1;
+  std::vector<Strand> strands_;
+  size_t totalBytes_ = 0;
+  std::vector<struct ::iovec> iovecs_;
+  uint8_t headerBytes_[kDdpHeaderLength + kDdpTimecodeLength];
+  uint8_t discard_[kDdpMaxDataLength];
+
+  Milliseconds lastPacketTime_ = -1;
+  uint8_t lastSequence_ = 0;
+  uint8_t consecutiveLatePackets_ = 0;
+  uint32_t numFrames_ = 0;
+  uint32_t numLostPackets_ = 0;
+  uint32_t numDroppedPackets_ = 0;
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_NETWORK_DDP_H
@@ -12,7 +12,6 @@
 #include <string>
 #include <unordered_map>
 
-#include "jazzlights/pseudorandom.h"
 #include "jazzlights/util/log.h"
 
 // This is an Arduino header and in theory we shouldn't need it, but see comment near btStarted() below.
@@ -102,6 +101,26 @@ void Esp32BleNetwork::StopAdvertising(Milliseconds currentTime) {
 
 constexpr size_t Esp32BleNetwork::kMaxInnerPayloadLength;
 
+// A 1s interval reproduces the previous behavior of scanning for 500-1000ms between advertisements.
+#if JL_IS_CONFIG(CREATURE)
+// Creatures rely on hearing every neighbor's advertisements to detect them, so we never back off or suppress.
+constexpr SendScheduler::Config kBleSendSchedulerConfig = {
+    .minInterval = 1000,
+    .maxInterval = 1000,
+    .redundancyConstant = 0,
+    .jitterPerNeighbor = 20,
+};
+#else   // CREATURE
+constexpr SendScheduler::Config kBleSendSchedulerConfig = {
+    .minInterval = 1000,
+    .maxInterval = 2000,
+    .redundancyConstant = 2,
+    .jitterPerNeighbor = 20,
+};
+#endif  // CREATURE
+
+Esp32BleNetwork::Esp32BleNetwork() : sendScheduler_(kBleSendSchedulerConfig) {}
+
 void Esp32BleNetwork::MaybeUpdateAdvertisingState(Milliseconds currentTime) {
   bool shouldStopAdvertising = false;
   bool shouldStopScanning = false;
@@ -111,9 +130,9 @@ void Esp32BleNetwork::MaybeUpdateAdvertisingState(Milliseconds currentTime) {
       timeToStopAdvertising_ = 0;
       shouldStopAdvertising = true;
     } else if (state_ == State::kScanning && hasDataToSend_ &&
-               (numUrgentSends_ > 0 || (timeToStopScanning_ > 0 && currentTime >= timeToStopScanning_))) {
+               (numUrgentSends_ > 0 || sendScheduler_.shouldSend(currentTime))) {
       if (numUrgentSends_ > 0) { numUrgentSends_--; }
-      timeToStopScanning_ = 0;
+      sendScheduler_.onSent(currentTime);
       shouldStopScanning = true;
     }
   }
@@ -126,11 +145,6 @@ void Esp32BleNetwork::StopAdvertisingIn(Milliseconds duration) {
   timeToStopAdvertising_ = timeMillis() + duration;
 }
 
-void Esp32BleNetwork::StopScanningIn(Milliseconds duration) {
-  const std::lock_guard<std::mutex> lock(mutex_);
-  timeToStopScanning_ = timeMillis() + duration;
-}
-
 std::list<NetworkMessage> Esp32BleNetwork::getReceivedMessagesImpl(Milliseconds currentTime) {
   std::list<NetworkMessage> results;
   {
@@ -146,6 +160,7 @@ void Esp32BleNetwork::triggerSendAsap(Milliseconds currentTime) {
   {
     const std::lock_guard<std::mutex> lock(mutex_);
     numUrgentSends_ = 10;
+    sendScheduler_.triggerSendAsap(currentTime);
   }
   MaybeUpdateAdvertisingState(currentTime);
 }
@@ -160,11 +175,23 @@ void Esp32BleNetwork::setMessageToSend(const NetworkMessage& messageToSend, Mill
   }
   hasDataToSend_ = true;
   messageToSend_ = messageToSend;
+  sendScheduler_.setMessageToSend(messageToSend, currentTime);
 }
 
 void Esp32BleNetwork::disableSending(Milliseconds currentTime) {
   const std::lock_guard<std::mutex> lock(mutex_);
   hasDataToSend_ = false;
+  sendScheduler_.disableSending();
+}
+
+uint32_t Esp32BleNetwork::getNumSends() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return sendScheduler_.numSent();
+}
+
+uint32_t Esp32BleNetwork::getNumSuppressedSends() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return sendScheduler_.numSuppressed();
 }
 
 // originator: 6
@@ -327,6 +354,7 @@ void Esp32BleNetwork::ReceiveAdvertisement(const NetworkDeviceId& deviceIdentifi
 
   {
     const std::lock_guard<std::mutex> lock(mutex_);
+    sendScheduler_.onMessageReceived(message, localDeviceId_, currentTime);
     if (receivedMessages_.size() > 100) {
       // Make sure we do not run out of memory if no one is
       // periodically calling GetScanResults().
@@ -529,7 +557,6 @@ void Esp32BleNetwork::GapCallbackInner(esp_gap_ble_cb_event_t event, esp_ble_gap
     case ESP_GAP_BLE_SCAN_START_COMPLETE_EVT: {
       ESP32_BLE_DEBUG("%u Scanning has now started", currentTime);
       UpdateState(State::kStartingScan, State::kScanning);
-      StopScanningIn(UnpredictableRandom::GetNumberBetween(500, 1000));
     } break;
     case ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT: {
       ESP32_BLE_DEBUG("%u Scanning has now stopped", currentTime);
@@ -36,6 +36,8 @@ class Esp32BleNetwork : public Network {
   bool shouldEcho() const override { return true; }
   Milliseconds getLastReceiveTime() const override { return lastReceiveTime_; }
   std::string getStatusStr(Milliseconds currentTime) override;
+  uint32_t getNumSends() override;
+  uint32_t getNumSuppressedSends() override;
 
  protected:
   void runLoopImpl(Milliseconds currentTime) override;
@@ -61,7 +63,7 @@ class Esp32BleNetwork : public Network {
   // 29 is dictated by the BLE standard.
   static constexpr size_t kMaxInnerPayloadLength = 29;
 
-  explicit Esp32BleNetwork() {}
+  explicit Esp32BleNetwork();
   void StartScanning(Milliseconds currentTime);
   void StopScanning(Milliseconds currentTime);
   void StartAdvertising(Milliseconds currentTime);
@@ -69,7 +71,6 @@ class Esp32BleNetwork : public Network {
   void StartConfigureAdvertising(Milliseconds currentTime);
   void MaybeUpdateAdvertisingState(Milliseconds currentTime);
   void StopAdvertisingIn(Milliseconds duration);
-  void StopScanningIn(Milliseconds duration);
   void ReceiveAdvertisement(const NetworkDeviceId& deviceIdentifier, uint8_t innerPayloadLength,
                             const uint8_t* innerPayload, int rssi, Milliseconds currentTime);
   uint8_t GetNextInnerPayloadToSend(uint8_t* innerPayload, uint8_t maxInnerPayloadLength, Milliseconds currentTime);
@@ -89,9 +90,9 @@ class Esp32BleNetwork : public Network {
   bool hasDataToSend_ = false;
   NetworkMessage messageToSend_;
   uint8_t numUrgentSends_ = 0;
+  SendScheduler sendScheduler_;
   std::list<NetworkMessage> receivedMessages_;
   Milliseconds timeToStopAdvertising_ = 0;
-  Milliseconds timeToStopScanning_ = 0;
 };
 
 }  // namespace jazzlights
@@ -15,6 +15,7 @@
 #include <lwip/sockets.h>
 #include <string.h>
 
+#include <algorithm>
 #include <sstream>
 
 #include "jazzlights/config.h"
@@ -26,7 +27,9 @@
 namespace jazzlights {
 namespace {
 constexpr size_t kReceiveBufferLength = 1500;
-constexpr Milliseconds kSendInterval = 100;
+// Longest we wait on the socket before checking for a send requested by the primary runloop. When to send is otherwise
+// up to sendScheduler_.
+constexpr Milliseconds kMaxPollTime = 100;
 constexpr uint32_t kNumReconnectsBeforeDelay = 10;
 #if JL_CORE2AWS_ETHERNET
 constexpr int kEthernetPinSCK = 18;
@@ -84,18 +87,33 @@ std::string Esp32EthernetNetwork::getStatusStr(Milliseconds currentTime) {
   }
 }
 
-void Esp32EthernetNetwork::setMessageToSend(const NetworkMessage& messageToSend, Milliseconds /*currentTime*/) {
+void Esp32EthernetNetwork::setMessageToSend(const NetworkMessage& messageToSend, Milliseconds currentTime) {
   const std::lock_guard<std::mutex> lock(mutex_);
   hasDataToSend_ = true;
   messageToSend_ = messageToSend;
+  sendScheduler_.setMessageToSend(messageToSend, currentTime);
 }
 
 void Esp32EthernetNetwork::disableSending(Milliseconds /*currentTime*/) {
   const std::lock_guard<std::mutex> lock(mutex_);
   hasDataToSend_ = false;
+  sendScheduler_.disableSending();
 }
 
-void Esp32EthernetNetwork::triggerSendAsap(Milliseconds /*currentTime*/) {}
+void Esp32EthernetNetwork::triggerSendAsap(Milliseconds currentTime) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  sendScheduler_.triggerSendAsap(currentTime);
+}
+
+uint32_t Esp32EthernetNetwork::getNumSends() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return sendScheduler_.numSent();
+}
+
+uint32_t Esp32EthernetNetwork::getNumSuppressedSends() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return sendScheduler_.numSuppressed();
+}
 
 std::list<NetworkMessage> Esp32EthernetNetwork::getReceivedMessagesImpl(Milliseconds /*currentTime*/) {
   std::list<NetworkMessage> results;
@@ -257,15 +275,19 @@ void Esp32EthernetNetwork::RunTask() {
     return;  // Restart loop.
   }
   NetworkMessage messageToSend;
+  bool shouldSend;
+  Milliseconds nextCheckTime;
+  const Milliseconds currentTime = timeMillis();
   {
     const std::lock_guard<std::mutex> lock(mutex_);
-    messageToSend = messageToSend_;
+    shouldSend = hasDataToSend_ && sendScheduler_.shouldSend(currentTime);
+    if (shouldSend) {
+      messageToSend = messageToSend_;
+      sendScheduler_.onSent(currentTime);
+    }
+    nextCheckTime = sendScheduler_.nextCheckTime();
   }
-  Milliseconds currentTime = timeMillis();
-  if (hasDataToSend_ && (lastSendTime_ < 1 || currentTime - lastSendTime_ >= kSendInterval ||
-                         messageToSend.currentPattern != lastSentPattern_)) {
-    lastSendTime_ = currentTime;
-    lastSentPattern_ = messageToSend.currentPattern;
+  if (shouldSend) {
     if (!WriteUdpPayload(messageToSend, udpPayload_, kReceiveBufferLength, currentTime)) {
       jll_fatal("Esp32EthernetNetwork unexpected payload length issue");
     }
@@ -294,8 +316,9 @@ void Esp32EthernetNetwork::RunTask() {
           .events = POLLIN,
           .revents = 0,
       };
-      Milliseconds timeout = kSendInterval - (timeMillis() - lastSendTime_);
-      int pollRes = poll(&pollFd, 1, timeout);
+      Milliseconds timeout = kMaxPollTime;
+      if (nextCheckTime >= 0) { timeout = std::min(timeout, nextCheckTime - timeMillis()); }
+      int pollRes = poll(&pollFd, 1, std::max<Milliseconds>(timeout, 0));
       if (pollRes > 0) {  // Data available.
         // Do nothing, just restart loop to read.
       } else if (pollRes == 0) {  // Timed out.
@@ -321,6 +344,7 @@ void Esp32EthernetNetwork::RunTask() {
   if (ParseUdpPayload(udpPayload_, n, receiptDetails, currentTime, &receivedMessage)) {
     lastReceiveTime_.store(timeMillis(), std::memory_order_relaxed);
     const std::lock_guard<std::mutex> lock(mutex_);
+    sendScheduler_.onMessageReceived(receivedMessage, localDeviceId_, currentTime);
     receivedMessages_.push_back(receivedMessage);
   }
 }
@@ -338,7 +362,8 @@ NetworkDeviceId Esp32EthernetNetwork::QueryLocalDeviceId() {
 }
 
 Esp32EthernetNetwork::Esp32EthernetNetwork()
-    : eventQueue_(xQueueCreate(/*num_queue_items=*/1, /*queue_item_size=*/sizeof(Esp32EthernetNetworkEvent))) {
+    : eventQueue_(xQueueCreate(/*num_queue_items=*/1, /*queue_item_size=*/sizeof(Esp32EthernetNetworkEvent))),
+      sendScheduler_(kUdpSendSchedulerConfig) {
   if (eventQueue_ == nullptr) { jll_fatal("Failed to create Esp32EthernetNetwork queue"); }
   udpPayload_ = reinterpret_cast<uint8_t*>(malloc(kReceiveBufferLength));
   if (udpPayload_ == nullptr) {
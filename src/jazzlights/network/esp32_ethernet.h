@@ -31,6 +31,8 @@ class Esp32EthernetNetwork : public Network {
   void triggerSendAsap(Milliseconds currentTime) override;
   bool shouldEcho() const override { return false; }
   Milliseconds getLastReceiveTime() const override { return lastReceiveTime_.load(std::memory_order_relaxed); }
+  uint32_t getNumSends() override;
+  uint32_t getNumSuppressedSends() override;
 
  protected:
   std::list<NetworkMessage> getReceivedMessagesImpl(Milliseconds currentTime) override;
@@ -71,14 +73,13 @@ class Esp32EthernetNetwork : public Network {
   struct in_addr multicastAddress_ = {};  // Only modified in constructor.
   int socket_ = -1;                       // Only used on our task.
   uint8_t* udpPayload_ = nullptr;         // Only used on our task. Used for both sending and receiving.
-  Milliseconds lastSendTime_ = -1;        // Only used on our task.
-  PatternBits lastSentPattern_ = 0;       // Only used on our task.
   std::atomic<Milliseconds> lastReceiveTime_;
   std::mutex mutex_;
   struct in_addr localAddress_ = {};            // Protected by mutex_.
   bool hasDataToSend_ = false;                  // Protected by mutex_.
   NetworkMessage messageToSend_;                // Protected by mutex_.
   std::list<NetworkMessage> receivedMessages_;  // Protected by mutex_.
+  SendScheduler sendScheduler_;                 // Protected by mutex_.
 };
 
 }  // namespace jazzlights
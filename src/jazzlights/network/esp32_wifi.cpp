@@ -9,6 +9,7 @@
 #include <lwip/sockets.h>
 #include <string.h>
 
+#include <algorithm>
 #include <sstream>
 
 #include "jazzlights/esp32_shared.h"
@@ -19,7 +20,9 @@
 namespace jazzlights {
 namespace {
 constexpr size_t kReceiveBufferLength = 1500;
-constexpr Milliseconds kSendInterval = 100;
+// Longest we wait on the socket before checking for a send requested by the primary runloop. When to send is otherwise
+// up to sendScheduler_.
+constexpr Milliseconds kMaxPollTime = 100;
 constexpr uint32_t kNumReconnectsBeforeDelay = 10;
 
 std::string WiFiReasonToString(uint8_t reason) {
@@ -113,25 +116,59 @@ std::string Esp32WiFiNetwork::getStatusStr(Milliseconds currentTime) {
   }
 }
 
-void Esp32WiFiNetwork::setMessageToSend(const NetworkMessage& messageToSend, Milliseconds /*currentTime*/) {
+void Esp32WiFiNetwork::setMessageToSend(const NetworkMessage& messageToSend, Milliseconds currentTime) {
   const std::lock_guard<std::mutex> lock(mutex_);
   hasDataToSend_ = true;
   messageToSend_ = messageToSend;
+  sendScheduler_.setMessageToSend(messageToSend, currentTime);
 }
 
 void Esp32WiFiNetwork::disableSending(Milliseconds /*currentTime*/) {
   const std::lock_guard<std::mutex> lock(mutex_);
   hasDataToSend_ = false;
+  sendScheduler_.disableSending();
 }
 
-void Esp32WiFiNetwork::triggerSendAsap(Milliseconds /*currentTime*/) {}
+void Esp32WiFiNetwork::triggerSendAsap(Milliseconds currentTime) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  sendScheduler_.triggerSendAsap(currentTime);
+}
+
+uint32_t Esp32WiFiNetwork::getNumSends() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return sendScheduler_.numSent();
+}
 
-std::list<NetworkMessage> Esp32WiFiNetwork::getReceivedMessagesImpl(Milliseconds /*currentTime*/) {
+uint32_t Esp32WiFiNetwork::getNumSuppressedSends() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return sendScheduler_.numSuppressed();
+}
+
+std::list<NetworkMessage> Esp32WiFiNetwork::getReceivedMessagesImpl(Milliseconds currentTime) {
   std::list<NetworkMessage> results;
-  {
+  ReceivedMessage receivedMessage;
+  while (receivedMessages_.TryPop(&receivedMessage)) {
+    std::ostringstream s;
+    char addressString[INET_ADDRSTRLEN] = {};
+    if (inet_ntop(AF_INET, &receivedMessage.senderAddress, addressString, sizeof(addressString)) == nullptr) {
+      jll_fatal("Esp32WiFiNetwork printing receive address failed with error %d: %s", errno, strerror(errno));
+    }
+    s << " (from " << addressString << ":" << receivedMessage.senderPort << ")";
+    receivedMessage.message.receiptDetails = s.str();
+    results.push_back(std::move(receivedMessage.message));
+  }
+  if (!results.empty()) {
+    // Done here rather than on our task so that receiving never waits for mutex_.
     const std::lock_guard<std::mutex> lock(mutex_);
-    results = std::move(receivedMessages_);
-    receivedMessages_.clear();
+    for (const NetworkMessage& message : results) {
+      sendScheduler_.onMessageReceived(message, localDeviceId_, currentTime);
+    }
+  }
+  const uint32_t numDroppedReceivedMessages = numDroppedReceivedMessages_.load(std::memory_order_relaxed);
+  if (numDroppedReceivedMessages != numReportedDroppedReceivedMessages_) {
+    jll_error("%u Esp32WiFiNetwork receive queue full, dropped %" PRIu32 " messages (%" PRIu32 " total)", currentTime,
+              numDroppedReceivedMessages - numReportedDroppedReceivedMessages_, numDroppedReceivedMessages);
+    numReportedDroppedReceivedMessages_ = numDroppedReceivedMessages;
   }
   return results;
 }
@@ -307,15 +344,19 @@ void Esp32WiFiNetwork::RunTask() {
     return;  // Restart loop.
   }
   NetworkMessage messageToSend;
+  bool shouldSend;
+  Milliseconds nextCheckTime;
+  const Milliseconds currentTime = timeMillis();
   {
     const std::lock_guard<std::mutex> lock(mutex_);
-    messageToSend = messageToSend_;
+    shouldSend = hasDataToSend_ && sendScheduler_.shouldSend(currentTime);
+    if (shouldSend) {
+      messageToSend = messageToSend_;
+      sendScheduler_.onSent(currentTime);
+    }
+    nextCheckTime = sendScheduler_.nextCheckTime();
   }
-  Milliseconds currentTime = timeMillis();
-  if (hasDataToSend_ && (lastSendTime_ < 1 || currentTime - lastSendTime_ >= kSendInterval ||
-                         messageToSend.currentPattern != lastSentPattern_)) {
-    lastSendTime_ = currentTime;
-    lastSentPattern_ = messageToSend.currentPattern;
+  if (shouldSend) {
     if (!WriteUdpPayload(messageToSend, udpPayload_, kReceiveBufferLength, currentTime)) {
       jll_fatal("Esp32WiFiNetwork unexpected payload length issue");
     }
@@ -331,48 +372,54 @@ void Esp32WiFiNetwork::RunTask() {
     (void)writeRes;
   }
 
-  // Now receive.
-  sockaddr_in sin = {};
-  socklen_t sinLength = sizeof(sin);
-  ssize_t n =
-      recvfrom(socket_, udpPayload_, kReceiveBufferLength, /*flags=*/0, reinterpret_cast<sockaddr*>(&sin), &sinLength);
-  if (n < 0) {
-    const int errorCode = errno;
-    static_assert(EWOULDBLOCK == EAGAIN, "need to handle these separately");
-    if (errorCode == EWOULDBLOCK) {
-      struct pollfd pollFd = {
-          .fd = socket_,
-          .events = POLLIN,
-          .revents = 0,
-      };
-      Milliseconds timeout = kSendInterval - (timeMillis() - lastSendTime_);
-      int pollRes = poll(&pollFd, 1, timeout);
-      if (pollRes > 0) {  // Data available.
-        // Do nothing, just restart loop to read.
-      } else if (pollRes == 0) {  // Timed out.
-                                  // Do nothing, just restart loop to write.
-      } else {                    // Error.
-        jll_error("%u Esp32WiFiNetwork poll failed with error %d: %s", timeMillis(), errno, strerror(errno));
-        CreateSocket();
+  // Now receive everything that is already waiting on the socket, so a burst of messages only takes one wakeup. We
+  // stop early if it is time to send, so that a flood of incoming messages cannot keep us from sending.
+  Milliseconds receiveDeadline = currentTime + kMaxPollTime;
+  if (nextCheckTime >= 0) { receiveDeadline = std::min(receiveDeadline, nextCheckTime); }
+  while (timeMillis() < receiveDeadline) {
+    sockaddr_in sin = {};
+    socklen_t sinLength = sizeof(sin);
+    ssize_t n = recvfrom(socket_, udpPayload_, kReceiveBufferLength, /*flags=*/0, reinterpret_cast<sockaddr*>(&sin),
+                         &sinLength);
+    if (n < 0) {
+      const int errorCode = errno;
+      static_assert(EWOULDBLOCK == EAGAIN, "need to handle these separately");
+      if (errorCode == EWOULDBLOCK) {
+        struct pollfd pollFd = {
+            .fd = socket_,
+            .events = POLLIN,
+            .revents = 0,
+        };
+        const Milliseconds timeout = std::max<Milliseconds>(receiveDeadline - timeMillis(), 0);
+        int pollRes = poll(&pollFd, 1, timeout);
+        if (pollRes > 0) {  // Data available.
+          // Do nothing, just restart loop to read.
+        } else if (pollRes == 0) {  // Timed out.
+                                    // Do nothing, just restart loop to write.
+        } else {                    // Error.
+          jll_error("%u Esp32WiFiNetwork poll failed with error %d: %s", timeMillis(), errno, strerror(errno));
+          CreateSocket();
+        }
+        return;  // Restart loop.
+      }
+      jll_error("%u Esp32WiFiNetwork recvfrom failed with error %d: %s", timeMillis(), errno, strerror(errno));
+      CreateSocket();
+      return;
+    }
+    // receiptDetails is filled in by the primary runloop, formatting it here would allocate.
+    ReceivedMessage receivedMessage = {
+        .message = {},
+        .senderAddress = sin.sin_addr,
+        .senderPort = ntohs(sin.sin_port),
+    };
+    const Milliseconds receiveTime = timeMillis();
+    if (ParseUdpPayload(udpPayload_, n, /*receiptDetails=*/std::string(), receiveTime, &receivedMessage.message)) {
+      lastReceiveTime_.store(receiveTime, std::memory_order_relaxed);
+      if (!receivedMessages_.TryPush(receivedMessage)) {
+        // Logged by the primary runloop, logging here would only make us fall further behind.
+        numDroppedReceivedMessages_.fetch_add(1, std::memory_order_relaxed);
       }
-      return;  // Restart loop.
     }
-    jll_error("%u Esp32WiFiNetwork recvfrom failed with error %d: %s", timeMillis(), errno, strerror(errno));
-    CreateSocket();
-    return;
-  }
-  std::ostringstream s;
-  char addressString[INET_ADDRSTRLEN] = {};
-  if (inet_ntop(AF_INET, &(sin.sin_addr), addressString, sizeof(addressString)) == nullptr) {
-    jll_fatal("Esp32WiFiNetwork printing receive address failed with error %d: %s", errno, strerror(errno));
-  }
-  s << " (from " << addressString << ":" << ntohs(sin.sin_port) << ")";
-  std::string receiptDetails = s.str();
-  NetworkMessage receivedMessage;
-  if (ParseUdpPayload(udpPayload_, n, receiptDetails, currentTime, &receivedMessage)) {
-    lastReceiveTime_.store(timeMillis(), std::memory_order_relaxed);
-    const std::lock_guard<std::mutex> lock(mutex_);
-    receivedMessages_.push_back(receivedMessage);
   }
 }
 
@@ -409,7 +456,8 @@ NetworkDeviceId Esp32WiFiNetwork::InitWiFiStackAndQueryLocalDeviceId() {
 }
 
 Esp32WiFiNetwork::Esp32WiFiNetwork()
-    : eventQueue_(xQueueCreate(/*num_queue_items=*/1, /*queue_item_size=*/sizeof(Esp32WiFiNetworkEvent))) {
+    : eventQueue_(xQueueCreate(/*num_queue_items=*/1, /*queue_item_size=*/sizeof(Esp32WiFiNetworkEvent))),
+      sendScheduler_(kUdpSendSchedulerConfig) {
   if (eventQueue_ == nullptr) { jll_fatal("Failed to create Esp32WiFiNetwork queue"); }
   udpPayload_ = reinterpret_cast<uint8_t*>(malloc(kReceiveBufferLength));
   if (udpPayload_ == nullptr) {
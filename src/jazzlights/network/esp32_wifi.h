@@ -15,6 +15,7 @@
 #include <mutex>
 
 #include "jazzlights/network/network.h"
+#include "jazzlights/util/spsc_ring.h"
 
 namespace jazzlights {
 
@@ -32,12 +33,23 @@ class Esp32WiFiNetwork : public Network {
   void triggerSendAsap(Milliseconds currentTime) override;
   bool shouldEcho() const override { return false; }
   Milliseconds getLastReceiveTime() const override { return lastReceiveTime_.load(std::memory_order_relaxed); }
+  uint32_t getNumSends() override;
+  uint32_t getNumSuppressedSends() override;
 
  protected:
   std::list<NetworkMessage> getReceivedMessagesImpl(Milliseconds currentTime) override;
   void runLoopImpl(Milliseconds /*currentTime*/) override {}
 
  private:
+  // Received messages that the primary runloop has not picked up yet. Messages received when this is full are dropped.
+  static constexpr size_t kReceiveQueueCapacity = 32;
+  // What our task hands to the primary runloop. message.receiptDetails is left empty and built from the sender's
+  // address on the primary runloop, so that queueing a message never allocates.
+  struct ReceivedMessage {
+    NetworkMessage message;
+    struct in_addr senderAddress;
+    uint16_t senderPort;  // In host byte order.
+  };
   struct Esp32WiFiNetworkEvent {
     enum class Type {
       kReserved = 0,
@@ -74,16 +86,18 @@ class Esp32WiFiNetwork : public Network {
   struct in_addr multicastAddress_ = {};            // Only modified in constructor.
   int socket_ = -1;                                 // Only used on our task.
   uint8_t* udpPayload_ = nullptr;                   // Only used on our task. Used for both sending and receiving.
-  Milliseconds lastSendTime_ = -1;                  // Only used on our task.
-  PatternBits lastSentPattern_ = 0;                 // Only used on our task.
   bool shouldArmQueueReconnectionTimeout_ = false;  // Only used on our task.
   uint32_t reconnectCount_ = 0;                     // Only used on our task.
   std::atomic<Milliseconds> lastReceiveTime_;
+  // Produced by our task and consumed by the primary runloop, so that neither ever waits for the other to receive.
+  SpscRing<ReceivedMessage, kReceiveQueueCapacity> receivedMessages_;
+  std::atomic<uint32_t> numDroppedReceivedMessages_{0};
+  uint32_t numReportedDroppedReceivedMessages_ = 0;  // Only used on the primary runloop.
   std::mutex mutex_;
-  struct in_addr localAddress_ = {};            // Protected by mutex_.
-  bool hasDataToSend_ = false;                  // Protected by mutex_.
-  NetworkMessage messageToSend_;                // Protected by mutex_.
-  std::list<NetworkMessage> receivedMessages_;  // Protected by mutex_.
+  struct in_addr localAddress_ = {};  // Protected by mutex_.
+  bool hasDataToSend_ = false;        // Protected by mutex_.
+  NetworkMessage messageToSend_;      // Protected by mutex_.
+  SendScheduler sendScheduler_;       // Protected by mutex_.
 };
 
 }  // namespace jazzlights
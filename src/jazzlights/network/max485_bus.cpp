@@ -11,8 +11,6 @@
 #include <atomic>
 #include <cstdint>
 #include <cstring>
-#include <deque>
-#include <mutex>
 
 #include "jazzlights/esp32_shared.h"
 #include "jazzlights/network/network.h"
@@ -53,7 +51,7 @@ namespace jazzlights {
 
 namespace {
 
-constexpr size_t kMaxMessageLength = 100;
+constexpr size_t kMaxMessageLength = kOrreryMessageMaxEncodedLength;
 
 constexpr size_t ComputeExpansion(size_t length) {
   return /*separator*/ 1 + /*destBusID*/ 1 + /*srcBusID*/ 1 + CobsMaxEncodedSize(length + /*CRC32*/ sizeof(uint32_t)) +
@@ -66,8 +64,19 @@ static_assert(kUartDriverBufferSize >= kMaxEncodedMessageLength, "bad size");
 
 // This timeout formula was established based on the following empirical measurements using a 10m shiedled cable.
 // In (message size in bytes, maximum observed RTT in ms) pairs: (50, 14), (100, 23), (500, 92), (1000, 180).
+// It is used until we have measured a follower's RTT, and as an upper bound afterwards.
 constexpr Milliseconds kUartResponseTimeoutMs = ((kMaxMessageLength * 2) / 5) + 10;
-constexpr TickType_t kLeaderReceiveDelay = kUartResponseTimeoutMs / portTICK_PERIOD_MS;
+
+static_assert(Max485BusHandler::kMaxBusIds <= 32, "pending bus IDs must fit in a uint32_t bitmask");
+static_assert(static_cast<BusId>(Planet::Sun) < Max485BusHandler::kMaxBusIds, "bad size");
+
+constexpr Max485PollScheduler::Config kPollSchedulerConfig = {
+    // Slightly below the RTT of the smallest messages we've measured, the per-follower estimate takes it from there.
+    .minResponseTimeout = 10,
+    .maxResponseTimeout = kUartResponseTimeoutMs,
+    .timeoutsBeforeBackoff = 3,
+    .maxBackoffCycles = 32,
+};
 
 }  // namespace
 
@@ -77,7 +86,6 @@ Max485BusHandler::Max485BusHandler(uart_port_t uartPort, int txPin, int rxPin, B
     : uartPort_(uartPort),
       txPin_(txPin),
       rxPin_(rxPin),
-      receiveDelay_(busIdSelf == kBusIdLeader ? kLeaderReceiveDelay : portMAX_DELAY),
       busIdSelf_(busIdSelf),
       taskSendMessageBuffer_(kMaxMessageLength),
       taskEncodedSendMessageBuffer_(kMaxEncodedMessageLength),
@@ -117,8 +125,13 @@ void Max485BusHandler::SendToUart(BufferViewU8 encodedData) {
 }
 
 void Max485BusHandler::RunTask() {
+  TickType_t receiveDelay = portMAX_DELAY;
+  if (taskWakeupTime_ >= 0) {
+    const Milliseconds timeUntilWakeup = taskWakeupTime_ - timeMillis();
+    receiveDelay = timeUntilWakeup > 0 ? pdMS_TO_TICKS(timeUntilWakeup) : 0;
+  }
   uart_event_t event;
-  if (!xQueueReceive(queue_, &event, receiveDelay_)) {
+  if (!xQueueReceive(queue_, &event, receiveDelay)) {
     // Timed out waiting to receive something.
     HandleApplicationDataAvailableToSend(/*firstSend=*/false);
     return;
@@ -153,22 +166,19 @@ void Max485BusHandler::RunTask() {
               }
 #endif  // JL_LOG_MAX485_MESSAGES
               if (destBusId == GetBusIdSelf() || destBusId == kBusIdBroadcast) {
-                {
-                  const std::lock_guard<std::mutex> lock(recvMutex_);
-                  static constexpr size_t kMaxRecvQueueSize = 16;
-                  if (sharedReceivedMessages_.size() > kMaxRecvQueueSize) {
-                    jll_error("%u Max485 receive queue full, dropping some messages", timeMillis());
-                    for (size_t i = 0; i < kMaxRecvQueueSize / 2; i++) { sharedReceivedMessages_.pop_front(); }
-                  }
-                  Milliseconds rtt = -1;
-                  if (destBusId == GetBusIdSelf() && taskLastSendTimeExpectingResponse_ >= 0) {
-                    rtt = timeMillis() - taskLastSendTimeExpectingResponse_;
-                    taskLastSendTimeExpectingResponse_ = -1;
-                  }
-                  sharedReceivedMessages_.push_back(
-                      {.srcBusId = srcBusId, .destBusId = destBusId, .message = orreryMessage, .rtt = rtt});
+                Milliseconds rtt = -1;
+                if (destBusId == GetBusIdSelf() && srcBusId == taskLastSendBusIdExpectingResponse_ &&
+                    taskLastSendTimeExpectingResponse_ >= 0) {
+                  rtt = timeMillis() - taskLastSendTimeExpectingResponse_;
+                  taskLastSendTimeExpectingResponse_ = -1;
+                  taskLastSendBusIdExpectingResponse_ = kSeparator;
                 }
-                if (destBusId == GetBusIdSelf()) { HandleReceivedMessage(srcBusId, orreryMessage); }
+                if (!sharedReceivedMessages_.TryPush(
+                        {.srcBusId = srcBusId, .destBusId = destBusId, .message = orreryMessage, .rtt = rtt})) {
+                  jll_error("%u Max485 receive queue full, dropping message from %d", timeMillis(),
+                            static_cast<int>(srcBusId));
+                }
+                if (destBusId == GetBusIdSelf()) { HandleReceivedMessage(srcBusId, orreryMessage, rtt); }
               } else {
                 jll_fatal("%u Unexpected bus ID %d", timeMillis(), static_cast<int>(destBusId));
               }
@@ -251,31 +261,23 @@ BufferViewU8 Max485BusHandler::EncodeMessage(const BufferViewU8 message, OwnedBu
   return encodedMessage;
 }
 
-void Max485BusHandler::CopyEncodeAndSendMessage(BusId destBusId) {
-  OrreryMessage msg;
-  bool found = false;
-  {
-    const std::lock_guard<std::mutex> lock(sendMutex_);
-    auto it = sharedSendMessages_.find(destBusId);
-    if (it != sharedSendMessages_.end()) {
-      msg = it->second;
-      found = true;
-      if (destBusId == kBusIdBroadcast) { sharedSendMessages_.erase(it); }
-    }
+bool Max485BusHandler::CopyEncodeAndSendMessage(BusId destBusId) {
+  if (destBusId >= kMaxBusIds || (sharedPopulatedBusIds_.load(std::memory_order_acquire) & (1u << destBusId)) == 0) {
+    return false;
   }
-  if (!found) { return; }
+  const OrreryMessage msg = sharedSendMessages_[destBusId].Load();
 
   NetworkWriter writer(&taskSendMessageBuffer_[0], taskSendMessageBuffer_.size());
   if (!WriteOrreryMessage(msg, writer)) {
     jll_error("%u Failed to serialize OrreryMessage", timeMillis());
-    return;
+    return false;
   }
   // Modify this constant to force padding. This allows measuring the RTT.
   static constexpr size_t kMessageMinSize = 0;
   while (writer.LengthWritten() < kMessageMinSize) {
     if (!writer.WriteUint8(0)) {
       jll_error("%u Failed to write padding", timeMillis());
-      return;
+      return false;
     }
   }
   BufferViewU8 taskSendMessage(&taskSendMessageBuffer_[0], writer.LengthWritten());
@@ -293,20 +295,30 @@ void Max485BusHandler::CopyEncodeAndSendMessage(BusId destBusId) {
                          static_cast<int>(destBusId));
   BufferViewU8 taskEncodedSendMessage =
       EncodeMessage(taskSendMessage, taskEncodedSendMessageBuffer_, destBusId, busIdSelf);
-  if (!taskEncodedSendMessage.empty()) {
-    SendToUart(taskEncodedSendMessage);
-    if (busIdSelf == kBusIdLeader && destBusId != kBusIdBroadcast) {
-      taskLastSendTimeExpectingResponse_ = timeMillis();
-    }
+  if (taskEncodedSendMessage.empty()) { return false; }
+  SendToUart(taskEncodedSendMessage);
+  if (busIdSelf == kBusIdLeader && destBusId != kBusIdBroadcast) {
+    taskLastSendTimeExpectingResponse_ = timeMillis();
+    taskLastSendBusIdExpectingResponse_ = destBusId;
   }
+  return true;
 }
 
 bool Max485BusHandler::SetMessageToSendInner(BusId destBusId, const OrreryMessage& message) {
-  const std::lock_guard<std::mutex> lock(sendMutex_);
-  auto it = sharedSendMessages_.find(destBusId);
-  bool isNew = (it == sharedSendMessages_.end() || it->second != message);
-  if (isNew) { sharedSendMessages_[destBusId] = message; }
-  return isNew;
+  if (destBusId >= kMaxBusIds) {
+    jll_error("%u Cannot send Max485 message to bus ID %d", timeMillis(), static_cast<int>(destBusId));
+    return false;
+  }
+  const uint32_t busIdBit = 1u << destBusId;
+  // We are the only writer, so reading back our own last write cannot race.
+  if ((sharedPopulatedBusIds_.load(std::memory_order_relaxed) & busIdBit) != 0 &&
+      sharedSendMessages_[destBusId].Load() == message) {
+    return false;
+  }
+  sharedSendMessages_[destBusId].Store(message);
+  sharedPopulatedBusIds_.fetch_or(busIdBit, std::memory_order_release);
+  sharedPendingBusIds_.fetch_or(busIdBit, std::memory_order_release);
+  return true;
 }
 
 // static
@@ -388,14 +400,12 @@ void Max485BusHandler::ShiftTaskRecvBuffer(size_t messageStartIndex) {
 
 bool Max485BusHandler::ReadMessage(OrreryMessage* message, BusId* destBusId, BusId* srcBusId, Milliseconds* rtt) {
   if (!IsReady()) { return false; }
-  const std::lock_guard<std::mutex> lock(recvMutex_);
-  if (sharedReceivedMessages_.empty()) { return false; }
-  const ReceivedMessage& rm = sharedReceivedMessages_.front();
+  ReceivedMessage rm;
+  if (!sharedReceivedMessages_.TryPop(&rm)) { return false; }
   *message = rm.message;
   *destBusId = rm.destBusId;
   *srcBusId = rm.srcBusId;
   if (rtt != nullptr) { *rtt = rm.rtt; }
-  sharedReceivedMessages_.pop_front();
   return true;
 }
 
@@ -468,77 +478,82 @@ BufferViewU8 Max485BusHandler::TaskFindReceivedMessage(BusId* destBusId, BusId*
 }
 
 Max485BusLeader::Max485BusLeader(uart_port_t uartPort, int txPin, int rxPin)
-    : Max485BusHandler(uartPort, txPin, rxPin, kBusIdLeader) {}
+    : Max485BusHandler(uartPort, txPin, rxPin, kBusIdLeader), pollScheduler_(kPollSchedulerConfig) {}
 
-void Max485BusLeader::HandleReceivedMessage(BusId srcBusId, const OrreryMessage& /*message*/) {
-  followerStates_[srcBusId].timeoutCount = 0;
-  followerStates_[srcBusId].skipCount = 0;
+void Max485BusLeader::HandleReceivedMessage(BusId srcBusId, const OrreryMessage& /*message*/, Milliseconds rtt) {
+  if (srcBusId != awaitingResponseFrom_) {
+    // This is a late response to a request we already gave up on. The follower is alive but we are now waiting on
+    // someone else, so don't send anything that could collide with their response.
+    pollScheduler_.OnHeardFrom(srcBusId);
+    return;
+  }
+  if (rtt >= 0) {
+    pollScheduler_.OnResponse(srcBusId, rtt);
+  } else {
+    pollScheduler_.OnHeardFrom(srcBusId);
+  }
+  awaitingResponseFrom_ = kSeparator;
   SendMessageToNextFollower();
 }
 
 void Max485BusLeader::HandleApplicationDataAvailableToSend(bool firstSend) {
-  bool shouldSend = false;
-  if (firstSend && taskLastSendTimeExpectingResponse_ < 0) {
-    jll_info("%u Initiating first send", timeMillis());
-    shouldSend = true;
-  } else if (lastSentBusId_ != kSeparator &&
-             timeMillis() - taskLastSendTimeExpectingResponse_ > kUartResponseTimeoutMs) {
-    followerStates_[lastSentBusId_].timeoutCount++;
-    jll_timeout("%u Timed out waiting for response from %d, count is now %d", timeMillis(),
-                static_cast<int>(lastSentBusId_), followerStates_[lastSentBusId_].timeoutCount);
-    shouldSend = true;
+  if (awaitingResponseFrom_ == kSeparator) {
+    if (firstSend && !hasSentFirstMessage_) { jll_info("%u Initiating first send", timeMillis()); }
+    SendMessageToNextFollower();
+  } else if (timeMillis() >= taskWakeupTime_) {
+    const BusId timedOutBusId = awaitingResponseFrom_;
+    pollScheduler_.OnTimeout(timedOutBusId);
+    jll_timeout("%u Timed out waiting for response from %d, next timeout %d ms%s", timeMillis(),
+                static_cast<int>(timedOutBusId), static_cast<int>(pollScheduler_.ResponseTimeout(timedOutBusId)),
+                (pollScheduler_.IsBackingOff(timedOutBusId) ? ", backing off" : ""));
+    awaitingResponseFrom_ = kSeparator;
+    SendMessageToNextFollower();
   } else {
     jll_max485_data("%u Ignoring %sfirstSend kApplicationDataAvailable", timeMillis(), (firstSend ? "" : "!"));
   }
-  if (shouldSend) { SendMessageToNextFollower(); }
 }
 
 void Max485BusLeader::SendMessageToNextFollower() {
-  BusId destBusId = kSeparator;
-  {
-    const std::lock_guard<std::mutex> lock(sendMutex_);
-    if (!highPriorityBusIds_.empty()) {
-      destBusId = highPriorityBusIds_.front();
-      highPriorityBusIds_.pop_front();
-    } else {
-      if (sharedSendMessages_.empty()) { return; }
-      BusId candidate = lastSentBusId_;
-      BusId firstCandidate = kSeparator;
-      for (size_t i = 0; i < sharedSendMessages_.size(); i++) {
-        auto it = sharedSendMessages_.upper_bound(candidate);
-        if (it == sharedSendMessages_.end()) { it = sharedSendMessages_.begin(); }
-        candidate = it->first;
-        if (candidate == kBusIdBroadcast) { continue; }
-        if (firstCandidate == kSeparator) { firstCandidate = candidate; }
-        FollowerState& state = followerStates_[candidate];
-        if (state.timeoutCount >= 3) {
-          // If a follower has timed out 3 times in a row, skip it 9 times.
-          if (state.skipCount < 9) {
-            state.skipCount++;
-            continue;
-          } else {
-            state.skipCount = 0;
-          }
-        }
+  // Broadcasts don't get a response so we can move on right away, which means this can send more than once. The bound
+  // on the number of attempts ensures we can't spin if messages fail to send.
+  for (size_t attempt = 0; attempt < Max485PollScheduler::kMaxFollowers + 1; attempt++) {
+    // Changed messages go out first, broadcasts before messages to individual followers. Those go round-robin in bus ID
+    // order starting after the last one we picked, so followers whose message keeps changing can't starve the others.
+    BusId destBusId = kSeparator;
+    uint32_t pendingBusIds = sharedPendingBusIds_.load(std::memory_order_acquire);
+    while (destBusId == kSeparator && pendingBusIds != 0) {
+      uint32_t nextBusIds = pendingBusIds & (1u << kBusIdBroadcast);
+      if (nextBusIds == 0) { nextBusIds = pendingBusIds & ~((2u << lastPendingBusId_) - 1); }
+      if (nextBusIds == 0) { nextBusIds = pendingBusIds; }
+      const BusId candidate = static_cast<BusId>(__builtin_ctz(nextBusIds));
+      pendingBusIds &= ~(1u << candidate);
+      sharedPendingBusIds_.fetch_and(~(1u << candidate), std::memory_order_acq_rel);
+      if (candidate != kBusIdBroadcast) { lastPendingBusId_ = candidate; }
+      if (candidate == kBusIdBroadcast) {
+        destBusId = candidate;
+      } else if (!pollScheduler_.AddFollower(candidate)) {
+        jll_error("%u Too many Max485 followers, ignoring %d", timeMillis(), static_cast<int>(candidate));
+      } else if (!pollScheduler_.IsBackingOff(candidate)) {
+        // Followers that are backing off will still get their latest message when they are next probed.
         destBusId = candidate;
-        break;
       }
-      // If all followers are skipped, use the first one.
-      if (destBusId == kSeparator) { destBusId = firstCandidate; }
     }
+    if (destBusId == kSeparator) { destBusId = pollScheduler_.NextFollower(); }
+    if (destBusId == kSeparator) { break; }
+    if (!CopyEncodeAndSendMessage(destBusId)) { continue; }
+    hasSentFirstMessage_ = true;
+    if (destBusId == kBusIdBroadcast) { continue; }
+    awaitingResponseFrom_ = destBusId;
+    taskWakeupTime_ = timeMillis() + pollScheduler_.ResponseTimeout(destBusId);
+    return;
   }
-  if (destBusId != kSeparator) {
-    CopyEncodeAndSendMessage(destBusId);
-    lastSentBusId_ = destBusId;
-  }
+  // We have nobody to poll right now, check back later in case that changes without any new application data.
+  awaitingResponseFrom_ = kSeparator;
+  taskWakeupTime_ = timeMillis() + kUartResponseTimeoutMs;
 }
+
 void Max485BusLeader::SetMessageToSend(BusId destBusId, const OrreryMessage& message) {
-  if (SetMessageToSendInner(destBusId, message)) {
-    const std::lock_guard<std::mutex> lock(sendMutex_);
-    if (std::find(highPriorityBusIds_.begin(), highPriorityBusIds_.end(), destBusId) == highPriorityBusIds_.end()) {
-      highPriorityBusIds_.push_back(destBusId);
-    }
-  }
+  SetMessageToSendInner(destBusId, message);
   uart_event_t eventToSend = {};
   eventToSend.type = kApplicationDataAvailable;
   BaseType_t res = xQueueSendToBack(queue_, &eventToSend, /*ticksToWait=*/0);
@@ -552,7 +567,8 @@ void Max485BusLeader::SetMessageToSend(BusId destBusId, const OrreryMessage& mes
 Max485BusFollower::Max485BusFollower(uart_port_t uartPort, int txPin, int rxPin, BusId busIdSelf)
     : Max485BusHandler(uartPort, txPin, rxPin, busIdSelf) {}
 
-void Max485BusFollower::HandleReceivedMessage(BusId srcBusId, const OrreryMessage& /*message*/) {
+void Max485BusFollower::HandleReceivedMessage(BusId srcBusId, const OrreryMessage& /*message*/,
+                                              Milliseconds /*rtt*/) {
   if (srcBusId == kBusIdLeader) { CopyEncodeAndSendMessage(kBusIdLeader); }
 }
 
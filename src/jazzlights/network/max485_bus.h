@@ -11,14 +11,14 @@
 #include <freertos/task.h>
 
 #include <atomic>
-#include <deque>
 #include <map>
-#include <mutex>
-#include <vector>
 
+#include "jazzlights/network/max485_poll_scheduler.h"
 #include "jazzlights/orrery_common.h"
 #include "jazzlights/util/buffer.h"
 #include "jazzlights/util/cobs.h"
+#include "jazzlights/util/seqlock.h"
+#include "jazzlights/util/spsc_ring.h"
 #include "jazzlights/util/time.h"
 
 #ifndef JL_LOG_MAX485_MESSAGES
@@ -32,6 +32,8 @@ class Max485BusHandler {
   static inline constexpr BusId kBusIdEndOfMessage = 1;
   static inline constexpr BusId kBusIdBroadcast = 2;
   static inline constexpr BusId kBusIdLeader = 3;
+  // Bus IDs we can send to must be below this.
+  static inline constexpr BusId kMaxBusIds = 16;
 
   virtual ~Max485BusHandler();
 
@@ -43,9 +45,11 @@ class Max485BusHandler {
   explicit Max485BusHandler(uart_port_t uartPort, int txPin, int rxPin, BusId busIdSelf);
 
   bool SetMessageToSendInner(BusId destBusId, const OrreryMessage& message);
-  virtual void HandleReceivedMessage(BusId srcBusId, const OrreryMessage& message) = 0;
+  // rtt is only set when this is the response to our last request, otherwise it is -1.
+  virtual void HandleReceivedMessage(BusId srcBusId, const OrreryMessage& message, Milliseconds rtt) = 0;
   virtual void HandleApplicationDataAvailableToSend(bool firstSend) = 0;
-  void CopyEncodeAndSendMessage(BusId destBusId);
+  // Returns whether a message was sent.
+  bool CopyEncodeAndSendMessage(BusId destBusId);
 
   inline static constexpr uint8_t kSeparator = 0;
   static void TaskFunction(void* parameters);
@@ -63,21 +67,27 @@ class Max485BusHandler {
   const uart_port_t uartPort_;         // Only modified in constructor.
   const int txPin_;                    // Only modified in constructor.
   const int rxPin_;                    // Only modified in constructor.
-  const TickType_t receiveDelay_;      // Only modified in constructor.
   TaskHandle_t taskHandle_ = nullptr;  // Only modified in constructor.
   QueueHandle_t queue_ = nullptr;
   std::atomic<BusId> busIdSelf_;
   std::atomic<bool> ready_{false};
-  std::mutex sendMutex_;
-  std::map<BusId, OrreryMessage> sharedSendMessages_;  // Protected by `sendMutex_`.
+  // Messages to send are indexed by destination bus ID. They are written by the thread calling SetMessageToSend and
+  // read by the task, neither of which ever blocks the other.
+  SeqLock<OrreryMessage> sharedSendMessages_[kMaxBusIds];
+  // Bit N is set when sharedSendMessages_[N] has ever been set.
+  std::atomic<uint32_t> sharedPopulatedBusIds_{0};
+  // Bit N is set when sharedSendMessages_[N] changed since the task last sent it.
+  std::atomic<uint32_t> sharedPendingBusIds_{0};
 #if JL_LOG_MAX485_MESSAGES
   std::map<BusId, OrreryMessage> lastLoggedMessages_;      // Only accessed by task.
   std::map<BusId, OrreryMessage> lastLoggedRecvMessages_;  // Only accessed by task.
 #endif
-  OwnedBufferU8 taskSendMessageBuffer_;                  // Only accessed by task.
-  OwnedBufferU8 taskEncodedSendMessageBuffer_;           // Only accessed by task.
-  Milliseconds taskLastSendTimeExpectingResponse_ = -1;  // Only accessed by task.
-  std::mutex recvMutex_;
+  OwnedBufferU8 taskSendMessageBuffer_;                    // Only accessed by task.
+  OwnedBufferU8 taskEncodedSendMessageBuffer_;             // Only accessed by task.
+  Milliseconds taskLastSendTimeExpectingResponse_ = -1;    // Only accessed by task.
+  BusId taskLastSendBusIdExpectingResponse_ = kSeparator;  // Only accessed by task.
+  // When set, the task stops waiting for UART events at this time and calls HandleApplicationDataAvailableToSend.
+  Milliseconds taskWakeupTime_ = -1;  // Only accessed by task.
   OwnedBufferU8 taskRecvBuffer_;            // Only accessed by task.
   size_t lengthInTaskRecvBuffer_ = 0;       // Only accessed by task.
   OwnedBufferU8 taskDecodedReadBuffer_;     // Only accessed by task.
@@ -88,7 +98,8 @@ class Max485BusHandler {
     OrreryMessage message;
     Milliseconds rtt = -1;
   };
-  std::deque<ReceivedMessage> sharedReceivedMessages_;  // Protected by `recvMutex_`.
+  // Produced by the task and consumed by the thread calling ReadMessage.
+  SpscRing<ReceivedMessage, 16> sharedReceivedMessages_;
 
   static inline constexpr uart_event_type_t kApplicationDataAvailable =
       static_cast<uart_event_type_t>(UART_EVENT_MAX + 1);
@@ -100,18 +111,15 @@ class Max485BusLeader : public Max485BusHandler {
   void SetMessageToSend(BusId destBusId, const OrreryMessage& message);
 
  protected:
-  void HandleReceivedMessage(BusId srcBusId, const OrreryMessage& message) override;
+  void HandleReceivedMessage(BusId srcBusId, const OrreryMessage& message, Milliseconds rtt) override;
   void HandleApplicationDataAvailableToSend(bool firstSend) override;
 
  private:
   void SendMessageToNextFollower();
-  struct FollowerState {
-    int timeoutCount = 0;
-    int skipCount = 0;
-  };
-  std::map<BusId, FollowerState> followerStates_;  // Only accessed by task.
-  std::deque<BusId> highPriorityBusIds_;           // Protected by `sendMutex_`.
-  BusId lastSentBusId_ = 0;                        // Only accessed by task.
+  Max485PollScheduler pollScheduler_;        // Only accessed by task.
+  BusId awaitingResponseFrom_ = kSeparator;  // Only accessed by task.
+  BusId lastPendingBusId_ = kSeparator;      // Only accessed by task.
+  bool hasSentFirstMessage_ = false;         // Only accessed by task.
 };
 
 class Max485BusFollower : public Max485BusHandler {
@@ -121,7 +129,7 @@ class Max485BusFollower : public Max485BusHandler {
   void SetBusIdSelf(BusId busIdSelf) { busIdSelf_.store(busIdSelf, std::memory_order_relaxed); }
 
  protected:
-  void HandleReceivedMessage(BusId srcBusId, const OrreryMessage& message) override;
+  void HandleReceivedMessage(BusId srcBusId, const OrreryMessage& message, Milliseconds rtt) override;
   void HandleApplicationDataAvailableToSend(bool firstSend) override;
 };
 
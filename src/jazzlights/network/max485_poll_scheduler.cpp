@@ -0,0 +1,121 @@
+#include "jazzlights/network/max485_poll_scheduler.h"
+
+#include <algorithm>
+
+namespace jazzlights {
+namespace {
+
+// Both timeMillis() and FreeRTOS ticks have a resolution of one millisecond, so RTT samples can be off by two.
+constexpr Milliseconds kClockGranularity = 2;
+
+}  // namespace
+
+Max485PollScheduler::Max485PollScheduler(const Config& config) : config_(config) {}
+
+Max485PollScheduler::FollowerState* Max485PollScheduler::Find(BusId busId) {
+  for (size_t i = 0; i < numFollowers_; i++) {
+    if (followers_[i].busId == busId) { return &followers_[i]; }
+  }
+  return nullptr;
+}
+
+const Max485PollScheduler::FollowerState* Max485PollScheduler::Find(BusId busId) const {
+  for (size_t i = 0; i < numFollowers_; i++) {
+    if (followers_[i].busId == busId) { return &followers_[i]; }
+  }
+  return nullptr;
+}
+
+bool Max485PollScheduler::AddFollower(BusId busId) {
+  if (busId == kNoFollower) { return false; }
+  size_t insertIndex = 0;
+  while (insertIndex < numFollowers_ && followers_[insertIndex].busId < busId) { insertIndex++; }
+  if (insertIndex < numFollowers_ && followers_[insertIndex].busId == busId) { return true; }
+  if (numFollowers_ >= kMaxFollowers) { return false; }
+  for (size_t i = numFollowers_; i > insertIndex; i--) { followers_[i] = followers_[i - 1]; }
+  followers_[insertIndex] = FollowerState();
+  followers_[insertIndex].busId = busId;
+  numFollowers_++;
+  // Keep pointing at the same follower so adding one does not disturb the current cycle.
+  if (insertIndex < nextIndex_) { nextIndex_++; }
+  return true;
+}
+
+BusId Max485PollScheduler::NextFollower() {
+  if (numFollowers_ == 0) { return kNoFollower; }
+  if (nextIndex_ >= numFollowers_) { nextIndex_ = 0; }
+  const size_t firstIndex = nextIndex_;
+  for (size_t i = 0; i < numFollowers_; i++) {
+    FollowerState& follower = followers_[nextIndex_];
+    nextIndex_ = (nextIndex_ + 1) % numFollowers_;
+    if (follower.skipsRemaining > 0) {
+      follower.skipsRemaining--;
+      continue;
+    }
+    return follower.busId;
+  }
+  // Every follower is backing off, probe the first one we skipped rather than leaving the bus idle.
+  nextIndex_ = (firstIndex + 1) % numFollowers_;
+  return followers_[firstIndex].busId;
+}
+
+bool Max485PollScheduler::IsBackingOff(BusId busId) const {
+  const FollowerState* follower = Find(busId);
+  return follower != nullptr && follower->skipsRemaining > 0;
+}
+
+Milliseconds Max485PollScheduler::ResponseTimeout(BusId busId) const {
+  const FollowerState* follower = Find(busId);
+  if (follower == nullptr || follower->scaledSmoothedRtt < 0) { return config_.maxResponseTimeout; }
+  // Same as the TCP retransmission timeout: smoothed RTT plus four times the mean deviation.
+  const Milliseconds timeout =
+      follower->scaledSmoothedRtt / 8 + std::max<Milliseconds>(follower->scaledRttDeviation, kClockGranularity);
+  return std::clamp(timeout, config_.minResponseTimeout, config_.maxResponseTimeout);
+}
+
+void Max485PollScheduler::OnResponse(BusId busId, Milliseconds rtt) {
+  FollowerState* follower = Find(busId);
+  if (follower == nullptr) { return; }
+  if (follower->scaledSmoothedRtt < 0) {
+    follower->scaledSmoothedRtt = rtt * 8;
+    follower->scaledRttDeviation = rtt * 2;
+  } else {
+    const int32_t error = rtt - follower->scaledSmoothedRtt / 8;
+    follower->scaledSmoothedRtt += error;
+    follower->scaledRttDeviation += (error < 0 ? -error : error) - follower->scaledRttDeviation / 4;
+  }
+  OnHeardFrom(busId);
+}
+
+void Max485PollScheduler::OnHeardFrom(BusId busId) {
+  FollowerState* follower = Find(busId);
+  if (follower == nullptr) { return; }
+  follower->consecutiveTimeouts = 0;
+  follower->backoffCycles = 0;
+  follower->skipsRemaining = 0;
+}
+
+void Max485PollScheduler::OnTimeout(BusId busId) {
+  FollowerState* follower = Find(busId);
+  if (follower == nullptr) { return; }
+  // Our estimate was too optimistic, widen it so a slow follower is not mistaken for a dead one.
+  if (follower->scaledSmoothedRtt >= 0) {
+    follower->scaledRttDeviation = std::min<int32_t>(follower->scaledRttDeviation * 2 + 1, config_.maxResponseTimeout);
+  }
+  if (follower->consecutiveTimeouts < UINT8_MAX) { follower->consecutiveTimeouts++; }
+  if (follower->consecutiveTimeouts < config_.timeoutsBeforeBackoff) { return; }
+  if (follower->backoffCycles == 0) {
+    follower->backoffCycles = 1;
+  } else {
+    follower->backoffCycles = std::min<int>(follower->backoffCycles * 2, config_.maxBackoffCycles);
+  }
+  follower->skipsRemaining = follower->backoffCycles;
+}
+
+Milliseconds Max485PollScheduler::SmoothedRtt(BusId busId) const {
+  const FollowerState* follower = Find(busId);
+  if (follower == nullptr || follower->scaledSmoothedRtt < 0) { return -1; }
+  return follower->scaledSmoothedRtt / 8;
+}
+
+}  // namespace jazzlights
@@ -0,0 +1,82 @@
+#ifndef JL_NETWORK_MAX485_POLL_SCHEDULER_H
+#define JL_NETWORK_MAX485_POLL_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "jazzlights/types.h"
+#include "jazzlights/util/time.h"
+
+namespace jazzlights {
+
+// Decides which follower the Max485 bus leader polls next, and how long to wait for its response.
+//
+// The bus is half-duplex so only one request can be outstanding at a time. To keep the bus busy, the leader polls the
+// next follower as soon as the previous one responds, and it stops waiting for a response once it is later than what
+// that follower's measured round-trip times predict. Followers that keep timing out are skipped for an exponentially
+// increasing number of cycles so an absent planet does not slow down everyone else.
+//
+// This class does not do any locking, it is only meant to be accessed by the Max485 bus task.
+class Max485PollScheduler {
+ public:
+  struct Config {
+    // Response timeouts are clamped to [minResponseTimeout, maxResponseTimeout]. Followers we have not heard from yet
+    // use maxResponseTimeout.
+    Milliseconds minResponseTimeout;
+    Milliseconds maxResponseTimeout;
+    // Number of consecutive timeouts after which a follower is considered dead and starts getting skipped.
+    uint8_t timeoutsBeforeBackoff;
+    // The number of skipped cycles doubles on every failed probe of a dead follower, up to this.
+    uint8_t maxBackoffCycles;
+  };
+
+  static constexpr size_t kMaxFollowers = 16;
+  static constexpr BusId kNoFollower = 0;
+
+  explicit Max485PollScheduler(const Config& config);
+
+  // Adds a follower to the round-robin schedule if it is not already in it. Returns false if the schedule is full.
+  bool AddFollower(BusId busId);
+  // Returns the next follower to poll in round-robin order, skipping followers that are backing off. If every follower
+  // is backing off this still returns one so the bus does not go idle. Returns kNoFollower if the schedule is empty.
+  BusId NextFollower();
+  // Returns whether busId is currently being skipped. Used to avoid wasting a timeout on high-priority sends.
+  bool IsBackingOff(BusId busId) const;
+  // Returns how long to wait for a response from busId before giving up.
+  Milliseconds ResponseTimeout(BusId busId) const;
+  // Called when busId responds to our request after rtt.
+  void OnResponse(BusId busId, Milliseconds rtt);
+  // Called when busId sent us something but we cannot attribute an RTT to it, for example a late response.
+  void OnHeardFrom(BusId busId);
+  // Called when busId failed to respond in time.
+  void OnTimeout(BusId busId);
+
+  size_t NumFollowers() const { return numFollowers_; }
+  // Returns the smoothed RTT for busId, or -1 if we have no measurements.
+  Milliseconds SmoothedRtt(BusId busId) const;
+
+ private:
+  struct FollowerState {
+    BusId busId = kNoFollower;
+    // Smoothed RTT and mean deviation, stored scaled by 8 and 4 respectively like in TCP (RFC 6298) to avoid floats.
+    int32_t scaledSmoothedRtt = -1;
+    int32_t scaledRttDeviation = 0;
+    uint8_t consecutiveTimeouts = 0;
+    // Number of cycles to skip after the last failed probe, zero when the follower is alive.
+    uint8_t backoffCycles = 0;
+    uint8_t skipsRemaining = 0;
+  };
+
+  FollowerState* Find(BusId busId);
+  const FollowerState* Find(BusId busId) const;
+
+  const Config config_;
+  // Sorted by bus ID so that the schedule is the same regardless of the order in which followers were added.
+  FollowerState followers_[kMaxFollowers];
+  size_t numFollowers_ = 0;
+  size_t nextIndex_ = 0;
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_NETWORK_MAX485_POLL_SCHEDULER_H
@@ -3,9 +3,12 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cinttypes>
 
 #include "jazzlights/orrery_common.h"
+#include "jazzlights/pseudorandom.h"
 #include "jazzlights/util/log.h"
 #include "jazzlights/util/time.h"
 #ifndef ESP32
@@ -145,17 +148,132 @@ void Network::reconnect(Milliseconds currentTime) {
   }
 }
 
+SendScheduler::SendScheduler(const Config& config) : config_(config), interval_(config.minInterval) {}
+
+void SendScheduler::setMessageToSend(const NetworkMessage& messageToSend, Milliseconds currentTime) {
+  // Precedence decays slowly after user input, so only increases warrant a burst. Decreases will eventually cause
+  // someone else to take over, and that will be a change of originator.
+  const bool changed = !hasMessage_ || messageToSend.originator != message_.originator ||
+                       messageToSend.currentPattern != message_.currentPattern ||
+                       messageToSend.nextPattern != message_.nextPattern ||
+                       messageToSend.precedence > message_.precedence ||
+                       messageToSend.orrerySceneId != message_.orrerySceneId;
+  hasMessage_ = true;
+  message_ = messageToSend;
+  if (changed) { triggerSendAsap(currentTime); }
+}
+
+void SendScheduler::disableSending() { hasMessage_ = false; }
+
+void SendScheduler::triggerSendAsap(Milliseconds currentTime) {
+  interval_ = config_.minInterval;
+  startInterval(currentTime, /*sendImmediately=*/true);
+}
+
+bool SendScheduler::isConsistentWith(const NetworkMessage& message) const {
+  return message.originator == message_.originator && message.currentPattern == message_.currentPattern &&
+         message.nextPattern == message_.nextPattern;
+}
+
+void SendScheduler::onMessageReceived(const NetworkMessage& message, const NetworkDeviceId& localDeviceId,
+                                      Milliseconds currentTime) {
+  if (message.sender == localDeviceId) { return; }
+  noteNeighbor(message.sender, currentTime);
+  if (!hasMessage_) { return; }
+  if (isConsistentWith(message)) {
+    // Only neighbors that are at least as close to the originator as we are can stand in for us, otherwise we would
+    // stop refreshing the origination time for nodes further down the tree.
+    if (message.numHops <= message_.numHops && numConsistentReceived_ < 0xFF) { numConsistentReceived_++; }
+  } else if (interval_ > config_.minInterval) {
+    interval_ = config_.minInterval;
+    startInterval(currentTime, /*sendImmediately=*/false);
+  }
+}
+
+bool SendScheduler::shouldSend(Milliseconds currentTime) {
+  if (!hasMessage_) { return false; }
+  if (intervalStartTime_ < 0) { startInterval(currentTime, /*sendImmediately=*/true); }
+  if (sendPending_ && currentTime >= sendTime_) {
+    sendPending_ = false;
+    if (config_.redundancyConstant == 0 || numConsistentReceived_ < config_.redundancyConstant) { return true; }
+    numSuppressed_++;
+    jll_debug("%u suppressing send after hearing %u consistent messages, interval %d", currentTime,
+              numConsistentReceived_, interval_);
+  }
+  if (currentTime >= intervalEndTime_) {
+    interval_ = std::min<Milliseconds>(interval_ * 2, config_.maxInterval);
+    startInterval(currentTime, /*sendImmediately=*/false);
+  }
+  return false;
+}
+
+void SendScheduler::onSent(Milliseconds /*currentTime*/) { numSent_++; }
+
+Milliseconds SendScheduler::nextCheckTime() const {
+  if (!hasMessage_) { return -1; }
+  if (intervalStartTime_ < 0) { return 0; }
+  return sendPending_ ? sendTime_ : intervalEndTime_;
+}
+
+void SendScheduler::startInterval(Milliseconds intervalStartTime, bool sendImmediately) {
+  intervalStartTime_ = intervalStartTime;
+  numConsistentReceived_ = 0;
+  const Milliseconds jitter = randomJitter(intervalStartTime);
+  if (sendImmediately) {
+    sendTime_ = intervalStartTime + jitter;
+  } else {
+    sendTime_ =
+        intervalStartTime + interval_ / 2 + UnpredictableRandom::GetNumberBetween(0, interval_ / 2 - 1) + jitter;
+  }
+  intervalEndTime_ = std::max<Milliseconds>(intervalStartTime + interval_, sendTime_ + 1);
+  sendPending_ = true;
+}
+
+void SendScheduler::noteNeighbor(const NetworkDeviceId& sender, Milliseconds currentTime) {
+  Neighbor* oldest = &neighbors_[0];
+  for (Neighbor& neighbor : neighbors_) {
+    if (neighbor.lastHeardTime >= 0 && neighbor.deviceId == sender) {
+      neighbor.lastHeardTime = currentTime;
+      return;
+    }
+    if (neighbor.lastHeardTime < oldest->lastHeardTime) { oldest = &neighbor; }
+  }
+  oldest->deviceId = sender;
+  oldest->lastHeardTime = currentTime;
+}
+
+size_t SendScheduler::numRecentNeighbors(Milliseconds currentTime) const {
+  size_t numNeighbors = 0;
+  for (const Neighbor& neighbor : neighbors_) {
+    if (neighbor.lastHeardTime >= 0 && currentTime - neighbor.lastHeardTime <= kNeighborExpiry) { numNeighbors++; }
+  }
+  return numNeighbors;
+}
+
+Milliseconds SendScheduler::randomJitter(Milliseconds currentTime) const {
+  const Milliseconds maxJitter =
+      std::min<Milliseconds>(numRecentNeighbors(currentTime) * config_.jitterPerNeighbor, config_.maxInterval / 2);
+  if (maxJitter <= 0) { return 0; }
+  return UnpredictableRandom::GetNumberBetween(0, maxJitter);
+}
+
+UdpNetwork::UdpNetwork() : sendScheduler_(kUdpSendSchedulerConfig) {}
+
 void UdpNetwork::triggerSendAsap(Milliseconds currentTime) {
-  effectLastTxTime_ = 0;
+  sendScheduler_.triggerSendAsap(currentTime);
   runLoop(currentTime);
 }
 
-void UdpNetwork::setMessageToSend(const NetworkMessage& messageToSend, Milliseconds /*currentTime*/) {
+void UdpNetwork::setMessageToSend(const NetworkMessage& messageToSend, Milliseconds currentTime) {
   hasDataToSend_ = true;
   messageToSend_ = messageToSend;
+  sendScheduler_.setMessageToSend(messageToSend, currentTime);
 }
 
-void UdpNetwork::disableSending(Milliseconds /*currentTime*/) { hasDataToSend_ = false; }
+void UdpNetwork::disableSending(Milliseconds /*currentTime*/) {
+  hasDataToSend_ = false;
+  sendScheduler_.disableSending();
+}
 
 std::list<NetworkMessage> Network::getReceivedMessages(Milliseconds currentTime) {
   checkStatus(currentTime);
@@ -238,6 +356,7 @@ std::list<NetworkMessage> UdpNetwork::getReceivedMessagesImpl(Milliseconds curre
     if (n <= 0) { break; }
     NetworkMessage receivedMessage;
     if (!ParseUdpPayload(udpPayload, n, receiptDetails, currentTime, &receivedMessage)) { continue; }
+    sendScheduler_.onMessageReceived(receivedMessage, getLocalDeviceId(), currentTime);
     receivedMessages.push_back(receivedMessage);
     lastReceiveTime_ = currentTime;
   }
@@ -262,6 +381,21 @@ void Network::checkStatus(Milliseconds currentTime) {
 void Network::runLoop(Milliseconds currentTime) {
   checkStatus(currentTime);
   runLoopImpl(currentTime);
+  maybeLogSendCounts(currentTime);
+}
+
+void Network::maybeLogSendCounts(Milliseconds currentTime) {
+  if (lastSendCountsLogTime_ >= 0 && currentTime - lastSendCountsLogTime_ < kSendCountsLogInterval) { return; }
+  lastSendCountsLogTime_ = currentTime;
+  const uint32_t numSends = getNumSends();
+  const uint32_t numSuppressedSends = getNumSuppressedSends();
+  if (numSends == loggedNumSends_ && numSuppressedSends == loggedNumSuppressedSends_) { return; }
+  jll_info("%u %s sent %" PRIu32 " and suppressed %" PRIu32 " messages since last report (%" PRIu32 " and %" PRIu32
+           " total)",
+           currentTime, NetworkTypeToString(type()), numSends - loggedNumSends_,
+           numSuppressedSends - loggedNumSuppressedSends_, numSends, numSuppressedSends);
+  loggedNumSends_ = numSends;
+  loggedNumSuppressedSends_ = numSuppressedSends;
 }
 
 bool Network::WriteUdpPayload(const NetworkMessage& messageToSend, uint8_t* udpPayload, size_t udpPayloadLength,
@@ -304,17 +438,13 @@ void UdpNetwork::runLoopImpl(Milliseconds currentTime) {
   if (status() != CONNECTED) { return; }
 
   // Do we need to send?
-  static constexpr Milliseconds kMinTimeBetweenUdpSends = 100;
-  if (hasDataToSend_ && (effectLastTxTime_ < 1 || currentTime - effectLastTxTime_ > kMinTimeBetweenUdpSends ||
-                         messageToSend_.currentPattern != lastSentPattern_)) {
-    effectLastTxTime_ = currentTime;
-    lastSentPattern_ = messageToSend_.currentPattern;
-
+  if (hasDataToSend_ && sendScheduler_.shouldSend(currentTime)) {
     uint8_t udpPayload[kPayloadLength] = {};
     if (!WriteUdpPayload(messageToSend_, udpPayload, sizeof(udpPayload), currentTime)) {
       jll_fatal("%s unexpected payload length issue", NetworkTypeToString(type()));
     }
     send(&udpPayload[0], sizeof(udpPayload));
+    sendScheduler_.onSent(currentTime);
   }
 }
 
@@ -173,6 +173,11 @@ class Network {
   // Get a human-readable status string that can be displayed to the user. Not const to allow taking locks.
   virtual std::string getStatusStr(Milliseconds currentTime) = 0;
 
+  // Number of messages sent and of sends suppressed by the SendScheduler since boot, logged periodically by runLoop().
+  // Networks that do not use a SendScheduler report zero. Not const to allow taking locks.
+  virtual uint32_t getNumSends() { return 0; }
+  virtual uint32_t getNumSuppressedSends() { return 0; }
+
  protected:
   Network() = default;
   // Perform any work necessary to switch to requested state.
@@ -206,6 +211,7 @@ class Network {
  private:
   void checkStatus(Milliseconds currentTime);
   void reconnect(Milliseconds currentTime);
+  void maybeLogSendCounts(Milliseconds currentTime);
 
   static NetworkId NextAvailableId();
 
@@ -217,15 +223,106 @@ class Network {
   static constexpr Milliseconds MinBackoffTimeout() { return 1000; }
   static constexpr Milliseconds MaxBackoffTimeout() { return 16000; }
   Milliseconds backoffTimeout_ = MinBackoffTimeout();
+
+  static constexpr Milliseconds kSendCountsLogInterval = 60000;
+  Milliseconds lastSendCountsLogTime_ = -1;
+  uint32_t loggedNumSends_ = 0;
+  uint32_t loggedNumSuppressedSends_ = 0;
+};
+
+// Decides when a network should send its current NetworkMessage. This is based on Trickle (RFC 6206): while the state
+// we are sending is stable, the interval between sends doubles up to a maximum. Any change to the pattern, precedence
+// or originator we are sending resets the interval to its minimum and sends right away, and receipt of a message that
+// disagrees with ours resets the interval. Receiving enough messages that agree with ours from neighbors at least as
+// close to the originator suppresses our own send for the current interval. Sends are jittered proportionally to the
+// number of distinct senders we have heard from recently to reduce collisions in dense deployments.
+// This class is not thread-safe, callers are responsible for locking if needed.
+class SendScheduler {
+ public:
+  struct Config {
+    // Interval used right after a change, the first send in it happens immediately.
+    Milliseconds minInterval;
+    // The interval stops doubling once it reaches this. It needs to stay well below kOriginationTimeOverride in Player
+    // since each hop can delay refreshing the origination time by up to this much.
+    Milliseconds maxInterval;
+    // Number of consistent messages received during an interval that suppresses our send for that interval. Zero
+    // disables suppression.
+    uint8_t redundancyConstant;
+    // Maximum additional jitter added to each send per recently heard sender.
+    Milliseconds jitterPerNeighbor;
+  };
+
+  explicit SendScheduler(const Config& config);
+
+  // Called whenever the message to send is set. Resets the interval if anything meaningful changed.
+  void setMessageToSend(const NetworkMessage& messageToSend, Milliseconds currentTime);
+  // Called when sending is disabled, the next call to setMessageToSend will reset the interval.
+  void disableSending();
+  // Resets the interval to its minimum and schedules an immediate send.
+  void triggerSendAsap(Milliseconds currentTime);
+  // Called for each message received on this network.
+  void onMessageReceived(const NetworkMessage& message, const NetworkDeviceId& localDeviceId, Milliseconds currentTime);
+  // Returns whether we should send now. If this returns true, the caller must send then call onSent().
+  bool shouldSend(Milliseconds currentTime);
+  // Called after each send.
+  void onSent(Milliseconds currentTime);
+  // Returns the next time at which calling shouldSend() can make progress, or -1 if there is nothing to send. Lets
+  // callers that wait on a socket sleep until then instead of polling.
+  Milliseconds nextCheckTime() const;
+
+  // Counters for debugging and tuning.
+  uint32_t numSent() const { return numSent_; }
+  uint32_t numSuppressed() const { return numSuppressed_; }
+  size_t numRecentNeighbors(Milliseconds currentTime) const;
+  Milliseconds currentInterval() const { return interval_; }
+
+ private:
+  bool isConsistentWith(const NetworkMessage& message) const;
+  void startInterval(Milliseconds intervalStartTime, bool sendImmediately);
+  void noteNeighbor(const NetworkDeviceId& sender, Milliseconds currentTime);
+  Milliseconds randomJitter(Milliseconds currentTime) const;
+
+  static constexpr size_t kMaxTrackedNeighbors = 16;
+  static constexpr Milliseconds kNeighborExpiry = 5000;
+
+  struct Neighbor {
+    NetworkDeviceId deviceId;
+    Milliseconds lastHeardTime = -1;
+  };
+
+  const Config config_;
+  bool hasMessage_ = false;
+  NetworkMessage message_;
+  Milliseconds interval_;
+  Milliseconds intervalStartTime_ = -1;
+  Milliseconds intervalEndTime_ = -1;
+  Milliseconds sendTime_ = -1;
+  bool sendPending_ = false;
+  uint8_t numConsistentReceived_ = 0;
+  uint32_t numSent_ = 0;
+  uint32_t numSuppressed_ = 0;
+  Neighbor neighbors_[kMaxTrackedNeighbors];
+};
+
+// Used by the networks that send over UDP multicast. Starts at the previous fixed rate of 100ms and backs off to 1.6s
+// while nothing changes.
+inline constexpr SendScheduler::Config kUdpSendSchedulerConfig = {
+    .minInterval = 100,
+    .maxInterval = 1600,
+    .redundancyConstant = 3,
+    .jitterPerNeighbor = 5,
 };
 
 class UdpNetwork : public Network {
  public:
+  UdpNetwork();
   void setMessageToSend(const NetworkMessage& messageToSend, Milliseconds currentTime) override;
   void disableSending(Milliseconds currentTime) override;
   void triggerSendAsap(Milliseconds currentTime) override;
   bool shouldEcho() const override { return false; }
   Milliseconds getLastReceiveTime() const override { return lastReceiveTime_; }
+  uint32_t getNumSends() override { return sendScheduler_.numSent(); }
+  uint32_t getNumSuppressedSends() override { return sendScheduler_.numSuppressed(); }
 
  protected:
   std::list<NetworkMessage> getReceivedMessagesImpl(Milliseconds currentTime) override;
@@ -236,10 +333,8 @@ class UdpNetwork : public Network {
  private:
   bool hasDataToSend_ = false;
   NetworkMessage messageToSend_;
+  SendScheduler sendScheduler_;
 
-  PatternBits lastSentPattern_ = 0;
-
-  Milliseconds effectLastTxTime_ = 0;
   Milliseconds lastReceiveTime_ = -1;
 };
 
@@ -293,6 +388,15 @@ class NetworkReader {
     return ReadUint32(reinterpret_cast<uint32_t*>(out));
   }
 
+  // Returns a pointer to the next length bytes and skips past them, or nullptr if there aren't that many left. This
+  // allows callers to check bounds once and then parse a fixed-size block directly.
+  const uint8_t* ReadBytes(size_t length) {
+    if (length > size_ || pos_ > size_ - length) { return nullptr; }
+    const uint8_t* out = &data_[pos_];
+    pos_ += length;
+    return out;
+  }
+
   bool ReadNetworkDeviceId(NetworkDeviceId* out) {
     if (NetworkDeviceId::size() > size_ || pos_ > size_ - NetworkDeviceId::size()) { return false; }
     out->readFrom(&data_[pos_]);
@@ -347,6 +451,14 @@ class NetworkWriter {
     return WriteUint32(uin);
   }
 
+  // Returns a pointer to the next length bytes for the caller to fill in, or nullptr if they don't fit.
+  uint8_t* ReserveBytes(size_t length) {
+    if (length > size_ || pos_ > size_ - length) { return nullptr; }
+    uint8_t* out = &data_[pos_];
+    pos_ += length;
+    return out;
+  }
+
   bool WriteNetworkDeviceId(const NetworkDeviceId& in) {
     if (NetworkDeviceId::size() > size_ || pos_ > size_ - NetworkDeviceId::size()) { return false; }
     in.writeTo(&data_[pos_]);
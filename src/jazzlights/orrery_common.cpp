@@ -43,10 +43,55 @@ constexpr uint8_t kOrreryFlagLedPrecedenceGain = 0x80;
 constexpr uint8_t kOrreryFlag2TimeHallSensorLastClosed = 0x01;
 constexpr uint8_t kOrreryFlag2LastOpenDuration = 0x02;
 constexpr uint8_t kOrreryFlag2LastClosedDuration = 0x04;
+
+// Type and both flag bytes.
+constexpr size_t kOrreryPrefixLength = 3;
+
+// Returns the length of everything after the prefix. All fields are fixed-size so this only depends on the flags.
+size_t OrreryBodyLength(uint8_t flags, uint8_t flags2) {
+  constexpr uint8_t kFlags32 = kOrreryFlagSpeed | kOrreryFlagPosition | kOrreryFlagCalibration |
+                               kOrreryFlagLedPattern | kOrreryFlagTimeHallSensorLastOpened;
+  constexpr uint8_t kFlags2_32 =
+      kOrreryFlag2TimeHallSensorLastClosed | kOrreryFlag2LastOpenDuration | kOrreryFlag2LastClosedDuration;
+  size_t length = /*leaderBootId*/ 4 + /*leaderSequenceNumber*/ 4;
+  length += 4 * __builtin_popcount(flags & kFlags32) + 4 * __builtin_popcount(flags2 & kFlags2_32);
+  if (flags & kOrreryFlagLedBrightness) { length += 1; }
+  if (flags & kOrreryFlagLedBasePrecedence) { length += 2; }
+  if (flags & kOrreryFlagLedPrecedenceGain) { length += 2; }
+  return length;
+}
+
+// All integers are big-endian on the wire, and signed ones use two's complement.
+uint8_t* PutUint32(uint8_t* out, uint32_t in) {
+  out[0] = static_cast<uint8_t>(in >> 24);
+  out[1] = static_cast<uint8_t>(in >> 16);
+  out[2] = static_cast<uint8_t>(in >> 8);
+  out[3] = static_cast<uint8_t>(in);
+  return out + 4;
+}
+
+uint8_t* PutUint16(uint8_t* out, uint16_t in) {
+  out[0] = static_cast<uint8_t>(in >> 8);
+  out[1] = static_cast<uint8_t>(in);
+  return out + 2;
+}
+
+uint32_t GetUint32(const uint8_t*& in) {
+  const uint32_t out = (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+                       (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+  in += 4;
+  return out;
+}
+
+uint16_t GetUint16(const uint8_t*& in) {
+  const uint16_t out = static_cast<uint16_t>((in[0] << 8) | in[1]);
+  in += 2;
+  return out;
+}
+
 }  // namespace
 
 bool WriteOrreryMessage(const OrreryMessage& msg, NetworkWriter& writer) {
-  if (!writer.WriteUint8(static_cast<uint8_t>(msg.type))) { return false; }
   uint8_t flags = 0;
   if (msg.speed.has_value()) { flags |= kOrreryFlagSpeed; }
   if (msg.position.has_value()) { flags |= kOrreryFlagPosition; }
@@ -56,122 +101,62 @@ bool WriteOrreryMessage(const OrreryMessage& msg, NetworkWriter& writer) {
   if (msg.ledBrightness.has_value()) { flags |= kOrreryFlagLedBrightness; }
   if (msg.ledBasePrecedence.has_value()) { flags |= kOrreryFlagLedBasePrecedence; }
   if (msg.ledPrecedenceGain.has_value()) { flags |= kOrreryFlagLedPrecedenceGain; }
-  if (!writer.WriteUint8(flags)) { return false; }
-
   uint8_t flags2 = 0;
   if (msg.timeHallSensorLastClosed.has_value()) { flags2 |= kOrreryFlag2TimeHallSensorLastClosed; }
   if (msg.lastOpenDuration.has_value()) { flags2 |= kOrreryFlag2LastOpenDuration; }
   if (msg.lastClosedDuration.has_value()) { flags2 |= kOrreryFlag2LastClosedDuration; }
-  if (!writer.WriteUint8(flags2)) { return false; }
-
-  if (!writer.WriteUint32(msg.leaderBootId)) { return false; }
-  if (!writer.WriteUint32(msg.leaderSequenceNumber)) { return false; }
-  if (msg.speed.has_value() && !writer.WriteInt32(*msg.speed)) { return false; }
-  if (msg.position.has_value() && !writer.WriteUint32(*msg.position)) { return false; }
-  if (msg.calibration.has_value() && !writer.WriteUint32(*msg.calibration)) { return false; }
-  if (msg.timeHallSensorLastOpened.has_value() && !writer.WriteUint32(timeMillis() - *msg.timeHallSensorLastOpened)) {
-    return false;
-  }
-  if (msg.timeHallSensorLastClosed.has_value() && !writer.WriteUint32(timeMillis() - *msg.timeHallSensorLastClosed)) {
-    return false;
+
+  // Check bounds once for the whole message, then write it in a single pass.
+  uint8_t* out = writer.ReserveBytes(kOrreryPrefixLength + OrreryBodyLength(flags, flags2));
+  if (out == nullptr) { return false; }
+  *out++ = static_cast<uint8_t>(msg.type);
+  *out++ = flags;
+  *out++ = flags2;
+  out = PutUint32(out, msg.leaderBootId);
+  out = PutUint32(out, msg.leaderSequenceNumber);
+  const Milliseconds currentTime = timeMillis();
+  if (msg.speed.has_value()) { out = PutUint32(out, static_cast<uint32_t>(*msg.speed)); }
+  if (msg.position.has_value()) { out = PutUint32(out, *msg.position); }
+  if (msg.calibration.has_value()) { out = PutUint32(out, *msg.calibration); }
+  if (msg.timeHallSensorLastOpened.has_value()) {
+    out = PutUint32(out, currentTime - *msg.timeHallSensorLastOpened);
   }
-  if (msg.lastOpenDuration.has_value() && !writer.WriteUint32(*msg.lastOpenDuration)) { return false; }
-  if (msg.lastClosedDuration.has_value() && !writer.WriteUint32(*msg.lastClosedDuration)) { return false; }
-  if (msg.ledPattern.has_value() && !writer.WriteUint32(static_cast<uint32_t>(*msg.ledPattern))) { return false; }
-  if (msg.ledBrightness.has_value() && !writer.WriteUint8(*msg.ledBrightness)) { return false; }
-  if (msg.ledBasePrecedence.has_value() && !writer.WriteUint16(*msg.ledBasePrecedence)) { return false; }
-  if (msg.ledPrecedenceGain.has_value() && !writer.WriteUint16(*msg.ledPrecedenceGain)) { return false; }
+  if (msg.timeHallSensorLastClosed.has_value()) {
+    out = PutUint32(out, currentTime - *msg.timeHallSensorLastClosed);
+  }
+  if (msg.lastOpenDuration.has_value()) { out = PutUint32(out, *msg.lastOpenDuration); }
+  if (msg.lastClosedDuration.has_value()) { out = PutUint32(out, *msg.lastClosedDuration); }
+  if (msg.ledPattern.has_value()) { out = PutUint32(out, static_cast<uint32_t>(*msg.ledPattern)); }
+  if (msg.ledBrightness.has_value()) { *out++ = *msg.ledBrightness; }
+  if (msg.ledBasePrecedence.has_value()) { out = PutUint16(out, *msg.ledBasePrecedence); }
+  if (msg.ledPrecedenceGain.has_value()) { out = PutUint16(out, *msg.ledPrecedenceGain); }
   return true;
 }
 
 bool ReadOrreryMessage(NetworkReader& reader, OrreryMessage* msg) {
-  uint8_t typeByte;
-  if (!reader.ReadUint8(&typeByte)) { return false; }
-  msg->type = static_cast<OrreryMessageType>(typeByte);
-  uint8_t flags;
-  if (!reader.ReadUint8(&flags)) { return false; }
-  uint8_t flags2;
-  if (!reader.ReadUint8(&flags2)) { return false; }
-
-  if (!reader.ReadUint32(&msg->leaderBootId)) { return false; }
-  if (!reader.ReadUint32(&msg->leaderSequenceNumber)) { return false; }
-  if (flags & kOrreryFlagSpeed) {
-    int32_t speed;
-    if (!reader.ReadInt32(&speed)) { return false; }
-    msg->speed = speed;
-  } else {
-    msg->speed = std::nullopt;
-  }
-  if (flags & kOrreryFlagPosition) {
-    uint32_t position;
-    if (!reader.ReadUint32(&position)) { return false; }
-    msg->position = position;
-  } else {
-    msg->position = std::nullopt;
-  }
-  if (flags & kOrreryFlagCalibration) {
-    uint32_t calibration;
-    if (!reader.ReadUint32(&calibration)) { return false; }
-    msg->calibration = calibration;
-  } else {
-    msg->calibration = std::nullopt;
-  }
-  if (flags & kOrreryFlagTimeHallSensorLastOpened) {
-    uint32_t delta;
-    if (!reader.ReadUint32(&delta)) { return false; }
-    msg->timeHallSensorLastOpened = timeMillis() - delta;
-  } else {
-    msg->timeHallSensorLastOpened = std::nullopt;
-  }
-  if (flags2 & kOrreryFlag2TimeHallSensorLastClosed) {
-    uint32_t delta;
-    if (!reader.ReadUint32(&delta)) { return false; }
-    msg->timeHallSensorLastClosed = timeMillis() - delta;
-  } else {
-    msg->timeHallSensorLastClosed = std::nullopt;
-  }
-  if (flags2 & kOrreryFlag2LastOpenDuration) {
-    uint32_t lastOpenDuration;
-    if (!reader.ReadUint32(&lastOpenDuration)) { return false; }
-    msg->lastOpenDuration = lastOpenDuration;
-  } else {
-    msg->lastOpenDuration = std::nullopt;
-  }
-  if (flags2 & kOrreryFlag2LastClosedDuration) {
-    uint32_t lastClosedDuration;
-    if (!reader.ReadUint32(&lastClosedDuration)) { return false; }
-    msg->lastClosedDuration = lastClosedDuration;
-  } else {
-    msg->lastClosedDuration = std::nullopt;
-  }
-  if (flags & kOrreryFlagLedPattern) {
-    PatternBits ledPattern;
-    if (!reader.ReadPatternBits(&ledPattern)) { return false; }
-    msg->ledPattern = ledPattern;
-  } else {
-    msg->ledPattern = std::nullopt;
-  }
-  if (flags & kOrreryFlagLedBrightness) {
-    uint8_t ledBrightness;
-    if (!reader.ReadUint8(&ledBrightness)) { return false; }
-    msg->ledBrightness = ledBrightness;
-  } else {
-    msg->ledBrightness = std::nullopt;
-  }
-  if (flags & kOrreryFlagLedBasePrecedence) {
-    Precedence ledBasePrecedence;
-    if (!reader.ReadUint16(&ledBasePrecedence)) { return false; }
-    msg->ledBasePrecedence = ledBasePrecedence;
-  } else {
-    msg->ledBasePrecedence = std::nullopt;
-  }
-  if (flags & kOrreryFlagLedPrecedenceGain) {
-    Precedence ledPrecedenceGain;
-    if (!reader.ReadUint16(&ledPrecedenceGain)) { return false; }
-    msg->ledPrecedenceGain = ledPrecedenceGain;
-  } else {
-    msg->ledPrecedenceGain = std::nullopt;
-  }
+  const uint8_t* prefix = reader.ReadBytes(kOrreryPrefixLength);
+  if (prefix == nullptr) { return false; }
+  const uint8_t flags = prefix[1];
+  const uint8_t flags2 = prefix[2];
+  // Check bounds once for the whole message, then parse it in a single pass.
+  const uint8_t* in = reader.ReadBytes(OrreryBodyLength(flags, flags2));
+  if (in == nullptr) { return false; }
+  *msg = OrreryMessage();
+  msg->type = static_cast<OrreryMessageType>(prefix[0]);
+  msg->leaderBootId = GetUint32(in);
+  msg->leaderSequenceNumber = GetUint32(in);
+  const Milliseconds currentTime = timeMillis();
+  if (flags & kOrreryFlagSpeed) { msg->speed = static_cast<int32_t>(GetUint32(in)); }
+  if (flags & kOrreryFlagPosition) { msg->position = GetUint32(in); }
+  if (flags & kOrreryFlagCalibration) { msg->calibration = GetUint32(in); }
+  if (flags & kOrreryFlagTimeHallSensorLastOpened) { msg->timeHallSensorLastOpened = currentTime - GetUint32(in); }
+  if (flags2 & kOrreryFlag2TimeHallSensorLastClosed) { msg->timeHallSensorLastClosed = currentTime - GetUint32(in); }
+  if (flags2 & kOrreryFlag2LastOpenDuration) { msg->lastOpenDuration = GetUint32(in); }
+  if (flags2 & kOrreryFlag2LastClosedDuration) { msg->lastClosedDuration = GetUint32(in); }
+  if (flags & kOrreryFlagLedPattern) { msg->ledPattern = GetUint32(in); }
+  if (flags & kOrreryFlagLedBrightness) { msg->ledBrightness = *in++; }
+  if (flags & kOrreryFlagLedBasePrecedence) { msg->ledBasePrecedence = GetUint16(in); }
+  if (flags & kOrreryFlagLedPrecedenceGain) { msg->ledPrecedenceGain = GetUint16(in); }
   return true;
 }
 
@@ -2,8 +2,10 @@
 #define JL_ORRERY_COMMON_H
 
 #include <cstdint>
+#include <cstring>
 #include <optional>
 #include <string>
+#include <type_traits>
 
 #include "jazzlights/config.h"
 #include "jazzlights/types.h"
@@ -74,37 +76,77 @@ enum class OrreryMessageType : uint8_t {
 #if JL_IS_CONFIG(ORRERY_PLANET) || JL_IS_CONFIG(ORRERY_LEADER) || JL_IS_CONTROLLER(CORE2AWS) || \
     JL_IS_CONTROLLER(CORES3) || PIO_UNIT_TESTING
 
-struct OrreryMessage {
-  OrreryMessageType type;
-  uint32_t leaderBootId;
-  uint32_t leaderSequenceNumber;
-  std::optional<int32_t> speed;
-  std::optional<uint32_t> position;
-  std::optional<uint32_t> calibration;
-  std::optional<Milliseconds> timeHallSensorLastOpened;
-  std::optional<Milliseconds> timeHallSensorLastClosed;
-  std::optional<Milliseconds> lastOpenDuration;
-  std::optional<Milliseconds> lastClosedDuration;
-  std::optional<PatternBits> ledPattern;
-  std::optional<uint8_t> ledBrightness;
-  std::optional<Precedence> ledBasePrecedence;
-  std::optional<Precedence> ledPrecedenceGain;
-
-  // IMPORTANT: If additional data is added to OrreryMessage, kMaxMessageLength needs to be adjusted in
-  // Max485BusHandler.
-
-  bool operator==(const OrreryMessage& other) const {
-    return type == other.type && leaderBootId == other.leaderBootId &&
-           leaderSequenceNumber == other.leaderSequenceNumber && speed == other.speed && position == other.position &&
-           calibration == other.calibration && timeHallSensorLastOpened == other.timeHallSensorLastOpened &&
-           timeHallSensorLastClosed == other.timeHallSensorLastClosed && lastOpenDuration == other.lastOpenDuration &&
-           lastClosedDuration == other.lastClosedDuration && ledPattern == other.ledPattern &&
-           ledBrightness == other.ledBrightness && ledBasePrecedence == other.ledBasePrecedence &&
-           ledPrecedenceGain == other.ledPrecedenceGain;
+// Minimal replacement for std::optional used by OrreryMessage fields. The value is always zero when absent, and the
+// presence flag is the same size as the value so there is no padding. Together these make every byte of an
+// OrreryMessage meaningful, which allows comparing them with memcmp.
+template <typename T>
+class OrreryField {
+  static_assert(std::is_integral<T>::value, "OrreryField only supports integers");
+
+ public:
+  constexpr OrreryField() = default;
+  constexpr OrreryField(std::nullopt_t) {}
+  constexpr OrreryField(T value) : value_(value), present_(1) {}
+  constexpr OrreryField(const std::optional<T>& value) : value_(value.value_or(0)), present_(value.has_value()) {}
+  OrreryField& operator=(std::nullopt_t) {
+    reset();
+    return *this;
+  }
+  OrreryField& operator=(T value) {
+    value_ = value;
+    present_ = 1;
+    return *this;
+  }
+
+  constexpr bool has_value() const { return present_ != 0; }
+  constexpr explicit operator bool() const { return has_value(); }
+  constexpr const T& operator*() const { return value_; }
+  constexpr T value_or(T defaultValue) const { return has_value() ? value_ : defaultValue; }
+  constexpr operator std::optional<T>() const { return has_value() ? std::optional<T>(value_) : std::nullopt; }
+  void reset() {
+    value_ = 0;
+    present_ = 0;
+  }
+
+  constexpr bool operator==(const OrreryField& other) const {
+    return present_ == other.present_ && value_ == other.value_;
   }
+  constexpr bool operator!=(const OrreryField& other) const { return !(*this == other); }
+
+ private:
+  T value_ = 0;
+  std::make_unsigned_t<T> present_ = 0;
+};
+
+struct OrreryMessage {
+  OrreryMessageType type = OrreryMessageType::LeaderCommand;
+  uint8_t reserved = 0;  // Explicit padding, always zero.
+  OrreryField<uint8_t> ledBrightness;
+  uint32_t leaderBootId = 0;
+  uint32_t leaderSequenceNumber = 0;
+  OrreryField<int32_t> speed;
+  OrreryField<uint32_t> position;
+  OrreryField<uint32_t> calibration;
+  OrreryField<Milliseconds> timeHallSensorLastOpened;
+  OrreryField<Milliseconds> timeHallSensorLastClosed;
+  OrreryField<Milliseconds> lastOpenDuration;
+  OrreryField<Milliseconds> lastClosedDuration;
+  OrreryField<PatternBits> ledPattern;
+  OrreryField<Precedence> ledBasePrecedence;
+  OrreryField<Precedence> ledPrecedenceGain;
+
+  // IMPORTANT: If additional data is added to OrreryMessage, kOrreryMessageMaxEncodedLength needs to be adjusted.
+
+  bool operator==(const OrreryMessage& other) const { return memcmp(this, &other, sizeof(*this)) == 0; }
   bool operator!=(const OrreryMessage& other) const { return !(*this == other); }
 };
 
+static_assert(std::has_unique_object_representations_v<OrreryMessage>,
+              "OrreryMessage must not have padding since operator== uses memcmp");
+
+// Type, two flag bytes, boot ID, sequence number, then all optional fields.
+inline constexpr size_t kOrreryMessageMaxEncodedLength = 3 + 4 + 4 + 8 * 4 + 1 + 2 + 2;
+
 bool WriteOrreryMessage(const OrreryMessage& msg, NetworkWriter& writer);
 bool ReadOrreryMessage(NetworkReader& reader, OrreryMessage* msg);
 std::string OrreryMessageToString(const OrreryMessage& msg);
@@ -0,0 +1,337 @@
+#include "jazzlights/pattern_cache.h"
+
+#include <cstring>
+
+#include "jazzlights/util/log.h"
+
+#ifdef ESP32
+#include <esp_partition.h>
+#else  // ESP32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // ESP32
+
+namespace jazzlights {
+
+static_assert(sizeof(PatternCacheHeader) == 24, "PatternCacheHeader is part of the file format");
+static_assert(sizeof(PatternCacheEntry) == 12, "PatternCacheEntry is part of the file format");
+static_assert(sizeof(CRGB) == 3, "Cached colors are stored as RGB");
+
+namespace {
+
+enum RunKind : uint8_t {
+  kSkipRun = 0,
+  kLiteralRun = 1,
+  kFillRun = 2,
+};
+
+bool SameColor(const CRGB& a, const CRGB& b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+
+void AppendVarint(std::vector<uint8_t>* out, uint32_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+void AppendRun(std::vector<uint8_t>* out, RunKind kind, size_t length) {
+  AppendVarint(out, static_cast<uint32_t>(((length - 1) << 2) | kind));
+}
+
+void AppendColor(std::vector<uint8_t>* out, const CRGB& color) {
+  out->push_back(color.r);
+  out->push_back(color.g);
+  out->push_back(color.b);
+}
+
+template <typename T>
+void AppendStruct(std::vector<uint8_t>* out, const T& value) {
+  const size_t offset = out->size();
+  out->resize(offset + sizeof(T));
+  memcpy(out->data() + offset, &value, sizeof(T));
+}
+
+// Returns false if the varint does not fit in [*position, end).
+bool ReadVarint(const uint8_t* data, size_t end, size_t* position, uint32_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 32; shift += 7) {
+    if (*position >= end) { return false; }
+    const uint8_t byte = data[(*position)++];
+    *value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) { return true; }
+  }
+  return false;
+}
+
+}  // namespace
+
+uint32_t PatternCacheLayoutFingerprint(const std::vector<const Layout*>& layouts) {
+  // FNV-1a over the number of LEDs of each layout and the bits of each coordinate.
+  uint32_t hash = 2166136261u;
+  auto add = [&hash](const void* bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) { hash = (hash ^ static_cast<const uint8_t*>(bytes)[i]) * 16777619u; }
+  };
+  for (const Layout* layout : layouts) {
+    const uint32_t numLeds = static_cast<uint32_t>(layout->pixelCount());
+    add(&numLeds, sizeof(numLeds));
+    for (size_t i = 0; i < numLeds; i++) {
+      const Point p = layout->at(i);
+      add(&p.x, sizeof(p.x));
+      add(&p.y, sizeof(p.y));
+    }
+  }
+  return hash;
+}
+
+PatternCacheWriter::PatternCacheWriter(size_t numLeds, uint32_t layoutFingerprint, uint16_t framesPerSecond,
+                                       uint16_t keyframeInterval)
+    : numLeds_(numLeds),
+      layoutFingerprint_(layoutFingerprint),
+      framesPerSecond_(framesPerSecond),
+      keyframeInterval_(keyframeInterval == 0 ? 1 : keyframeInterval),
+      previousFrame_(numLeds) {}
+
+void PatternCacheWriter::BeginPattern(PatternBits pattern) {
+  for (const Pattern& p : patterns_) {
+    if (p.pattern == pattern) { jll_fatal("Pattern %08x added twice to pattern cache", pattern); }
+  }
+  patterns_.push_back({pattern, static_cast<uint32_t>(frameData_.size()), {}});
+}
+
+void PatternCacheWriter::AddFrame(const CRGB* colors) {
+  if (patterns_.empty()) { jll_fatal("PatternCacheWriter::AddFrame called before BeginPattern"); }
+  std::vector<uint32_t>& frameOffsets = patterns_.back().frameOffsets;
+  if ((frameOffsets.size() % keyframeInterval_) == 0) {
+    for (CRGB& color : previousFrame_) { color = CRGB::Black; }
+  }
+  frameOffsets.push_back(static_cast<uint32_t>(frameData_.size()));
+  size_t i = 0;
+  while (i < numLeds_) {
+    size_t end = i + 1;
+    if (SameColor(colors[i], previousFrame_[i])) {
+      while (end < numLeds_ && SameColor(colors[end], previousFrame_[end])) { end++; }
+      AppendRun(&frameData_, kSkipRun, end - i);
+    } else if (end < numLeds_ && SameColor(colors[end], colors[i])) {
+      while (end < numLeds_ && SameColor(colors[end], colors[i])) { end++; }
+      AppendRun(&frameData_, kFillRun, end - i);
+      AppendColor(&frameData_, colors[i]);
+    } else {
+      // Extend the literal run until a skip or fill run would be at least as compact.
+      while (end < numLeds_ && !SameColor(colors[end], previousFrame_[end]) &&
+             !(end + 1 < numLeds_ && SameColor(colors[end + 1], colors[end]))) {
+        end++;
+      }
+      AppendRun(&frameData_, kLiteralRun, end - i);
+      for (size_t j = i; j < end; j++) { AppendColor(&frameData_, colors[j]); }
+    }
+    i = end;
+  }
+  memcpy(previousFrame_.data(), colors, numLeds_ * sizeof(CRGB));
+}
+
+std::vector<uint8_t> PatternCacheWriter::Finish() const {
+  PatternCacheHeader header = {};
+  header.magic = kPatternCacheMagic;
+  header.version = kPatternCacheVersion;
+  header.framesPerSecond = framesPerSecond_;
+  header.numLeds = static_cast<uint32_t>(numLeds_);
+  header.layoutFingerprint = layoutFingerprint_;
+  header.numPatterns = static_cast<uint32_t>(patterns_.size());
+  header.keyframeInterval = keyframeInterval_;
+  size_t tablesSize = sizeof(PatternCacheHeader) + patterns_.size() * sizeof(PatternCacheEntry);
+  size_t totalSize = tablesSize + frameData_.size();
+  for (const Pattern& p : patterns_) { totalSize += (p.frameOffsets.size() + 1) * sizeof(uint32_t); }
+  std::vector<uint8_t> out;
+  out.reserve(totalSize);
+  AppendStruct(&out, header);
+  for (const Pattern& p : patterns_) {
+    PatternCacheEntry entry = {};
+    entry.pattern = p.pattern;
+    entry.numFrames = static_cast<uint32_t>(p.frameOffsets.size());
+    entry.frameOffsetsOffset = static_cast<uint32_t>(tablesSize);
+    AppendStruct(&out, entry);
+    tablesSize += (p.frameOffsets.size() + 1) * sizeof(uint32_t);
+  }
+  for (size_t i = 0; i < patterns_.size(); i++) {
+    const std::vector<uint32_t>& frameOffsets = patterns_[i].frameOffsets;
+    for (uint32_t offset : frameOffsets) { AppendStruct(&out, static_cast<uint32_t>(tablesSize + offset)); }
+    // Frames are added in order, so the frames of a pattern end where the ones of the next pattern start.
+    const size_t end = i + 1 < patterns_.size() ? patterns_[i + 1].dataStart : frameData_.size();
+    AppendStruct(&out, static_cast<uint32_t>(tablesSize + end));
+  }
+  out.insert(out.end(), frameData_.begin(), frameData_.end());
+  return out;
+}
+
+std::unique_ptr<PatternCache> PatternCache::Create(const uint8_t* data, size_t size) {
+  if (size < sizeof(PatternCacheHeader)) {
+    jll_error("Pattern cache too small (%zu bytes)", size);
+    return nullptr;
+  }
+  const PatternCacheHeader* header = reinterpret_cast<const PatternCacheHeader*>(data);
+  if (header->magic != kPatternCacheMagic || header->version != kPatternCacheVersion || header->numLeds == 0 ||
+      header->framesPerSecond == 0 || header->keyframeInterval == 0) {
+    jll_error("Invalid pattern cache header");
+    return nullptr;
+  }
+  const size_t entriesEnd = sizeof(PatternCacheHeader) + size_t{header->numPatterns} * sizeof(PatternCacheEntry);
+  if (entriesEnd > size) {
+    jll_error("Pattern cache truncated in pattern table");
+    return nullptr;
+  }
+  const PatternCacheEntry* entries = reinterpret_cast<const PatternCacheEntry*>(data + sizeof(PatternCacheHeader));
+  for (uint32_t i = 0; i < header->numPatterns; i++) {
+    const size_t offsetsEnd = size_t{entries[i].frameOffsetsOffset} + (size_t{entries[i].numFrames} + 1) * 4;
+    if ((entries[i].frameOffsetsOffset % 4) != 0 || offsetsEnd > size) {
+      jll_error("Pattern cache truncated in frame table of pattern %08x", entries[i].pattern);
+      return nullptr;
+    }
+  }
+  return std::unique_ptr<PatternCache>(new PatternCache(data, size));
+}
+
+PatternCache::PatternCache(const uint8_t* data, size_t size)
+    : data_(data),
+      size_(size),
+      header_(reinterpret_cast<const PatternCacheHeader*>(data)),
+      entries_(reinterpret_cast<const PatternCacheEntry*>(data + sizeof(PatternCacheHeader))),
+      frame_(header_->numLeds) {}
+
+PatternCache::~PatternCache() {
+  if (unmap_) { unmap_(); }
+}
+
+#ifdef ESP32
+
+std::unique_ptr<PatternCache> PatternCache::MapPartition(const char* label) {
+  const esp_partition_t* partition =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if (partition == nullptr) {
+    jll_info("No %s partition, not using pattern cache", label);
+    return nullptr;
+  }
+  const void* memory = nullptr;
+  esp_partition_mmap_handle_t handle;
+  esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &memory, &handle);
+  if (err != ESP_OK) {
+    jll_error("Failed to map %s partition: %s", label, esp_err_to_name(err));
+    return nullptr;
+  }
+  std::unique_ptr<PatternCache> cache = Create(static_cast<const uint8_t*>(memory), partition->size);
+  if (!cache) {
+    esp_partition_munmap(handle);
+    return nullptr;
+  }
+  cache->unmap_ = [handle]() { esp_partition_munmap(handle); };
+  return cache;
+}
+
+#else  // ESP32
+
+std::unique_ptr<PatternCache> PatternCache::MapFile(const char* path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    jll_error("Failed to open pattern cache %s", path);
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    jll_error("Failed to stat pattern cache %s", path);
+    close(fd);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    jll_error("Failed to map pattern cache %s", path);
+    return nullptr;
+  }
+  std::unique_ptr<PatternCache> cache = Create(static_cast<const uint8_t*>(memory), size);
+  if (!cache) {
+    munmap(memory, size);
+    return nullptr;
+  }
+  cache->unmap_ = [memory, size]() { munmap(memory, size); };
+  return cache;
+}
+
+#endif  // ESP32
+
+const PatternCacheEntry* PatternCache::FindEntry(PatternBits pattern) const {
+  if (decodedEntry_ != nullptr && decodedEntry_->pattern == pattern) { return decodedEntry_; }
+  for (uint32_t i = 0; i < header_->numPatterns; i++) {
+    if (entries_[i].pattern == pattern) { return &entries_[i]; }
+  }
+  return nullptr;
+}
+
+uint32_t PatternCache::FrameOffset(const PatternCacheEntry& entry, uint32_t frame) const {
+  uint32_t offset;
+  memcpy(&offset, data_ + entry.frameOffsetsOffset + size_t{frame} * sizeof(uint32_t), sizeof(offset));
+  return offset;
+}
+
+const CRGB* PatternCache::FrameAt(PatternBits pattern, Milliseconds time) {
+  if (time < 0) { return nullptr; }
+  const PatternCacheEntry* entry = FindEntry(pattern);
+  if (entry == nullptr) { return nullptr; }
+  const uint64_t frame = static_cast<uint64_t>(time) * header_->framesPerSecond / 1000;
+  if (frame >= entry->numFrames) { return nullptr; }
+  const uint32_t keyframe = static_cast<uint32_t>(frame) / header_->keyframeInterval * header_->keyframeInterval;
+  uint32_t nextFrame;
+  if (entry == decodedEntry_ && decodedFrame_ <= frame && decodedFrame_ >= keyframe) {
+    // Sequential playback, only decode the frames since the last one.
+    nextFrame = decodedFrame_ + 1;
+  } else {
+    for (CRGB& color : frame_) { color = CRGB::Black; }
+    nextFrame = keyframe;
+  }
+  decodedEntry_ = nullptr;
+  for (; nextFrame <= frame; nextFrame++) {
+    if (!DecodeFrame(*entry, nextFrame)) {
+      jll_error("Corrupt frame %u of pattern %08x in pattern cache", nextFrame, pattern);
+      return nullptr;
+    }
+  }
+  decodedEntry_ = entry;
+  decodedFrame_ = static_cast<uint32_t>(frame);
+  return frame_.data();
+}
+
+bool PatternCache::DecodeFrame(const PatternCacheEntry& entry, uint32_t frame) {
+  size_t position = FrameOffset(entry, frame);
+  const size_t end = FrameOffset(entry, frame + 1);
+  if (position > end || end > size_) { return false; }
+  const size_t numLeds = frame_.size();
+  size_t led = 0;
+  while (led < numLeds) {
+    uint32_t run;
+    if (!ReadVarint(data_, end, &position, &run)) { return false; }
+    const size_t length = size_t{run >> 2} + 1;
+    if (length > numLeds - led) { return false; }
+    switch (run & 3) {
+      case kSkipRun: break;
+      case kLiteralRun:
+        if (length * 3 > end - position) { return false; }
+        memcpy(&frame_[led], data_ + position, length * 3);
+        position += length * 3;
+        break;
+      case kFillRun: {
+        if (3 > end - position) { return false; }
+        const CRGB color(data_[position], data_[position + 1], data_[position + 2]);
+        position += 3;
+        for (size_t i = 0; i < length; i++) { frame_[led + i] = color; }
+        break;
+      }
+      default: return false;
+    }
+    led += length;
+  }
+  return position == end;
+}
+
+}  // namespace jazzlights
@@ -0,0 +1,140 @@
+#ifndef JL_PATTERN_CACHE_H
+#define JL_PATTERN_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "jazzlights/fastled_wrapper.h"
+#include "jazzlights/layout/layout.h"
+#include "jazzlights/types.h"
+#include "jazzlights/util/time.h"
+
+// Devices can play pre-rendered patterns from a data partition instead of computing them, see PatternCache.
+#ifndef JL_PATTERN_CACHE
+#define JL_PATTERN_CACHE 0
+#endif  // JL_PATTERN_CACHE
+
+namespace jazzlights {
+
+// Pre-rendered patterns are stored as the colors of every LED of every strand, in the order Player renders them, for
+// frames evenly spaced in time starting when the pattern starts. Since effects only depend on the pattern and the time,
+// devices playing the same file at the same pattern time show the same frame, so they stay in sync with each other.
+//
+// File layout, all integers are little endian:
+//  - PatternCacheHeader.
+//  - numPatterns PatternCacheEntry.
+//  - For each pattern, numFrames + 1 uint32_t offsets from the start of the file to the encoded frames, the last one is
+//    the end of the last frame.
+//  - The encoded frames. Each frame is a sequence of runs that cover all LEDs in order. A run starts with a varint,
+//    whose two low bits are its kind and whose other bits are its length minus one. Skip runs keep the colors of the
+//    previous frame, literal runs are followed by 3 bytes of RGB per LED, and fill runs by one RGB color for all their
+//    LEDs. Every keyframeInterval frames, starting with the first one, frames are keyframes which start from all black
+//    instead of the previous frame, so that playback can start anywhere without decoding the whole pattern.
+struct PatternCacheHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t framesPerSecond;
+  uint32_t numLeds;
+  uint32_t layoutFingerprint;
+  uint32_t numPatterns;
+  uint16_t keyframeInterval;
+  uint16_t reserved;
+};
+
+struct PatternCacheEntry {
+  uint32_t pattern;
+  uint32_t numFrames;
+  uint32_t frameOffsetsOffset;
+};
+
+static constexpr uint32_t kPatternCacheMagic = 0x43504C4A;  // "JLPC" in little endian.
+static constexpr uint16_t kPatternCacheVersion = 1;
+
+// Identifies the positions of the LEDs of a set of layouts, so that a cache rendered for one set of layouts is not
+// played on another.
+uint32_t PatternCacheLayoutFingerprint(const std::vector<const Layout*>& layouts);
+
+// Builds a cache file, used by host tools.
+class PatternCacheWriter {
+ public:
+  PatternCacheWriter(size_t numLeds, uint32_t layoutFingerprint, uint16_t framesPerSecond,
+                     uint16_t keyframeInterval = 32);
+
+  // Frames added after this belong to pattern, which must not have been added before.
+  void BeginPattern(PatternBits pattern);
+  // Adds the next frame of the current pattern, colors must contain numLeds colors.
+  void AddFrame(const CRGB* colors);
+  // Returns the contents of the cache file.
+  std::vector<uint8_t> Finish() const;
+
+ private:
+  struct Pattern {
+    PatternBits pattern;
+    // Offset in frameData_ of the first frame.
+    uint32_t dataStart;
+    // Offset in frameData_ of each frame.
+    std::vector<uint32_t> frameOffsets;
+  };
+
+  const size_t numLeds_;
+  const uint32_t layoutFingerprint_;
+  const uint16_t framesPerSecond_;
+  const uint16_t keyframeInterval_;
+  std::vector<Pattern> patterns_;
+  std::vector<uint8_t> frameData_;
+  std::vector<CRGB> previousFrame_;
+};
+
+// Plays back a cache file that is mapped in memory. Decoding only touches the frames between the closest keyframe and
+// the requested frame, and sequential playback decodes a single frame each time.
+class PatternCache {
+ public:
+  // Returns nullptr if data is not a valid cache. data must stay valid and unmodified while the cache is in use.
+  static std::unique_ptr<PatternCache> Create(const uint8_t* data, size_t size);
+#ifdef ESP32
+  // Maps the data partition with this label.
+  static std::unique_ptr<PatternCache> MapPartition(const char* label);
+#else   // ESP32
+  static std::unique_ptr<PatternCache> MapFile(const char* path);
+#endif  // ESP32
+  ~PatternCache();
+  // Disallow copy and move.
+  PatternCache(const PatternCache&) = delete;
+  PatternCache(PatternCache&&) = delete;
+  PatternCache& operator=(const PatternCache&) = delete;
+  PatternCache& operator=(PatternCache&&) = delete;
+
+  size_t numLeds() const { return header_->numLeds; }
+  uint32_t layoutFingerprint() const { return header_->layoutFingerprint; }
+  uint16_t framesPerSecond() const { return header_->framesPerSecond; }
+  bool Contains(PatternBits pattern) const { return FindEntry(pattern) != nullptr; }
+
+  // Returns the colors of all LEDs for pattern at time since the pattern started, or nullptr if pattern is not in the
+  // cache or time is past the end of its frames. The colors are valid until the next call.
+  const CRGB* FrameAt(PatternBits pattern, Milliseconds time);
+
+ private:
+  PatternCache(const uint8_t* data, size_t size);
+  const PatternCacheEntry* FindEntry(PatternBits pattern) const;
+  uint32_t FrameOffset(const PatternCacheEntry& entry, uint32_t frame) const;
+  // Applies one encoded frame on top of frame_, returns false if it is malformed.
+  bool DecodeFrame(const PatternCacheEntry& entry, uint32_t frame);
+
+  const uint8_t* data_;
+  size_t size_;
+  const PatternCacheHeader* header_;
+  const PatternCacheEntry* entries_;
+  // Undoes the mapping of data_, if any.
+  std::function<void()> unmap_;
+
+  std::vector<CRGB> frame_;
+  const PatternCacheEntry* decodedEntry_ = nullptr;
+  uint32_t decodedFrame_ = 0;
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_PATTERN_CACHE_H
@@ -305,6 +305,30 @@ Player& Player::addStrand(const Layout& l, Renderer& r) {
   return *this;
 }
 
+void Player::SetPatternCache(PatternCache* patternCache) {
+  patternCache_ = nullptr;
+  if (patternCache == nullptr) { return; }
+  std::vector<const Layout*> layouts;
+  size_t numLeds = 0;
+  for (const Strand& s : strands_) {
+    layouts.push_back(&s.layout);
+    numLeds += s.layout.pixelCount();
+  }
+  if (patternCache->numLeds() != numLeds ||
+      patternCache->layoutFingerprint() != PatternCacheLayoutFingerprint(layouts)) {
+    jll_error("%u Ignoring pattern cache rendered for different layouts", timeMillis());
+    return;
+  }
+  jll_info("%u Using pattern cache with %zu LEDs at %u FPS", timeMillis(), numLeds, patternCache->framesPerSecond());
+  patternCache_ = patternCache;
+}
+
+void Player::SetStreamReceiver(DdpReceiver* streamReceiver) {
+  streamReceiver_ = streamReceiver;
+  if (streamReceiver == nullptr) { return; }
+  for (const Strand& s : strands_) { streamReceiver->AddStrand(s.layout.pixelCount(), &s.renderer); }
+}
+
 Player& Player::connect(Network* n) {
   jll_info("%u Connecting network %s", timeMillis(), NetworkTypeToString(n->type()));
   networks_.push_back(n);
@@ -327,6 +351,9 @@ void Player::begin() {
   if (frame_.viewport.size.width == 0 || frame_.viewport.size.height == 0) { isAllLinear_ = true; }
   xyIndexStore_.Finalize(frame_.viewport);
   frame_.xyIndexStore = &xyIndexStore_;
+  frame_.strands = &strands_;
+  spatialIndex_.Reset(&strands_);
+  frame_.spatialIndex = &spatialIndex_;
 
   // Figure out localDeviceId_.
   if (!randomizeLocalDeviceId_) {
@@ -471,6 +498,15 @@ bool Player::render(Milliseconds currentTime) {
   // Then give all networks the opportunity to send.
   for (Network* network : networks_) { network->runLoop(currentTime); }
 
+  if (streamReceiver_ != nullptr) {
+    const bool completedStreamFrame = streamReceiver_->Receive(currentTime);
+    if (streamReceiver_->IsStreaming(currentTime)) {
+      // The receiver already wrote the colors, we only need to report complete frames so they get sent to the LEDs.
+      if (completedStreamFrame) { framesComputedThisEpoch_++; }
+      return completedStreamFrame;
+    }
+  }
+
   frame_.context = nullptr;
   if (currentTime - currentPatternStartTime_ > kEffectDuration) {
     frame_.pattern = nextPattern_;
@@ -499,7 +535,8 @@ bool Player::render(Milliseconds currentTime) {
   if (!creatureIsFollowingNonCreature_) { frame_.pattern = planetPattern_; }
 #endif  // ORRERY_PLANET
 
-  const Effect* effect = patternFromBits(frame_.pattern, *this);
+  const Effect* const patternEffect = patternFromBits(frame_.pattern, *this);
+  const Effect* effect = patternEffect;
 #if JL_IS_CONFIG(FAIRY_WAND)
   constexpr Milliseconds kOverridePatternDuration = 8000;
   static const FunctionalEffect fairy_wand_effect = fairy_wand();
@@ -564,29 +601,42 @@ bool Player::render(Milliseconds currentTime) {
 #endif  // CREATURE
 
   const Milliseconds patternComputeStartTime = timeMillis();
-  // Actually render the pixels.
-  predictableRandom_.ResetWithFrameTime(frame_, effect->effectName(frame_.pattern).c_str());
-  effect->rewind(frame_);
-  Pixel px;
-  size_t cumulativeIndex = 0;
-  for (const Strand& s : strands_) {
-    px.strand = &s;
-    const size_t numPixels = s.layout.pixelCount();
-    for (size_t index = 0; index < numPixels; index++) {
-      CRGB color;
-      px.coord = s.layout.at(index);
-      if (!IsEmpty(px.coord)) {
-        px.strandIndex = index;
-        px.cumulativeIndex = cumulativeIndex;
-        color = effect->color(frame_, px);
-      } else {
-        color = CRGB::Black;
+  const CRGB* cachedColors = nullptr;
+  // Strands can be added after the cache was set, so check that it still covers all pixels.
+  if (patternCache_ != nullptr && effect == patternEffect && patternCache_->numLeds() == frame_.pixelCount) {
+    cachedColors = patternCache_->FrameAt(frame_.pattern, frame_.time);
+  }
+  if (cachedColors != nullptr) {
+    // Pre-rendered frames hold the colors of all strands in the same order as the loop below.
+    for (const Strand& s : strands_) {
+      const size_t numPixels = s.layout.pixelCount();
+      for (size_t index = 0; index < numPixels; index++) { s.renderer.renderPixel(index, *cachedColors++); }
+    }
+  } else {
+    // Actually render the pixels.
+    predictableRandom_.ResetWithFrameTime(frame_, effect->effectName(frame_.pattern).c_str());
+    effect->rewind(frame_);
+    Pixel px;
+    size_t cumulativeIndex = 0;
+    for (const Strand& s : strands_) {
+      px.strand = &s;
+      const size_t numPixels = s.layout.pixelCount();
+      for (size_t index = 0; index < numPixels; index++) {
+        CRGB color;
+        px.coord = s.layout.at(index);
+        if (!IsEmpty(px.coord)) {
+          px.strandIndex = index;
+          px.cumulativeIndex = cumulativeIndex;
+          color = effect->color(frame_, px);
+        } else {
+          color = CRGB::Black;
+        }
+        cumulativeIndex++;
+        s.renderer.renderPixel(index, color);
       }
-      cumulativeIndex++;
-      s.renderer.renderPixel(index, color);
     }
+    effect->afterColors(frame_);
   }
-  effect->afterColors(frame_);
 
   // Save data for measuring FPS.
   const Milliseconds patternComputeDuration = timeMillis() - patternComputeStartTime;
@@ -5,9 +5,12 @@
 
 #include "jazzlights/effect/effect.h"
 #include "jazzlights/layout/layout.h"
+#include "jazzlights/network/ddp.h"
 #include "jazzlights/network/network.h"
+#include "jazzlights/pattern_cache.h"
 #include "jazzlights/pseudorandom.h"
 #include "jazzlights/renderer.h"
+#include "jazzlights/spatial_index.h"
 #include "jazzlights/types.h"
 
 namespace jazzlights {
@@ -179,6 +182,14 @@ class Player {
 
   void SetOrrerySceneIdToSend(std::optional<OrrerySceneId> orrerySceneIdToSend);
 
+  // Plays patterns from patternCache instead of computing them whenever it has their frames. Must be called after all
+  // strands were added, and the cache is ignored if it was rendered for different layouts. Not owned.
+  void SetPatternCache(PatternCache* patternCache);
+
+  // Shows the frames streamed to streamReceiver instead of patterns for as long as it receives them. Must be called
+  // after all strands were added. Not owned.
+  void SetStreamReceiver(DdpReceiver* streamReceiver);
+
   bool isAllLinear() const { return isAllLinear_; }
 
  private:
@@ -255,6 +266,8 @@ class Player {
 #endif  // ORRERY_PLANET
 
   NumLedWritesGetter* numLedWritesGetter_ = nullptr;
+  PatternCache* patternCache_ = nullptr;  // Unowned.
+  DdpReceiver* streamReceiver_ = nullptr;  // Unowned.
   std::vector<Network*> networks_;
   std::list<OriginatorEntry> originatorEntries_;
 
@@ -272,6 +285,7 @@ class Player {
   Frame frame_;
   PredictableRandom predictableRandom_;
   XYIndexStore xyIndexStore_;
+  LazySpatialIndex spatialIndex_;
 
   bool paletteIsForced_ = false;
   uint8_t forcedPalette_ = 0;
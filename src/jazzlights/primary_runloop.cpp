@@ -83,6 +83,19 @@ void SetupPrimaryRunLoop() {
 
   AddLedsToRunner(&runner);
 
+#if JL_PATTERN_CACHE
+  // Pre-rendered patterns are flashed to a data partition labeled "patterns", with a file generated by
+  // extras/pattern_cache for this device's layouts.
+  static std::unique_ptr<PatternCache> sPatternCache = PatternCache::MapPartition("patterns");
+  if (sPatternCache) { player.SetPatternCache(sPatternCache.get()); }
+#endif  // JL_PATTERN_CACHE
+
+#if JL_DDP_RECEIVER
+  // Lets a host stream frames that are too heavy to compute here, such as video mapping, see extras/README.md.
+  static std::unique_ptr<DdpReceiver> sDdpReceiver = DdpReceiver::Create();
+  player.SetStreamReceiver(sDdpReceiver.get());
+#endif  // JL_DDP_RECEIVER
+
 #if JL_AUDIO_VISUALIZER
   // Ensures creatures follow the sound reactive dome.
   player.setBasePrecedence(kCreatureOverridePrecedence);
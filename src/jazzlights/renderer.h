@@ -10,6 +10,10 @@ class Renderer {
   virtual ~Renderer() = default;
 
   virtual void renderPixel(size_t index, CRGB color) = 0;
+
+  // Returns the colors that renderPixel writes to if they can be written to directly, which lets colors streamed over
+  // the network be received in place. Returns nullptr otherwise.
+  virtual CRGB* pixelBuffer() { return nullptr; }
 };
 
 }  // namespace jazzlights
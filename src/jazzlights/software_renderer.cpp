@@ -0,0 +1,60 @@
+#include "jazzlights/software_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "jazzlights/util/log.h"
+
+namespace jazzlights {
+
+static_assert(sizeof(CRGB) == 3, "SoftwareRenderer images are exposed as packed RGB24");
+
+SoftwareRenderer::SoftwareRenderer(const Layout& layout, size_t width, size_t height, size_t ledRadius)
+    : width_(width), height_(height), pixels_(width * height, CRGB::Black) {
+  if (width <= 2 * ledRadius || height <= 2 * ledRadius || width * height >= kNoPixel) {
+    jll_fatal("Invalid software renderer size %zux%zu with LED radius %zu", width, height, ledRadius);
+  }
+  const int radius = static_cast<int>(ledRadius);
+  for (int dy = -radius; dy <= radius; dy++) {
+    for (int dx = -radius; dx <= radius; dx++) {
+      if (dx * dx + dy * dy <= radius * radius) { discOffsets_.push_back(dy * static_cast<int32_t>(width) + dx); }
+    }
+  }
+
+  // Map the bounding box of the layout to the area of the image where LED centers can go.
+  const Box box = bounds(layout);
+  const double usableWidth = static_cast<double>(width - 1 - 2 * ledRadius);
+  const double usableHeight = static_cast<double>(height - 1 - 2 * ledRadius);
+  double scale = 0;
+  if (box.size.width > 0 && box.size.height > 0) {
+    scale = std::min(usableWidth / box.size.width, usableHeight / box.size.height);
+  } else if (box.size.width > 0) {
+    scale = usableWidth / box.size.width;
+  } else if (box.size.height > 0) {
+    scale = usableHeight / box.size.height;
+  }
+  // Center the layout along the axis that does not fill the image.
+  const double offsetX = ledRadius + (usableWidth - box.size.width * scale) / 2;
+  const double offsetY = ledRadius + (usableHeight - box.size.height * scale) / 2;
+
+  const size_t numLeds = layout.pixelCount();
+  ledCenters_.resize(numLeds, kNoPixel);
+  for (size_t index = 0; index < numLeds; index++) {
+    const Point p = layout.at(index);
+    if (std::isnan(p.x) || std::isnan(p.y)) { continue; }
+    const double x = std::round(offsetX + (p.x - box.origin.x) * scale);
+    const double y = std::round(offsetY + (p.y - box.origin.y) * scale);
+    const size_t px = static_cast<size_t>(std::clamp(x, static_cast<double>(ledRadius), usableWidth + ledRadius));
+    const size_t py = static_cast<size_t>(std::clamp(y, static_cast<double>(ledRadius), usableHeight + ledRadius));
+    ledCenters_[index] = static_cast<uint32_t>(py * width + px);
+  }
+}
+
+void SoftwareRenderer::renderPixel(size_t index, CRGB color) {
+  const uint32_t center = ledCenters_[index];
+  if (center == kNoPixel) { return; }
+  CRGB* pixel = &pixels_[center];
+  for (int32_t offset : discOffsets_) { pixel[offset] = color; }
+}
+
+}  // namespace jazzlights
@@ -0,0 +1,53 @@
+#ifndef JL_SOFTWARE_RENDERER_H
+#define JL_SOFTWARE_RENDERER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "jazzlights/fastled_wrapper.h"
+#include "jazzlights/layout/layout.h"
+#include "jazzlights/renderer.h"
+
+namespace jazzlights {
+
+// Draws LEDs into an in-memory RGB image instead of sending them to hardware or a window, so patterns can be rendered
+// on machines without a display or GPU, for example to record them or to compare them against reference images. Each
+// LED is a filled disc at its layout position, and the bounding box of the layout is scaled to fit in the image while
+// keeping its aspect ratio. Where each LED lands is computed once at construction, so rendering an LED only stores its
+// color into the pixels of its disc.
+class SoftwareRenderer : public Renderer {
+ public:
+  // ledRadius is in image pixels, 0 draws each LED as a single pixel. The image must be wider and taller than
+  // 2 * ledRadius.
+  SoftwareRenderer(const Layout& layout, size_t width, size_t height, size_t ledRadius = 0);
+  // Disallow copy and move since the image can be large.
+  SoftwareRenderer(const SoftwareRenderer&) = delete;
+  SoftwareRenderer(SoftwareRenderer&&) = delete;
+  SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+  SoftwareRenderer& operator=(SoftwareRenderer&&) = delete;
+
+  void renderPixel(size_t index, CRGB color) override;
+
+  size_t width() const { return width_; }
+  size_t height() const { return height_; }
+  // Row-major image of width() * height() pixels. CRGB is three bytes in red, green, blue order, so this is also a
+  // packed RGB24 image. Pixels outside of all LEDs stay black.
+  const CRGB* pixels() const { return pixels_.data(); }
+
+ private:
+  static constexpr uint32_t kNoPixel = UINT32_MAX;
+
+  const size_t width_;
+  const size_t height_;
+  std::vector<CRGB> pixels_;
+  // Index in pixels_ of the center of each LED, or kNoPixel for LEDs without a position.
+  std::vector<uint32_t> ledCenters_;
+  // Offsets from the center of an LED to each pixel of its disc. Layouts are scaled to leave a margin of ledRadius
+  // around the image so that discs never need to be clipped.
+  std::vector<int32_t> discOffsets_;
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_SOFTWARE_RENDERER_H
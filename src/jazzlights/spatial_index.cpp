@@ -0,0 +1,148 @@
+#include "jazzlights/spatial_index.h"
+
+#include <algorithm>
+
+#include "jazzlights/layout/layout.h"
+
+namespace jazzlights {
+namespace {
+
+// Keeps the k closest pixels seen so far, closest first. k is small so insertion sort beats a heap.
+class NearestList {
+ public:
+  NearestList(size_t k, uint32_t exclude) : k_(k), exclude_(exclude) {}
+
+  void Add(uint32_t index, float distanceSquared) {
+    if (index == exclude_ || (count_ == k_ && distanceSquared >= distancesSquared_[count_ - 1])) { return; }
+    size_t i = count_ < k_ ? count_++ : count_ - 1;
+    for (; i > 0 && distancesSquared_[i - 1] > distanceSquared; i--) {
+      distancesSquared_[i] = distancesSquared_[i - 1];
+      indices_[i] = indices_[i - 1];
+    }
+    distancesSquared_[i] = distanceSquared;
+    indices_[i] = index;
+  }
+
+  bool full() const { return count_ == k_; }
+  float farthestDistanceSquared() const { return distancesSquared_[count_ - 1]; }
+  size_t count() const { return count_; }
+  const uint32_t* indices() const { return indices_; }
+
+ private:
+  const size_t k_;
+  const uint32_t exclude_;
+  size_t count_ = 0;
+  float distancesSquared_[SpatialIndex::kMaxNearest];
+  uint32_t indices_[SpatialIndex::kMaxNearest];
+};
+
+}  // namespace
+
+void SpatialIndex::Build(const std::vector<Strand>& strands) {
+  entries_.clear();
+  cellStarts_.clear();
+  pixelCount_ = 0;
+  columns_ = 0;
+  rows_ = 0;
+  Coord minX = 0, minY = 0, maxX = 0, maxY = 0;
+  for (const Strand& strand : strands) {
+    const size_t strandPixelCount = strand.layout.pixelCount();
+    for (size_t i = 0; i < strandPixelCount; i++) {
+      const Point point = strand.layout.at(i);
+      const uint32_t index = pixelCount_ + i;
+      if (IsEmpty(point)) { continue; }
+      if (entries_.empty()) {
+        minX = maxX = point.x;
+        minY = maxY = point.y;
+      } else {
+        minX = std::min(minX, point.x);
+        maxX = std::max(maxX, point.x);
+        minY = std::min(minY, point.y);
+        maxY = std::max(maxY, point.y);
+      }
+      entries_.push_back({static_cast<float>(point.x), static_cast<float>(point.y), index});
+    }
+    pixelCount_ += strandPixelCount;
+  }
+  if (entries_.empty()) { return; }
+
+  // Aim for about two pixels per cell. The first estimate suits pixels spread over an area and the second suits pixels
+  // along a line, which would otherwise get cells so small that most of them would be empty.
+  const size_t count = entries_.size();
+  const Coord w = maxX - minX;
+  const Coord h = maxY - minY;
+  origin_ = {minX, minY};
+  cellSize_ = std::max(std::sqrt(w * h * 2 / count), (w + h) * 2 / count);
+  if (!(cellSize_ > 0)) { cellSize_ = 1; }
+  while (true) {
+    columns_ = static_cast<size_t>(w / cellSize_) + 1;
+    rows_ = static_cast<size_t>(h / cellSize_) + 1;
+    if (columns_ * rows_ <= 4 * count + 16) { break; }
+    cellSize_ *= 2;
+  }
+
+  // Counting sort of the entries by cell.
+  const size_t cellCount = columns_ * rows_;
+  std::vector<uint32_t> cellOfEntry(count);
+  cellStarts_.assign(cellCount + 1, 0);
+  for (size_t i = 0; i < count; i++) {
+    const size_t cell = CellFor(entries_[i].y, origin_.y, cellSize_, rows_) * columns_ +
+                        CellFor(entries_[i].x, origin_.x, cellSize_, columns_);
+    cellOfEntry[i] = cell;
+    cellStarts_[cell + 1]++;
+  }
+  for (size_t cell = 0; cell < cellCount; cell++) { cellStarts_[cell + 1] += cellStarts_[cell]; }
+  std::vector<uint32_t> nextInCell(cellStarts_.begin(), cellStarts_.end() - 1);
+  std::vector<Entry> sorted(count);
+  for (size_t i = 0; i < count; i++) { sorted[nextInCell[cellOfEntry[i]]++] = entries_[i]; }
+  entries_.swap(sorted);
+  entries_.shrink_to_fit();
+}
+
+size_t SpatialIndex::Nearest(Point center, size_t k, uint32_t* indices, uint32_t exclude) const {
+  k = std::min(k, kMaxNearest);
+  if (k == 0 || entries_.empty()) { return 0; }
+  NearestList nearest(k, exclude);
+  const auto scanCells = [&](size_t row, size_t firstColumn, size_t lastColumn) {
+    const Entry* entry = &entries_[cellStarts_[row * columns_ + firstColumn]];
+    const Entry* end = &entries_[0] + cellStarts_[row * columns_ + lastColumn + 1];
+    for (; entry < end; entry++) {
+      const float dx = entry->x - static_cast<float>(center.x);
+      const float dy = entry->y - static_cast<float>(center.y);
+      nearest.Add(entry->index, dx * dx + dy * dy);
+    }
+  };
+  // Visit rings of cells around the cell of center, moving outwards. Once ring r is done, every pixel we have not seen
+  // is more than r cells away from center, so we can stop as soon as the k-th closest pixel is nearer than that.
+  const long centerColumn = CellFor(center.x, origin_.x, cellSize_, columns_);
+  const long centerRow = CellFor(center.y, origin_.y, cellSize_, rows_);
+  const long lastColumn = columns_ - 1;
+  const long lastRow = rows_ - 1;
+  const long maxRing = std::max(std::max(centerColumn, lastColumn - centerColumn),
+                                std::max(centerRow, lastRow - centerRow));
+  for (long ring = 0; ring <= maxRing; ring++) {
+    const long left = std::max(centerColumn - ring, 0L);
+    const long right = std::min(centerColumn + ring, lastColumn);
+    for (long row = std::max(centerRow - ring, 0L); row <= std::min(centerRow + ring, lastRow); row++) {
+      if (row == centerRow - ring || row == centerRow + ring) {
+        scanCells(row, left, right);
+      } else {
+        if (centerColumn - ring >= 0) { scanCells(row, centerColumn - ring, centerColumn - ring); }
+        if (centerColumn + ring <= lastColumn) { scanCells(row, centerColumn + ring, centerColumn + ring); }
+      }
+    }
+    const float seen = ring * cellSize_;
+    if (nearest.full() && nearest.farthestDistanceSquared() <= seen * seen) { break; }
+  }
+  std::copy(nearest.indices(), nearest.indices() + nearest.count(), indices);
+  return nearest.count();
+}
+
+void SpatialIndex::ComputeNeighborLists(size_t k, uint32_t* neighbors) const {
+  std::fill(neighbors, neighbors + pixelCount_ * k, kNoPixel);
+  for (const Entry& entry : entries_) {
+    Nearest({entry.x, entry.y}, k, &neighbors[entry.index * k], entry.index);
+  }
+}
+
+}  // namespace jazzlights
@@ -0,0 +1,131 @@
+#ifndef JL_SPATIAL_INDEX_H
+#define JL_SPATIAL_INDEX_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "jazzlights/types.h"
+#include "jazzlights/util/geom.h"
+
+namespace jazzlights {
+
+// Finds the pixels near a point using the actual coordinates of every strand, whereas XYIndexStore quantizes them to a
+// grid of at most 100x100. Pixels are bucketed into a uniform grid of cells that hold about two pixels each, so queries
+// only look at the cells around the point. This lets effects propagate things between neighboring pixels in time
+// proportional to the number of neighbors instead of the number of pixels. Pixels are identified by their cumulative
+// index, the same as Pixel::cumulativeIndex, and empty pixels are never returned.
+class SpatialIndex {
+ public:
+  static constexpr uint32_t kNoPixel = std::numeric_limits<uint32_t>::max();
+  // Largest k supported by Nearest() and ComputeNeighborLists().
+  static constexpr size_t kMaxNearest = 32;
+
+  SpatialIndex() = default;
+  // Disallow copy and move.
+  SpatialIndex(const SpatialIndex&) = delete;
+  SpatialIndex(SpatialIndex&&) = delete;
+  SpatialIndex& operator=(const SpatialIndex&) = delete;
+  SpatialIndex& operator=(SpatialIndex&&) = delete;
+
+  // Replaces the contents of the index with the pixels of strands.
+  void Build(const std::vector<Strand>& strands);
+
+  // Number of pixels of all strands, including empty ones.
+  size_t pixelCount() const { return pixelCount_; }
+  // Side of the square grid cells.
+  Coord cellSize() const { return cellSize_; }
+
+  // Calls callback(index, distanceSquared) for every pixel within radius of center, in no particular order.
+  template <typename Callback>
+  void ForEachWithinRadius(Point center, Coord radius, Callback callback) const;
+
+  // Writes the indices of the up to k pixels closest to center to indices, closest first, and returns how many were
+  // written. Pixel exclude is skipped, which lets callers find the neighbors of a pixel.
+  size_t Nearest(Point center, size_t k, uint32_t* indices, uint32_t exclude = kNoPixel) const;
+
+  // Fills neighbors, which must hold pixelCount() * k entries, with the k pixels closest to each pixel, closest first.
+  // Entries are kNoPixel for empty pixels and when there are fewer than k other pixels.
+  void ComputeNeighborLists(size_t k, uint32_t* neighbors) const;
+
+ private:
+  struct Entry {
+    float x;
+    float y;
+    uint32_t index;
+  };
+  // Returns the column or row of the cell that holds coordinate v, clamped to the grid.
+  static size_t CellFor(Coord v, Coord origin, Coord cellSize, size_t count) {
+    const Coord cell = std::floor((v - origin) / cellSize);
+    if (!(cell > 0)) { return 0; }
+    if (cell >= count) { return count - 1; }
+    return static_cast<size_t>(cell);
+  }
+
+  size_t pixelCount_ = 0;
+  Point origin_ = {0, 0};
+  Coord cellSize_ = 1;
+  size_t columns_ = 0;
+  size_t rows_ = 0;
+  // Entries of the pixels of each cell, cells are in row-major order.
+  std::vector<Entry> entries_;
+  // Entries of cell i are from cellStarts_[i] to cellStarts_[i + 1].
+  std::vector<uint32_t> cellStarts_;
+};
+
+// Builds a SpatialIndex of strands the first time an effect asks for it, so that devices whose effects never need
+// neighbors do not spend the time and memory. Not thread-safe, only use it from the thread that renders frames.
+class LazySpatialIndex {
+ public:
+  // Call whenever strands changes. Does not build anything.
+  void Reset(const std::vector<Strand>* strands) {
+    strands_ = strands;
+    built_ = false;
+  }
+
+  const SpatialIndex& Get() const {
+    if (!built_) {
+      index_.Build(strands_ != nullptr ? *strands_ : std::vector<Strand>());
+      built_ = true;
+    }
+    return index_;
+  }
+
+ private:
+  const std::vector<Strand>* strands_ = nullptr;
+  mutable bool built_ = false;
+  mutable SpatialIndex index_;
+};
+
+template <typename Callback>
+void SpatialIndex::ForEachWithinRadius(Point center, Coord radius, Callback callback) const {
+  if (entries_.empty() || !(radius >= 0)) { return; }
+  const Coord right = origin_.x + columns_ * cellSize_;
+  const Coord bottom = origin_.y + rows_ * cellSize_;
+  if (center.x + radius < origin_.x || center.x - radius > right || center.y + radius < origin_.y ||
+      center.y - radius > bottom) {
+    return;
+  }
+  const size_t firstColumn = CellFor(center.x - radius, origin_.x, cellSize_, columns_);
+  const size_t lastColumn = CellFor(center.x + radius, origin_.x, cellSize_, columns_);
+  const size_t firstRow = CellFor(center.y - radius, origin_.y, cellSize_, rows_);
+  const size_t lastRow = CellFor(center.y + radius, origin_.y, cellSize_, rows_);
+  const float radiusSquared = radius * radius;
+  for (size_t row = firstRow; row <= lastRow; row++) {
+    // Cells of a row are contiguous, so we can scan from the first to the last cell at once.
+    const Entry* entry = &entries_[cellStarts_[row * columns_ + firstColumn]];
+    const Entry* end = &entries_[0] + cellStarts_[row * columns_ + lastColumn + 1];
+    for (; entry < end; entry++) {
+      const float dx = entry->x - static_cast<float>(center.x);
+      const float dy = entry->y - static_cast<float>(center.y);
+      const float distanceSquared = dx * dx + dy * dy;
+      if (distanceSquared <= radiusSquared) { callback(entry->index, distanceSquared); }
+    }
+  }
+}
+
+}  // namespace jazzlights
+
+#endif  // JL_SPATIAL_INDEX_H
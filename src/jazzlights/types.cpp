@@ -81,6 +81,16 @@ void XYIndexStore::Finalize(const Box& viewport) {
       li.xyIndices[i] = xyIndex;
     }
   }
+  xValues_.resize(xValuesCount_);
+  for (size_t xi = 0; xi < xValuesCount_; xi++) {
+    xValues_[xi] = useSmallerXGrid_ ? viewport.origin.x + (xi + 0.5) * viewport.size.width / kSmallerGridSize
+                                    : xValues[xi];
+  }
+  yValues_.resize(yValuesCount_);
+  for (size_t yi = 0; yi < yValuesCount_; yi++) {
+    yValues_[yi] = useSmallerYGrid_ ? viewport.origin.y + (yi + 0.5) * viewport.size.height / kSmallerGridSize
+                                    : yValues[yi];
+  }
 }
 
 XYIndex XYIndexStore::FromPixel(const Pixel& pixel) const {
@@ -94,6 +104,8 @@ XYIndexStore::XYIndexStore() { Reset(); }
 
 void XYIndexStore::Reset() {
   layoutInfos_.clear();
+  xValues_.clear();
+  yValues_.clear();
   xValuesCount_ = 0;
   yValuesCount_ = 0;
 }
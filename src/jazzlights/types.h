@@ -78,6 +78,10 @@ class XYIndexStore {
   XYIndex FromPixel(const Pixel& pixel) const;
   size_t xValuesCount() const { return xValuesCount_; }
   size_t yValuesCount() const { return yValuesCount_; }
+  // Returns the coordinate that xIndex or yIndex stands for. When the grid is coarser than the layout, this is the
+  // center of the grid cell.
+  Coord xValue(size_t xIndex) const { return xValues_[xIndex]; }
+  Coord yValue(size_t yIndex) const { return yValues_[yIndex]; }
 
  private:
   struct LayoutInfo {
@@ -85,6 +89,8 @@ class XYIndexStore {
     std::vector<XYIndex> xyIndices;
   };
   std::vector<LayoutInfo> layoutInfos_;
+  std::vector<Coord> xValues_;
+  std::vector<Coord> yValues_;
   size_t xValuesCount_;
   size_t yValuesCount_;
   bool useSmallerXGrid_;
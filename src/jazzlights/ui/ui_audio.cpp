@@ -6,6 +6,9 @@
 #include <Arduino.h>
 #include <M5Unified.h>
 
+#include <esp_timer.h>
+
+#include <algorithm>
 #include <cinttypes>
 #include <cstring>
 
@@ -16,6 +19,56 @@
 
 namespace jazzlights {
 
+namespace {
+
+// Color of a spectrum bar, based on its frequency (Rainbow).
+uint16_t BandColor(int band) {
+  float hue = (float)band / Audio::kNumBands * 255.0f;
+  // Simple HSV to RGB mapping (V=1, S=1)
+  uint8_t r, g, b;
+  float sector = hue / 42.5f;  // 6 sectors
+  int i_sector = (int)sector;
+  float f_sector = sector - i_sector;
+  uint8_t p = 0;
+  uint8_t q = (uint8_t)(255 * (1.0f - f_sector));
+  uint8_t t = (uint8_t)(255 * f_sector);
+  switch (i_sector) {
+    case 0:
+      r = 255;
+      g = t;
+      b = p;
+      break;
+    case 1:
+      r = q;
+      g = 255;
+      b = p;
+      break;
+    case 2:
+      r = p;
+      g = 255;
+      b = t;
+      break;
+    case 3:
+      r = p;
+      g = q;
+      b = 255;
+      break;
+    case 4:
+      r = t;
+      g = p;
+      b = 255;
+      break;
+    default:
+      r = 255;
+      g = p;
+      b = q;
+      break;
+  }
+  return M5.Display.color565(r, g, b);
+}
+
+}  // namespace
+
 AudioVisualizerUi::AudioVisualizerUi(Player& player) : Esp32Ui(player) {}
 
 void AudioVisualizerUi::InitialSetup() {
@@ -29,13 +82,81 @@ void AudioVisualizerUi::InitialSetup() {
   jll_info("M5 device initialized");
 
   M5.Display.setBrightness(128);
-  M5.Display.fillScreen(BLACK);
+  ClearScreen();
+  for (int i = 0; i < Audio::kNumBands; i++) { band_colors_[i] = BandColor(i); }
 
   jll_info("Audio visualizer UI setup complete");
 }
 
 void AudioVisualizerUi::FinalSetup() {}
 
+void AudioVisualizerUi::ClearScreen() {
+  M5.Display.fillScreen(BLACK);
+  memset(drawn_bar_heights_, 0, sizeof(drawn_bar_heights_));
+  memset(drawn_peak_heights_, 0, sizeof(drawn_peak_heights_));
+  memset(drawn_column_heights_, 0, sizeof(drawn_column_heights_));
+  memset(drawn_column_beats_, 0, sizeof(drawn_column_beats_));
+  next_damage_index_ = 0;
+}
+
+template <typename PaintFunction>
+bool AudioVisualizerUi::PaintWithinBudget(int count, PaintFunction paint) {
+  const int64_t start_time = esp_timer_get_time();
+  for (int painted = 0; painted < count; painted++) {
+    if (painted > 0 && esp_timer_get_time() - start_time >= JL_AUDIO_VISUALIZER_UI_BUDGET_US) { return false; }
+    paint(next_damage_index_);
+    next_damage_index_ = (next_damage_index_ + 1) % count;
+  }
+  return true;
+}
+
+void AudioVisualizerUi::PaintSpectrumBar(int band, int height, int peak_height) {
+  const int bar_width = kScreenWidth / Audio::kNumBands;
+  const int x = band * bar_width;
+  const int old_height = drawn_bar_heights_[band];
+  const int old_peak_height = drawn_peak_heights_[band];
+  // Only paint the rows between the old and new tops of the bar.
+  if (height > old_height) {
+    M5.Display.fillRect(x, kScreenHeight - height, bar_width - 1, height - old_height, band_colors_[band]);
+  } else if (height < old_height) {
+    M5.Display.fillRect(x, kScreenHeight - old_height, bar_width - 1, old_height - height, BLACK);
+  }
+  // Restore what was under the old peak indicator.
+  if (old_peak_height != peak_height && old_peak_height > 0 && old_peak_height <= height) {
+    M5.Display.drawFastHLine(x, kScreenHeight - old_peak_height, bar_width - 1, band_colors_[band]);
+  } else if (old_peak_height != peak_height && old_peak_height > 0) {
+    M5.Display.drawFastHLine(x, kScreenHeight - old_peak_height, bar_width - 1, BLACK);
+  }
+  // The peak indicator is drawn over the bar, so it also needs to be drawn again if the bar was painted over it.
+  if (peak_height > 0 && (peak_height != old_peak_height || (peak_height > std::min(height, old_height) &&
+                                                             peak_height <= std::max(height, old_height)))) {
+    M5.Display.drawFastHLine(x, kScreenHeight - peak_height, bar_width - 1, WHITE);
+  }
+  drawn_bar_heights_[band] = height;
+  drawn_peak_heights_[band] = peak_height;
+}
+
+void AudioVisualizerUi::PaintWaveformColumn(int x, int height, bool is_beat) {
+  const int old_height = drawn_column_heights_[x];
+  if (is_beat != drawn_column_beats_[x]) {
+    if (is_beat) {
+      M5.Display.drawFastVLine(x, 0, kScreenHeight, RED);
+    } else {
+      if (height < kScreenHeight) { M5.Display.drawFastVLine(x, 0, kScreenHeight - height, BLACK); }
+      if (height > 0) { M5.Display.drawFastVLine(x, kScreenHeight - height, height, CYAN); }
+    }
+  } else if (!is_beat) {
+    // Only paint the rows between the old and new tops of the column.
+    if (height > old_height) {
+      M5.Display.drawFastVLine(x, kScreenHeight - height, height - old_height, CYAN);
+    } else if (height < old_height) {
+      M5.Display.drawFastVLine(x, kScreenHeight - old_height, old_height - height, BLACK);
+    }
+  }
+  drawn_column_heights_[x] = height;
+  drawn_column_beats_[x] = is_beat;
+}
+
 void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
   M5.update();
   if (M5.Touch.getCount() > 0 && M5.Touch.getDetail(0).wasPressed()) {
@@ -44,11 +165,11 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
       if (detail.y >= 10 && detail.y <= 48 && detail.x >= 20 && detail.x <= 300) {
         visualization_mode_ = VisualizationMode::kSpectrum;
         jll_info("%u Switched to spectrum mode", currentTime);
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       } else if (detail.y >= 53 && detail.y <= 91 && detail.x >= 20 && detail.x <= 300) {
         visualization_mode_ = VisualizationMode::kWaveform;
         jll_info("%u Switched to waveform mode", currentTime);
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       } else if (detail.y >= 96 && detail.y <= 134 && detail.x >= 20 && detail.x <= 300) {
         Player::SoundReactiveMode next_mode;
         switch (player_.sound_reactive_mode()) {
@@ -64,17 +185,17 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
           case Player::SoundReactiveMode::kOff: mode_str = "OFF"; break;
         }
         jll_info("%u Toggled sound reactive to %s", currentTime, mode_str);
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       } else if (detail.y >= 139 && detail.y <= 177 && detail.x >= 20 && detail.x <= 300) {
         visualization_mode_ = VisualizationMode::kBrightnessKeypad;
         keypad_value_ = 0;
         keypad_has_value_ = false;
         jll_info("%u Switched to brightness keypad", currentTime);
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       } else if (detail.y >= 182 && detail.y <= 220 && detail.x >= 20 && detail.x <= 300) {
         visualization_mode_ = VisualizationMode::kPaletteMenu;
         jll_info("%u Switched to palette menu", currentTime);
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       }
     } else if (visualization_mode_ == VisualizationMode::kBrightnessKeypad) {
       const int w = kScreenWidth / 3;
@@ -83,7 +204,7 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
       int row = detail.y / h;
       if (row == 0 && col == 0) {
         visualization_mode_ = VisualizationMode::kMenu;
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       } else if (row >= 1 && row <= 3) {
         int val = (row - 1) * 3 + col + 1;
         if (keypad_value_ < 100) {
@@ -106,7 +227,7 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
             jll_info("%u Set brightness to %" PRId32, currentTime, keypad_value_);
           }
           visualization_mode_ = VisualizationMode::kMenu;
-          M5.Display.fillScreen(BLACK);
+          ClearScreen();
         }
       }
     } else if (visualization_mode_ == VisualizationMode::kPaletteMenu) {
@@ -116,11 +237,11 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
       int row = detail.y / h;
       if (row == 0 && col == 0) {
         visualization_mode_ = VisualizationMode::kMenu;
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       } else if (row == 0 && col == 1) {
         player_.stopForcePalette(currentTime);
         visualization_mode_ = VisualizationMode::kMenu;
-        M5.Display.fillScreen(BLACK);
+        ClearScreen();
       } else {
         int palette_idx = -1;
         if (row == 0 && col == 2)
@@ -141,13 +262,13 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
         if (palette_idx >= 0) {
           player_.forcePalette(static_cast<uint8_t>(palette_idx), currentTime);
           visualization_mode_ = VisualizationMode::kMenu;
-          M5.Display.fillScreen(BLACK);
+          ClearScreen();
         }
       }
     } else {
       visualization_mode_ = VisualizationMode::kMenu;
       jll_info("%u Switched to menu mode", currentTime);
-      M5.Display.fillScreen(BLACK);
+      ClearScreen();
     }
   }
 
@@ -167,22 +288,28 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
     last_waveform_update_ += 12.5;
   }
 
-  // Drawing
-  M5.Display.startWrite();
-
   const bool no_audio_data = data.last_read_time < 0 || currentTime - data.last_read_time > 1000;
   if (no_audio_data != showing_no_audio_data_) {
     showing_no_audio_data_ = no_audio_data;
     jll_info("%u %s 'No Audio Data' mode", currentTime, showing_no_audio_data_ ? "Entered" : "Exited");
-    M5.Display.fillScreen(BLACK);
+    ClearScreen();
   }
 
   if (data.squelch != showing_squelch_) {
     showing_squelch_ = data.squelch;
     jll_info("%u %s 'Squelch' mode", currentTime, showing_squelch_ ? "Entered" : "Exited");
-    M5.Display.fillScreen(BLACK);
+    ClearScreen();
   }
 
+  if (!damage_pending_ && last_draw_time_ >= 0 && currentTime - last_draw_time_ < 1000 / JL_AUDIO_VISUALIZER_UI_FPS) {
+    return;
+  }
+  last_draw_time_ = currentTime;
+  damage_pending_ = false;
+
+  // Drawing
+  M5.Display.startWrite();
+
   if (visualization_mode_ == VisualizationMode::kMenu) {
     M5.Display.setTextSize(2);
     M5.Display.setTextDatum(MC_DATUM);
@@ -298,12 +425,11 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
     M5.Display.drawString("Squelch", kScreenWidth / 2, 20);
     M5.Display.setTextSize(1);
   } else {
-    int bar_width = kScreenWidth / Audio::kNumBands;
     if (visualization_mode_ == VisualizationMode::kSpectrum) {
       float max_db = data.agc_max;
       float min_db = max_db - 30.0f;  // Use a fixed 30dB dynamic range for the spectrum to keep it bright
 
-      for (int i = 0; i < Audio::kNumBands; i++) {
+      damage_pending_ = !PaintWithinBudget(Audio::kNumBands, [&](int i) {
         float mag = data.bands[i];
         int h = (int)((mag - min_db) * kScreenHeight / (max_db - min_db));
         if (h > kScreenHeight) h = kScreenHeight;
@@ -314,80 +440,21 @@ void AudioVisualizerUi::RunLoop(Milliseconds currentTime) {
         if (ph > kScreenHeight) ph = kScreenHeight;
         if (ph < 0) ph = 0;
 
-        int x = i * bar_width;
-
-        // Calculate color based on frequency (Rainbow)
-        float hue = (float)i / Audio::kNumBands * 255.0f;
-        // Simple HSV to RGB mapping (V=1, S=1)
-        uint8_t r, g, b;
-        float sector = hue / 42.5f;  // 6 sectors
-        int i_sector = (int)sector;
-        float f_sector = sector - i_sector;
-        uint8_t p = 0;
-        uint8_t q = (uint8_t)(255 * (1.0f - f_sector));
-        uint8_t t = (uint8_t)(255 * f_sector);
-        switch (i_sector) {
-          case 0:
-            r = 255;
-            g = t;
-            b = p;
-            break;
-          case 1:
-            r = q;
-            g = 255;
-            b = p;
-            break;
-          case 2:
-            r = p;
-            g = 255;
-            b = t;
-            break;
-          case 3:
-            r = p;
-            g = q;
-            b = 255;
-            break;
-          case 4:
-            r = t;
-            g = p;
-            b = 255;
-            break;
-          default:
-            r = 255;
-            g = p;
-            b = q;
-            break;
-        }
-        uint16_t color = M5.Display.color565(r, g, b);
-
-        // Draw bar - clear background above bar
-        if (h < kScreenHeight) { M5.Display.fillRect(x, 0, bar_width - 1, kScreenHeight - h, BLACK); }
-        // Draw the main bar
-        M5.Display.fillRect(x, kScreenHeight - h, bar_width - 1, h, color);
-
-        // Draw peak indicator (single line or small rect)
-        if (ph > 0) { M5.Display.drawFastHLine(x, kScreenHeight - ph, bar_width - 1, WHITE); }
-      }
+        PaintSpectrumBar(i, h, ph);
+      });
     } else {
       float max_db = data.agc_max;
       float min_db = data.agc_min;
-      // Waveform drawing logic
-      for (int i = 0; i < kScreenWidth; i++) {
+      // The waveform scrolls right by one column per sample. The panel can only scroll along its other axis, so instead
+      // of scrolling we only paint the difference between each column and the one that was previously to its left.
+      damage_pending_ = !PaintWithinBudget(kScreenWidth, [&](int i) {
         int idx = (waveform_index_ - 1 - i + kScreenWidth) % kScreenWidth;
         float mag = waveform_buffer_[idx];
-        bool is_beat = beat_buffer_[idx];
         int h = (int)((mag - min_db) * kScreenHeight / (max_db - min_db));
         if (h > kScreenHeight) h = kScreenHeight;
         if (h < 0) h = 0;
-
-        // Clear top, draw line
-        if (is_beat) {
-          M5.Display.drawFastVLine(i, 0, kScreenHeight, RED);
-        } else {
-          if (h < kScreenHeight) { M5.Display.drawFastVLine(i, 0, kScreenHeight - h, BLACK); }
-          if (h > 0) { M5.Display.drawFastVLine(i, kScreenHeight - h, h, CYAN); }
-        }
-      }
+        PaintWaveformColumn(i, h, beat_buffer_[idx]);
+      });
     }
   }
 
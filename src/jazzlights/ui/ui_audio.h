@@ -13,8 +13,20 @@
 
 #include "jazzlights/audio.h"
 
+// The screen is redrawn at most this many times per second.
+#ifndef JL_AUDIO_VISUALIZER_UI_FPS
+#define JL_AUDIO_VISUALIZER_UI_FPS 30
+#endif  // JL_AUDIO_VISUALIZER_UI_FPS
+
+// Longest time in microseconds that one RunLoop spends drawing the spectrum or waveform, the rest is drawn next time.
+#ifndef JL_AUDIO_VISUALIZER_UI_BUDGET_US
+#define JL_AUDIO_VISUALIZER_UI_BUDGET_US 2000
+#endif  // JL_AUDIO_VISUALIZER_UI_BUDGET_US
+
 namespace jazzlights {
 
+// The spectrum and waveform views remember what they last drew and only paint the parts of bars and columns whose
+// height changed, which keeps SPI traffic on the primary runloop small.
 class AudioVisualizerUi : public Esp32Ui {
  public:
   explicit AudioVisualizerUi(Player& player);
@@ -27,6 +39,14 @@ class AudioVisualizerUi : public Esp32Ui {
   static constexpr int kScreenWidth = 320;
   static constexpr int kScreenHeight = 240;
   enum class VisualizationMode { kMenu, kSpectrum, kWaveform, kBrightnessKeypad, kPaletteMenu };
+  // Fills the screen with black and resets what the spectrum and waveform views have drawn to match.
+  void ClearScreen();
+  // Calls paint for each of count bars or columns, starting where the previous call ran out of time. Returns false if
+  // it ran out of time before painting all of them.
+  template <typename PaintFunction>
+  bool PaintWithinBudget(int count, PaintFunction paint);
+  void PaintSpectrumBar(int band, int height, int peak_height);
+  void PaintWaveformColumn(int x, int height, bool is_beat);
   VisualizationMode visualization_mode_ = VisualizationMode::kSpectrum;
   int32_t keypad_value_ = 0;
   bool keypad_has_value_ = false;
@@ -36,6 +56,16 @@ class AudioVisualizerUi : public Esp32Ui {
   double last_waveform_update_ = 0;
   bool showing_no_audio_data_ = false;
   bool showing_squelch_ = false;
+  Milliseconds last_draw_time_ = -1;
+  // Whether the last draw ran out of time before painting everything.
+  bool damage_pending_ = false;
+  int next_damage_index_ = 0;
+  uint16_t band_colors_[Audio::kNumBands] = {0};
+  // What is currently on the screen, in pixels from the bottom.
+  int16_t drawn_bar_heights_[Audio::kNumBands] = {0};
+  int16_t drawn_peak_heights_[Audio::kNumBands] = {0};
+  int16_t drawn_column_heights_[kScreenWidth] = {0};
+  bool drawn_column_beats_[kScreenWidth] = {false};
 };
 
 }  // namespace jazzlights
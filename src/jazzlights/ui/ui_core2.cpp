@@ -6,6 +6,8 @@
 
 #include <M5Unified.h>
 
+#include <cstring>
+
 #include "jazzlights/layout/matrix.h"
 #include "jazzlights/network/esp32_ble.h"
 #include "jazzlights/network/wifi.h"
@@ -85,38 +87,97 @@ void DrawSystemTextLine(uint8_t i, const char* text) {
   M5.Display.drawString(text, x, y);
 }
 
-static const Matrix kCore2ScreenPixels(40, 30);
+static constexpr int32_t kMirrorWidth = 40;
+static constexpr int32_t kMirrorHeight = 30;
+static const Matrix kCore2ScreenPixels(kMirrorWidth, kMirrorHeight);
 
+// Mirrors the LEDs on the screen, with each LED drawn as a square cell. Only the cells that changed since they were
+// last drawn are sent to the screen, using DMA so that the SPI transfer of a row overlaps with computing the next rows.
 class Core2ScreenRenderer : public Renderer {
  public:
   Core2ScreenRenderer() {}
-  void setFullScreen(bool fullScreen) { fullScreen_ = fullScreen; }
+  void setFullScreen(bool fullScreen) {
+    if (fullScreen != fullScreen_) { redrawAll_ = true; }
+    fullScreen_ = fullScreen;
+  }
   void toggleEnabled() { setEnabled(!enabled_); }
-  void setEnabled(bool enabled) { enabled_ = enabled; }
+  void setEnabled(bool enabled) {
+    // Other UI drew over the mirror while it was disabled.
+    if (enabled && !enabled_) { redrawAll_ = true; }
+    enabled_ = enabled;
+  }
   void renderPixel(size_t index, CRGB color) override {
-    if (!enabled_) { return; }
-    uint16_t color16 =
+    if (index == 0) { startFrame(); }
+    if (!drawingFrame_) { return; }
+    const int32_t x = index % kMirrorWidth;
+    const int32_t y = index / kMirrorWidth;
+    const uint16_t color16 =
         ((uint16_t)(color.red & 0xF8) << 8) | ((uint16_t)(color.green & 0xFC) << 3) | ((color.blue & 0xF8) >> 3);
-    int32_t x = index % 40;
-    int32_t y = index / 40;
-    int32_t factor = fullScreen_ ? 8 : 4;
-    for (size_t xi = 0; xi < factor; xi++) {
-      for (size_t yi = 0; yi < factor; yi++) { rowColors16_[x * factor + xi + yi * 40 * factor] = color16; }
+    // The screen expects big-endian colors, swapping here saves toggling the display's swap bytes setting.
+    rowColors_[x] = (color16 >> 8) | (color16 << 8);
+    if (x == kMirrorWidth - 1) { drawRow(y); }
+    if (index == kMirrorWidth * kMirrorHeight - 1) { endFrame(/*complete=*/true); }
+  }
+
+ private:
+  void startFrame() {
+    if (writing_) { endFrame(/*complete=*/false); }
+    const Milliseconds currentTime = timeMillis();
+    drawingFrame_ = enabled_ && (redrawAll_ || lastFrameTime_ < 0 ||
+                                 currentTime - lastFrameTime_ >= 1000 / JL_CORE2_SCREEN_MIRROR_FPS);
+    if (drawingFrame_) { lastFrameTime_ = currentTime; }
+  }
+
+  void drawRow(int32_t y) {
+    uint16_t* drawnRow = &drawnColors_[y * kMirrorWidth];
+    int32_t first = 0;
+    int32_t last = kMirrorWidth - 1;
+    if (!redrawAll_) {
+      while (first <= last && rowColors_[first] == drawnRow[first]) { first++; }
+      while (last >= first && rowColors_[last] == drawnRow[last]) { last--; }
+      if (first > last) { return; }
+    }
+    memcpy(&drawnRow[first], &rowColors_[first], (last - first + 1) * sizeof(rowColors_[0]));
+    if (!writing_) {
+      M5.Display.startWrite();
+      writing_ = true;
     }
-    if (x == 39) {
-      bool swap = M5.Display.getSwapBytes();
-      M5.Display.setSwapBytes(true);
-      M5.Display.pushImage(/*x0=*/0, /*y0=*/y * factor, /*w=*/40 * factor, /*h=*/factor, rowColors16_);
-      M5.Display.setSwapBytes(swap);
+    // Each push waits for the previous transfer to complete before starting, so the buffer that is not being sent is
+    // free to fill in the meantime.
+    uint16_t* buffer = rowBuffers_[nextRowBuffer_];
+    nextRowBuffer_ = 1 - nextRowBuffer_;
+    const int32_t factor = fullScreen_ ? 8 : 4;
+    const int32_t width = (last - first + 1) * factor;
+    for (int32_t cell = first; cell <= last; cell++) {
+      for (int32_t xi = 0; xi < factor; xi++) { buffer[(cell - first) * factor + xi] = rowColors_[cell]; }
     }
+    for (int32_t yi = 1; yi < factor; yi++) { memcpy(&buffer[yi * width], buffer, width * sizeof(buffer[0])); }
+    M5.Display.pushImageDMA(/*x=*/first * factor, /*y=*/y * factor, /*w=*/width, /*h=*/factor,
+                            reinterpret_cast<const lgfx::swap565_t*>(buffer));
+  }
+
+  void endFrame(bool complete) {
+    if (writing_) {
+      // This waits for the last transfer, so that the rest of the UI can draw.
+      M5.Display.endWrite();
+      writing_ = false;
+    }
+    if (drawingFrame_ && complete) { redrawAll_ = false; }
+    drawingFrame_ = false;
   }
 
- private:
   bool enabled_ = true;
   bool fullScreen_ = false;
-  // We only process 8 rows in memory at a time because the entire image does not fit on the stack or in SRAM.
-  // One potential alternative would be to keep the image in PSRAM but that would not necessarily be faster.
-  uint16_t rowColors16_[320 * 8] = {};
+  bool redrawAll_ = true;
+  bool drawingFrame_ = false;
+  bool writing_ = false;
+  Milliseconds lastFrameTime_ = -1;
+  uint16_t rowColors_[kMirrorWidth] = {};
+  // Colors currently on the screen, only valid when redrawAll_ is false.
+  uint16_t drawnColors_[kMirrorWidth * kMirrorHeight] = {};
+  // Pixels of one row of cells at the largest size. These need to stay in internal RAM to be usable with DMA.
+  uint16_t rowBuffers_[2][kMirrorWidth * 8 * 8] = {};
+  uint8_t nextRowBuffer_ = 0;
 };
 
 }  // namespace
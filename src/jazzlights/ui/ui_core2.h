@@ -10,6 +10,11 @@
 #define CORE2AWS_LCD_ENABLED 1
 #endif  // CORE2AWS_LCD_ENABLED
 
+// The LED mirror on the screen is refreshed at most this many times per second, regardless of the LED frame rate.
+#ifndef JL_CORE2_SCREEN_MIRROR_FPS
+#define JL_CORE2_SCREEN_MIRROR_FPS 25
+#endif  // JL_CORE2_SCREEN_MIRROR_FPS
+
 #include "jazzlights/player.h"
 #include "jazzlights/ui/ui_disabled.h"
 
@@ -1,7 +1,9 @@
 #include "jazzlights/util/cobs.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "jazzlights/util/log.h"
 
@@ -18,6 +20,43 @@
 #endif  // JL_LOG_COBS_DATA
 
 namespace jazzlights {
+namespace {
+
+// Largest number of non-zero bytes in a single COBS block, encoded with a code of 0xFF.
+constexpr size_t kMaxBlockLength = 0xFE;
+
+// We scan a native machine word at a time: 8 bytes on 64-bit hosts, 4 bytes on ESP32.
+using CobsWord = uintptr_t;
+constexpr CobsWord kLowBits = static_cast<CobsWord>(~static_cast<CobsWord>(0)) / 0xFF;  // 0x0101...01
+constexpr CobsWord kHighBits = kLowBits * 0x80;                                         // 0x8080...80
+
+// Returns the index of the first zero byte in data, or length if there is none. Each word is checked for zero bytes
+// using the classic SWAR bit trick, and we only fall back to looking at individual bytes in the word containing a zero.
+size_t FindZeroByte(const uint8_t* data, size_t length) {
+  size_t i = 0;
+  for (; i + sizeof(CobsWord) <= length; i += sizeof(CobsWord)) {
+    CobsWord word;
+    // memcpy avoids unaligned loads and compiles down to a single load.
+    memcpy(&word, &data[i], sizeof(word));
+    if (((word - kLowBits) & ~word & kHighBits) != 0) { break; }
+  }
+  for (; i < length; ++i) {
+    if (data[i] == 0x00) { return i; }
+  }
+  return length;
+}
+
+// Copies length bytes, which may overlap as long as output does not come after input. Short runs are common with dense
+// data, and for those a plain loop beats the overhead of calling memmove.
+void CopyRun(uint8_t* output, const uint8_t* input, size_t length) {
+  if (length < sizeof(CobsWord)) {
+    for (size_t i = 0; i < length; ++i) { output[i] = input[i]; }
+  } else {
+    memmove(output, input, length);
+  }
+}
+
+}  // namespace
 
 void CobsEncode(const BufferViewU8 inputBuffers[], size_t numInputBuffers, BufferViewU8* encodedOutputBuffer) {
   if (numInputBuffers == 0) {
@@ -31,73 +70,105 @@ void CobsEncode(const BufferViewU8 inputBuffers[], size_t numInputBuffers, Buffe
     }
   }
 
-  uint8_t code = 0x01;
-  size_t inputBufferNum = 0;
-  size_t inputIndex = 0;
+  uint8_t* output = encodedOutputBuffer->data();
+  const size_t outputSize = encodedOutputBuffer->size();
+  if (outputSize == 0) {
+    jll_error("CobsEncode ran out of space 1");
+    return;
+  }
   size_t outputCodeIndex = 0;
   size_t outputIndex = 1;
-  while (true) {
-    while (inputIndex >= inputBuffers[inputBufferNum].size()) {
-      inputBufferNum++;
-      if (inputBufferNum >= numInputBuffers) { break; }
-      inputIndex = 0;
-    }
-    if (inputBufferNum >= numInputBuffers) { break; }
-    if (outputIndex >= encodedOutputBuffer->size()) {
-      jll_error("CobsEncode ran out of space");
-      encodedOutputBuffer->resize(0);
-      return;
-    }
-    if (inputBuffers[inputBufferNum][inputIndex] == 0x00) {
-      (*encodedOutputBuffer)[outputCodeIndex] = code;
-      code = 0x01;
-      outputCodeIndex = outputIndex;
-      outputIndex++;
-    } else {
-      (*encodedOutputBuffer)[outputIndex] = inputBuffers[inputBufferNum][inputIndex];
-      outputIndex++;
-      code++;
-      if (code == 0xFF) {
-        (*encodedOutputBuffer)[outputCodeIndex] = code;
-        code = 0x01;
+  // Number of non-zero bytes in the current block.
+  size_t blockLength = 0;
+  for (size_t inputBufferNum = 0; inputBufferNum < numInputBuffers; ++inputBufferNum) {
+    const uint8_t* input = inputBuffers[inputBufferNum].data();
+    const size_t inputSize = inputBuffers[inputBufferNum].size();
+    size_t inputIndex = 0;
+    while (inputIndex < inputSize) {
+      if (blockLength == kMaxBlockLength) {
+        // Only start a new block once we know there is more data, this keeps us within CobsMaxEncodedSize.
+        output[outputCodeIndex] = 0xFF;
+        if (outputIndex >= outputSize) {
+          jll_error("CobsEncode ran out of space 2");
+          encodedOutputBuffer->resize(0);
+          return;
+        }
         outputCodeIndex = outputIndex;
         outputIndex++;
+        blockLength = 0;
+      }
+      const size_t maxCopyLength = std::min(inputSize - inputIndex, kMaxBlockLength - blockLength);
+      const size_t copyLength = FindZeroByte(&input[inputIndex], maxCopyLength);
+      if (copyLength > outputSize - outputIndex) {
+        jll_error("CobsEncode ran out of space 3");
+        encodedOutputBuffer->resize(0);
+        return;
+      }
+      CopyRun(&output[outputIndex], &input[inputIndex], copyLength);
+      outputIndex += copyLength;
+      inputIndex += copyLength;
+      blockLength += copyLength;
+      if (copyLength < maxCopyLength) {
+        // We found a zero byte, it terminates the current block.
+        output[outputCodeIndex] = static_cast<uint8_t>(blockLength + 1);
+        if (outputIndex >= outputSize) {
+          jll_error("CobsEncode ran out of space 4");
+          encodedOutputBuffer->resize(0);
+          return;
+        }
+        outputCodeIndex = outputIndex;
+        outputIndex++;
+        blockLength = 0;
+        inputIndex++;
       }
     }
-    inputIndex++;
   }
-  (*encodedOutputBuffer)[outputCodeIndex] = code;
+  output[outputCodeIndex] = static_cast<uint8_t>(blockLength + 1);
   encodedOutputBuffer->resize(outputIndex);
 }
 
 void CobsDecode(const BufferViewU8 encodedInputBuffer, BufferViewU8* outputBuffer) {
+  const uint8_t* input = encodedInputBuffer.data();
+  const size_t inputSize = encodedInputBuffer.size();
+  uint8_t* output = outputBuffer->data();
+  const size_t outputSize = outputBuffer->size();
   size_t inputIndex = 0;
   size_t outputIndex = 0;
-  while (inputIndex < encodedInputBuffer.size()) {
-    const uint8_t code = encodedInputBuffer[inputIndex];
+  while (inputIndex < inputSize) {
+    const uint8_t code = input[inputIndex];
     inputIndex++;
-    for (uint8_t i = 1; i < code; ++i) {
-      if (outputIndex >= outputBuffer->size()) {
-        jll_error("CobsDecode ran out of space 1");
-        outputBuffer->resize(0);
-        return;
-      }
-      (*outputBuffer)[outputIndex] = encodedInputBuffer[inputIndex];
-      outputIndex++;
-      inputIndex++;
+    if (code == 0x00) {
+      jll_error("CobsDecode found unexpected zero byte");
+      outputBuffer->resize(0);
+      return;
+    }
+    const size_t blockLength = code - 1;
+    if (blockLength > inputSize - inputIndex) {
+      jll_error("CobsDecode found truncated block");
+      outputBuffer->resize(0);
+      return;
+    }
+    if (blockLength > outputSize - outputIndex) {
+      jll_error("CobsDecode ran out of space 1");
+      outputBuffer->resize(0);
+      return;
     }
+    // The output always trails the input by at least one byte, so this is safe when decoding in place.
+    CopyRun(&output[outputIndex], &input[inputIndex], blockLength);
+    outputIndex += blockLength;
+    inputIndex += blockLength;
     if (code < 0xFF) {
-      if (inputIndex == encodedInputBuffer.size()) {
+      if (inputIndex == inputSize) {
         outputBuffer->resize(outputIndex);
         jll_cobs_data_buffer(*outputBuffer, "COBS decode1");
         return;
       }
-      if (outputIndex >= outputBuffer->size()) {
+      if (outputIndex >= outputSize) {
         jll_error("CobsDecode ran out of space 2");
         outputBuffer->resize(0);
         return;
       }
-      (*outputBuffer)[outputIndex] = 0x00;
+      output[outputIndex] = 0x00;
       outputIndex++;
     }
   }
@@ -12,15 +12,26 @@ namespace jazzlights {
 // COBS (Consistent Overhead Byte Stuffing) is a byte encoding free of zero-bytes that minimizes the maximal encoding
 // overhead from the original input. See <https://www.stuartcheshire.org/papers/COBSforToN.pdf> for details.
 
+// Both encoding and decoding scan and copy runs of non-zero bytes a machine word at a time instead of byte by byte,
+// since this is on the critical path of every Max485 bus transaction.
+
+// Encodes the concatenation of the input buffers. The output buffer must not overlap any of the inputs. On return, the
+// output buffer is resized to the encoded length, or to zero on failure.
 void CobsEncode(const BufferViewU8 inputBuffers[], size_t numInputBuffers, BufferViewU8* encodedOutputBuffer);
 
 inline void CobsEncode(const BufferViewU8 inputBuffer, BufferViewU8* encodedOutputBuffer) {
   CobsEncode(&inputBuffer, 1, encodedOutputBuffer);
 }
 
+// On return, the output buffer is resized to the decoded length, or to zero on failure. The output buffer is allowed to
+// start at the same address as the input, which decodes in place.
 void CobsDecode(const BufferViewU8 encodedInputBuffer, BufferViewU8* outputBuffer);
 
+inline void CobsDecodeInPlace(BufferViewU8* buffer) { CobsDecode(*buffer, buffer); }
+
 constexpr size_t CobsMaxEncodedSize(size_t inputLength) {
+  // Even empty inputs need the initial code byte.
+  if (inputLength == 0) { return 1; }
   return static_cast<size_t>((((static_cast<uint64_t>(inputLength) * 255) + 253) / 254));
 }
 
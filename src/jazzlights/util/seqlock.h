@@ -0,0 +1,66 @@
+#ifndef JL_UTIL_SEQLOCK_H
+#define JL_UTIL_SEQLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace jazzlights {
+
+// Publishes a value from a single writer thread to any number of reader threads without locking. The writer never
+// waits. Readers retry if they raced with a write, which is cheap as long as writes are short and infrequent compared
+// to reads, like when publishing a small struct once per frame.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires trivially copyable types");
+
+ public:
+  SeqLock() : SeqLock(T{}) {}
+  explicit SeqLock(const T& value) { Store(value); }
+
+  // Only called by the writer.
+  void Store(const T& value) {
+    uint32_t words[kNumWords] = {};
+    memcpy(words, &value, sizeof(T));
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    // An odd sequence number tells readers that a write is in progress.
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kNumWords; i++) { words_[i].store(words[i], std::memory_order_relaxed); }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  // Returns false without modifying value if this raced with a write.
+  bool TryLoad(T* value) const {
+    const uint32_t sequenceBefore = sequence_.load(std::memory_order_acquire);
+    if ((sequenceBefore & 1) != 0) { return false; }
+    uint32_t words[kNumWords];
+    for (size_t i = 0; i < kNumWords; i++) { words[i] = words_[i].load(std::memory_order_relaxed); }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) != sequenceBefore) { return false; }
+    memcpy(value, words, sizeof(T));
+    return true;
+  }
+
+  T Load() const {
+    T value;
+    while (!TryLoad(&value)) {}
+    return value;
+  }
+
+  // Increases by one on every Store(), which lets readers cheaply check whether anything changed.
+  uint32_t Version() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+ private:
+  static constexpr size_t kNumWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> sequence_{0};
+  // The value is stored as relaxed atomic words so that concurrent reads and writes are well-defined.
+  std::atomic<uint32_t> words_[kNumWords];
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_UTIL_SEQLOCK_H
@@ -0,0 +1,60 @@
+#ifndef JL_UTIL_SLIDING_WINDOW_H
+#define JL_UTIL_SLIDING_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace jazzlights {
+
+// Tracks the extremum of the last windowSize values pushed, according to Compare: std::less gives the minimum and
+// std::greater gives the maximum. Each push takes amortized constant time instead of rescanning the whole window,
+// because values that are older and less extreme than a newer one can never be the extremum again and are dropped.
+// windowSize defaults to Capacity and is clamped to it.
+template <typename T, size_t Capacity, typename Compare>
+class SlidingWindowExtremum {
+ public:
+  explicit SlidingWindowExtremum(size_t windowSize = Capacity)
+      : windowSize_(windowSize == 0 ? 1 : (windowSize > Capacity ? Capacity : windowSize)) {}
+
+  size_t windowSize() const { return windowSize_; }
+
+  void Push(const T& value) {
+    // Drop the front if it is about to fall out of the window, this also guarantees there is room for value.
+    if (size_ > 0 && numPushes_ - pushIndices_[head_] >= windowSize_) {
+      head_ = Slot(1);
+      size_--;
+    }
+    while (size_ > 0 && !Compare()(values_[Slot(size_ - 1)], value)) { size_--; }
+    const size_t slot = Slot(size_);
+    values_[slot] = value;
+    pushIndices_[slot] = numPushes_;
+    size_++;
+    numPushes_++;
+  }
+
+  bool empty() const { return size_ == 0; }
+  // Must not be called when empty.
+  const T& value() const { return values_[head_]; }
+
+ private:
+  size_t Slot(size_t offset) const { return (head_ + offset) % Capacity; }
+
+  // Monotonic deque stored in a ring buffer, the extremum is at head_.
+  T values_[Capacity];
+  uint32_t pushIndices_[Capacity];
+  size_t windowSize_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  uint32_t numPushes_ = 0;
+};
+
+template <typename T, size_t Capacity>
+using SlidingWindowMin = SlidingWindowExtremum<T, Capacity, std::less<T>>;
+
+template <typename T, size_t Capacity>
+using SlidingWindowMax = SlidingWindowExtremum<T, Capacity, std::greater<T>>;
+
+}  // namespace jazzlights
+
+#endif  // JL_UTIL_SLIDING_WINDOW_H
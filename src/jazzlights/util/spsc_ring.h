@@ -0,0 +1,54 @@
+#ifndef JL_UTIL_SPSC_RING_H
+#define JL_UTIL_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace jazzlights {
+
+// Fixed-capacity lock-free queue for exactly one producer thread and one consumer thread. The queue itself never
+// allocates, which makes it safe to use from high-priority tasks that must not block on the heap or on a mutex held by
+// the consumer, as long as copying a T into a slot does not allocate either. TryPop() moves out of the slot, so members
+// like std::string are left empty and do not hold on to memory until the slot is reused.
+template <typename T, size_t Capacity>
+class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  // Only called by the producer. Returns false without modifying the queue if it is full.
+  bool TryPush(const T& value) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= Capacity) { return false; }
+    slots_[tail & kIndexMask] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Only called by the consumer. Returns false if the queue is empty.
+  bool TryPop(T* value) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) { return false; }
+    *value = std::move(slots_[head & kIndexMask]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with the other side.
+  size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return Capacity; }
+
+ private:
+  static constexpr uint32_t kIndexMask = Capacity - 1;
+
+  // Indices increase forever and wrap around naturally, only their low bits are used to index into slots_.
+  std::atomic<uint32_t> head_{0};  // Only modified by consumer.
+  std::atomic<uint32_t> tail_{0};  // Only modified by producer.
+  T slots_[Capacity];
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_UTIL_SPSC_RING_H
@@ -0,0 +1,35 @@
+#ifndef JL_TEST_LCG_RANDOM_H
+#define JL_TEST_LCG_RANDOM_H
+
+#include <cstdint>
+
+namespace jazzlights {
+
+// Linear congruential generator for tests that need inputs that are the same on every run and every platform.
+// PredictableRandom needs a Frame to be seeded and UnpredictableRandom is not repeatable, so neither fits here.
+class LcgRandom {
+ public:
+  explicit LcgRandom(uint32_t seed) : state_(seed) {}
+
+  // The low bits of the raw state are not very random, so the helpers below only use the high ones.
+  uint32_t Next() {
+    state_ = state_ * 1664525 + 1013904223;
+    return state_;
+  }
+
+  // Uniformly distributed in [0, 1).
+  double NextUnit() { return static_cast<double>(Next() >> 8) / (1 << 24); }
+
+  // Uniformly distributed in [min, max], both inclusive. The range must be well below 2^24.
+  int NextBetween(int min, int max) { return min + static_cast<int>((Next() >> 8) % (max - min + 1)); }
+
+  // Full-scale white noise for audio samples.
+  int16_t NextSample() { return static_cast<int16_t>(static_cast<int32_t>(Next() >> 16) - 32768); }
+
+ private:
+  uint32_t state_;
+};
+
+}  // namespace jazzlights
+
+#endif  // JL_TEST_LCG_RANDOM_H
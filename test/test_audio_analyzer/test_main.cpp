@@ -0,0 +1,227 @@
+#include <unity.h>
+
+#include <cmath>
+
+#include "jazzlights/audio_analyzer.h"
+#include "jazzlights/util/sliding_window.h"
+#include "lcg_random.h"
+
+namespace jazzlights {
+
+constexpr int kHopSize = AudioAnalyzer::kDefaultConfig.hop_size;
+constexpr Milliseconds kFrameDuration = kHopSize * 1000 / AudioAnalyzer::kSampleRate;
+
+void FillSine(int16_t* samples, float frequency, float amplitude, int* phase, int count = kHopSize) {
+  for (int i = 0; i < count; i++, (*phase)++) {
+    samples[i] = static_cast<int16_t>(amplitude * sinf(2 * M_PI * frequency * *phase / AudioAnalyzer::kSampleRate));
+  }
+}
+
+void test_audio_analyzer_silence() {
+  AudioAnalyzer analyzer;
+  int16_t samples[kHopSize] = {};
+  Milliseconds currentTime = 0;
+  for (int frame = 0; frame < 10; frame++, currentTime += kFrameDuration) {
+    analyzer.ProcessSamples(samples, /*numChannels=*/1, currentTime);
+  }
+  AudioAnalyzer::VisualizerData data;
+  analyzer.GetVisualizerData(&data);
+  TEST_ASSERT(data.squelch);
+  TEST_ASSERT_FALSE(data.beat);
+  // Silence does not count as having read audio.
+  TEST_ASSERT_EQUAL(-1, data.last_read_time);
+}
+
+void test_audio_analyzer_sine_band() {
+  AudioAnalyzer analyzer;
+  int16_t samples[kHopSize];
+  int phase = 0;
+  Milliseconds currentTime = 0;
+  for (int frame = 0; frame < 20; frame++, currentTime += kFrameDuration) {
+    FillSine(samples, 1000.0f, 8000.0f, &phase);
+    analyzer.ProcessSamples(samples, /*numChannels=*/1, currentTime);
+  }
+  AudioAnalyzer::VisualizerData data;
+  analyzer.GetVisualizerData(&data);
+  int loudestBand = 0;
+  for (int i = 1; i < AudioAnalyzer::kNumBands; i++) {
+    if (data.bands[i] > data.bands[loudestBand]) { loudestBand = i; }
+  }
+  // Bands are spaced logarithmically from 62.5Hz to 8kHz, so 1kHz lands in band 18.
+  TEST_ASSERT_EQUAL(18, loudestBand);
+  TEST_ASSERT_EQUAL(currentTime - kFrameDuration, data.last_read_time);
+}
+
+void test_audio_analyzer_stereo_uses_left_channel() {
+  AudioAnalyzer mono;
+  AudioAnalyzer stereo;
+  int16_t samples[kHopSize];
+  int16_t interleaved[kHopSize * 2];
+  int phase = 0;
+  for (int frame = 0; frame < 5; frame++) {
+    FillSine(samples, 500.0f, 8000.0f, &phase);
+    for (int i = 0; i < kHopSize; i++) {
+      interleaved[i * 2] = samples[i];
+      interleaved[i * 2 + 1] = -samples[i] / 2;
+    }
+    mono.ProcessSamples(samples, /*numChannels=*/1, frame * kFrameDuration);
+    stereo.ProcessSamples(interleaved, /*numChannels=*/2, frame * kFrameDuration);
+  }
+  AudioAnalyzer::VisualizerData monoData;
+  AudioAnalyzer::VisualizerData stereoData;
+  mono.GetVisualizerData(&monoData);
+  stereo.GetVisualizerData(&stereoData);
+  TEST_ASSERT_EQUAL_MEMORY(monoData.bands, stereoData.bands, sizeof(monoData.bands));
+}
+
+void test_audio_analyzer_beats() {
+  AudioAnalyzer analyzer;
+  int16_t samples[kHopSize];
+  int phase = 0;
+  LcgRandom noise(1);
+  // A steady bass tone with a loud burst of noise every 32 frames, which is about 2 beats per second. The tone has a
+  // whole number of periods per frame so that its spectrum does not change between frames.
+  constexpr int kNumFrames = 320;
+  constexpr int kBurstPeriod = 32;
+  // Beats are rate limited relative to time zero.
+  constexpr Milliseconds kStartTime = 1000;
+  // The flux of the very first frame inflates the average flux until it leaves the beat window, which can hide the
+  // next burst.
+  constexpr int kWarmupFrames = 64;
+  int numBeats = 0;
+  int numBeatsOnBursts = 0;
+  for (int frame = 0; frame < kNumFrames; frame++) {
+    FillSine(samples, 125.0f, 500.0f, &phase);
+    if (frame % kBurstPeriod == 0) {
+      for (int i = 0; i < kHopSize; i++) {
+        samples[i] += static_cast<int16_t>(noise.NextSample() * 3 / 4);
+      }
+    }
+    analyzer.ProcessSamples(samples, /*numChannels=*/1, kStartTime + frame * kFrameDuration);
+    AudioAnalyzer::VisualizerData data;
+    analyzer.GetVisualizerData(&data);
+    if (data.beat) {
+      numBeats++;
+      if (frame % kBurstPeriod == 0) { numBeatsOnBursts++; }
+    } else if (frame % kBurstPeriod == 0 && frame >= kWarmupFrames) {
+      TEST_FAIL_MESSAGE("Missed beat");
+    }
+  }
+  TEST_ASSERT(numBeatsOnBursts >= (kNumFrames - kWarmupFrames) / kBurstPeriod);
+  // Every beat should come from a burst.
+  TEST_ASSERT_EQUAL(numBeatsOnBursts, numBeats);
+}
+
+void test_audio_analyzer_high_resolution_sine_band() {
+  const AudioAnalyzer::Config config = AudioAnalyzer::kHighResolutionConfig;
+  AudioAnalyzer analyzer(config);
+  int16_t samples[AudioAnalyzer::kMaxFFTSize];
+  int phase = 0;
+  Milliseconds currentTime = 0;
+  for (int frame = 0; frame < 40; frame++, currentTime += analyzer.FrameDuration()) {
+    FillSine(samples, 1000.0f, 8000.0f, &phase, config.hop_size);
+    analyzer.ProcessSamples(samples, /*numChannels=*/1, currentTime);
+  }
+  AudioAnalyzer::VisualizerData data;
+  analyzer.GetVisualizerData(&data);
+  int loudestBand = 0;
+  for (int i = 1; i < AudioAnalyzer::kNumBands; i++) {
+    if (data.bands[i] > data.bands[loudestBand]) { loudestBand = i; }
+  }
+  // Bands are mel-spaced from 62.5Hz (96 mel) to 8kHz (2840 mel), so 1kHz (1000 mel) lands in band 10.
+  TEST_ASSERT_EQUAL(10, loudestBand);
+}
+
+// Feeds a steady bass tone followed by a short burst of noise, and returns how many samples after the start of the
+// burst the analyzer first reported a beat, or -1 if it never did.
+int SamplesUntilBeat(const AudioAnalyzer::Config& config) {
+  AudioAnalyzer analyzer(config);
+  int16_t samples[AudioAnalyzer::kMaxFFTSize];
+  int phase = 0;
+  LcgRandom noise(1);
+  constexpr int kBurstStart = 2 * AudioAnalyzer::kSampleRate;
+  constexpr int kBurstLength = 512;
+  constexpr Milliseconds kStartTime = 1000;
+  for (int first = 0; first < kBurstStart + AudioAnalyzer::kMaxFFTSize; first += config.hop_size) {
+    for (int i = 0; i < config.hop_size; i++, phase++) {
+      // Use double precision so that the tone repeats exactly. Larger FFTs pick up the rounding noise of sinf in their
+      // quieter bins, which looks like spectral flux and can trigger a beat just before the burst.
+      samples[i] = static_cast<int16_t>(500 * sin(2 * M_PI * 125 * phase / AudioAnalyzer::kSampleRate));
+      if (first + i < kBurstStart || first + i >= kBurstStart + kBurstLength) { continue; }
+      samples[i] += static_cast<int16_t>(noise.NextSample() * 3 / 4);
+    }
+    analyzer.ProcessSamples(samples, /*numChannels=*/1, kStartTime + first * 1000 / AudioAnalyzer::kSampleRate);
+    AudioAnalyzer::VisualizerData data;
+    analyzer.GetVisualizerData(&data);
+    if (data.beat && first + config.hop_size > kBurstStart) { return first + config.hop_size - kBurstStart; }
+  }
+  return -1;
+}
+
+void test_audio_analyzer_overlap_reduces_beat_latency() {
+  const int defaultLatency = SamplesUntilBeat(AudioAnalyzer::kDefaultConfig);
+  const int highResolutionLatency = SamplesUntilBeat(AudioAnalyzer::kHighResolutionConfig);
+  TEST_ASSERT_EQUAL(AudioAnalyzer::kDefaultConfig.hop_size, defaultLatency);
+  // Overlapping windows see the burst as soon as the first hop containing it arrives.
+  TEST_ASSERT_EQUAL(AudioAnalyzer::kHighResolutionConfig.hop_size, highResolutionLatency);
+}
+
+void test_sliding_window_extremum() {
+  constexpr size_t kWindowSize = 7;
+  SlidingWindowMin<float, kWindowSize> windowMin;
+  SlidingWindowMax<float, kWindowSize> windowMax;
+  TEST_ASSERT(windowMin.empty());
+  float values[200];
+  LcgRandom random(12345);
+  for (size_t i = 0; i < 200; i++) {
+    // Use a small range of values so that there are plenty of ties.
+    values[i] = static_cast<float>(random.NextBetween(0, 19));
+    // Long monotonic runs are the worst case for the deques.
+    if (i >= 100 && i < 130) { values[i] = static_cast<float>(i); }
+    if (i >= 150 && i < 180) { values[i] = static_cast<float>(200 - i); }
+    windowMin.Push(values[i]);
+    windowMax.Push(values[i]);
+    float expectedMin = values[i];
+    float expectedMax = values[i];
+    for (size_t j = (i + 1 > kWindowSize ? i + 1 - kWindowSize : 0); j < i; j++) {
+      if (values[j] < expectedMin) { expectedMin = values[j]; }
+      if (values[j] > expectedMax) { expectedMax = values[j]; }
+    }
+    TEST_ASSERT_FALSE(windowMin.empty());
+    TEST_ASSERT_EQUAL(expectedMin, windowMin.value());
+    TEST_ASSERT_EQUAL(expectedMax, windowMax.value());
+  }
+}
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_audio_analyzer_silence);
+  RUN_TEST(test_audio_analyzer_sine_band);
+  RUN_TEST(test_audio_analyzer_stereo_uses_left_channel);
+  RUN_TEST(test_audio_analyzer_beats);
+  RUN_TEST(test_audio_analyzer_high_resolution_sine_band);
+  RUN_TEST(test_audio_analyzer_overlap_reduces_beat_latency);
+  RUN_TEST(test_sliding_window_extremum);
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
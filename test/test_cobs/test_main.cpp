@@ -3,9 +3,17 @@
 #include <cstring>
 #include <iostream>
 
+#include "jazzlights/orrery_common.h"
 #include "jazzlights/pseudorandom.h"
 #include "jazzlights/util/buffer.h"
 #include "jazzlights/util/cobs.h"
+#include "jazzlights/util/log.h"
+#include "jazzlights/util/time.h"
+
+// Build with -DJL_RUN_BENCHMARKS=1 to also log COBS throughput. Timing depends on the machine so it is never asserted.
+#ifndef JL_RUN_BENCHMARKS
+#define JL_RUN_BENCHMARKS 0
+#endif  // JL_RUN_BENCHMARKS
 
 namespace jazzlights {
 
@@ -86,11 +94,214 @@ void test_multiple_split() {
   for (size_t i = 1; i < 10000; i += 10) { test_cobs_split(i); }
 }
 
+void test_in_place(size_t inputLength) {
+  OwnedBufferU8 inputBuffer(inputLength);
+  for (size_t i = 0; i < inputBuffer.size(); ++i) {
+    // Favor zeros to exercise short blocks.
+    inputBuffer[i] = UnpredictableRandom::GetNumberBetween(0, 3) == 0 ? 0x00 : UnpredictableRandom::GetByte();
+  }
+  OwnedBufferU8 encodeBuffer(CobsMaxEncodedSize(inputLength));
+  BufferViewU8 encodedBuffer(encodeBuffer);
+  CobsEncode(inputBuffer, &encodedBuffer);
+  TEST_ASSERT(encodedBuffer.size() > 0);
+  CobsDecodeInPlace(&encodedBuffer);
+  TEST_ASSERT_EQUAL(inputLength, encodedBuffer.size());
+  TEST_ASSERT(memcmp(&inputBuffer[0], &encodeBuffer[0], inputLength) == 0);
+}
+
+void test_in_place_multiple() {
+  for (size_t i = 1; i < 2000; i += 7) { test_in_place(i); }
+}
+
+void test_block_boundaries() {
+  // Runs of non-zero bytes around the maximum block length of 254, optionally followed by a zero.
+  for (size_t length = 250; length < 260; length++) {
+    for (uint8_t lastByte : {0x00, 0x42}) {
+      OwnedBufferU8 inputBuffer(length);
+      for (size_t i = 0; i < length; ++i) { inputBuffer[i] = 0x42; }
+      inputBuffer[length - 1] = lastByte;
+      test_cobs_buffer(inputBuffer);
+    }
+  }
+}
+
+void test_all_zeros() {
+  OwnedBufferU8 inputBuffer(300);
+  test_cobs_buffer(inputBuffer);
+}
+
+void test_invalid_input() {
+  uint8_t outputData[16] = {};
+  // Zero bytes are never valid in encoded data.
+  uint8_t zeroCode[] = {0x02, 0x11, 0x00, 0x01};
+  BufferViewU8 output(outputData, sizeof(outputData));
+  CobsDecode(BufferViewU8(zeroCode, sizeof(zeroCode)), &output);
+  TEST_ASSERT_EQUAL(0, output.size());
+  // Code claims more bytes than are available.
+  uint8_t truncated[] = {0x05, 0x11, 0x22};
+  output = BufferViewU8(outputData, sizeof(outputData));
+  CobsDecode(BufferViewU8(truncated, sizeof(truncated)), &output);
+  TEST_ASSERT_EQUAL(0, output.size());
+  // Output too small.
+  uint8_t valid[] = {0x04, 0x11, 0x22, 0x33, 0x01};
+  output = BufferViewU8(outputData, 2);
+  CobsDecode(BufferViewU8(valid, sizeof(valid)), &output);
+  TEST_ASSERT_EQUAL(0, output.size());
+}
+
+// Reference implementation that processes one byte at a time.
+size_t ReferenceCobsEncode(const uint8_t* input, size_t inputLength, uint8_t* output) {
+  uint8_t code = 0x01;
+  size_t outputCodeIndex = 0;
+  size_t outputIndex = 1;
+  for (size_t inputIndex = 0; inputIndex < inputLength; inputIndex++) {
+    if (code == 0xFF) {
+      output[outputCodeIndex] = code;
+      code = 0x01;
+      outputCodeIndex = outputIndex;
+      outputIndex++;
+    }
+    if (input[inputIndex] == 0x00) {
+      output[outputCodeIndex] = code;
+      code = 0x01;
+      outputCodeIndex = outputIndex;
+      outputIndex++;
+    } else {
+      output[outputIndex] = input[inputIndex];
+      outputIndex++;
+      code++;
+    }
+  }
+  output[outputCodeIndex] = code;
+  return outputIndex;
+}
+
+size_t ReferenceCobsDecode(const uint8_t* input, size_t inputLength, uint8_t* output) {
+  size_t inputIndex = 0;
+  size_t outputIndex = 0;
+  while (inputIndex < inputLength) {
+    const uint8_t code = input[inputIndex];
+    inputIndex++;
+    for (uint8_t i = 1; i < code; ++i) {
+      output[outputIndex] = input[inputIndex];
+      outputIndex++;
+      inputIndex++;
+    }
+    if (code < 0xFF && inputIndex < inputLength) {
+      output[outputIndex] = 0x00;
+      outputIndex++;
+    }
+  }
+  return outputIndex;
+}
+
+// Input where about one byte in zeroOneIn is zero.
+OwnedBufferU8 MakeInput(size_t inputLength, uint8_t zeroOneIn) {
+  OwnedBufferU8 inputBuffer(inputLength);
+  for (size_t i = 0; i < inputBuffer.size(); ++i) {
+    inputBuffer[i] = UnpredictableRandom::GetNumberBetween(1, zeroOneIn) == 1 ? 0x00 : 0x42;
+  }
+  return inputBuffer;
+}
+
+// Sizes to check against the reference and to benchmark: a short and a maximum-size OrreryMessage on the Max485 bus,
+// both sides of the 254-byte block limit, and a large buffer.
+constexpr size_t kReferenceSizes[] = {1, 32, kOrreryMessageMaxEncodedLength, 254, 255, 4096};
+constexpr uint8_t kZeroOneIn[] = {2, 8, 255};
+
+void test_matches_reference() {
+  for (size_t inputLength : kReferenceSizes) {
+    for (uint8_t zeroOneIn : kZeroOneIn) {
+      OwnedBufferU8 inputBuffer = MakeInput(inputLength, zeroOneIn);
+      OwnedBufferU8 encodeBuffer(CobsMaxEncodedSize(inputLength));
+      OwnedBufferU8 referenceEncodeBuffer(CobsMaxEncodedSize(inputLength));
+      OwnedBufferU8 decodeBuffer(inputLength);
+      BufferViewU8 encoded(encodeBuffer);
+      CobsEncode(inputBuffer, &encoded);
+      const size_t referenceEncodedLength =
+          ReferenceCobsEncode(&inputBuffer[0], inputLength, &referenceEncodeBuffer[0]);
+      TEST_ASSERT_EQUAL(referenceEncodedLength, encoded.size());
+      TEST_ASSERT(memcmp(&encodeBuffer[0], &referenceEncodeBuffer[0], referenceEncodedLength) == 0);
+      BufferViewU8 decoded(decodeBuffer);
+      CobsDecode(BufferViewU8(&referenceEncodeBuffer[0], referenceEncodedLength), &decoded);
+      TEST_ASSERT_EQUAL(inputLength, decoded.size());
+      TEST_ASSERT(memcmp(&inputBuffer[0], &decodeBuffer[0], inputLength) == 0);
+      memset(&decodeBuffer[0], 0xAA, inputLength);
+      TEST_ASSERT_EQUAL(inputLength, ReferenceCobsDecode(&encoded[0], encoded.size(), &decodeBuffer[0]));
+      TEST_ASSERT(memcmp(&inputBuffer[0], &decodeBuffer[0], inputLength) == 0);
+    }
+  }
+}
+
+#if JL_RUN_BENCHMARKS
+
+// Keeps the compiler from optimizing away benchmark loops.
+volatile uint8_t gBenchmarkSink = 0;
+
+constexpr Milliseconds kBenchmarkDuration = 200;
+
+// Returns the throughput of operation in KB/s.
+template <typename Operation>
+size_t MeasureKBps(size_t inputLength, Operation operation) {
+  size_t iterations = 0;
+  const Milliseconds startTime = timeMillis();
+  Milliseconds elapsed;
+  do {
+    gBenchmarkSink = gBenchmarkSink + operation();
+    iterations++;
+  } while ((elapsed = timeMillis() - startTime) < kBenchmarkDuration);
+  return iterations * inputLength / elapsed;
+}
+
+void test_benchmark() {
+  for (size_t inputLength : kReferenceSizes) {
+    for (uint8_t zeroOneIn : kZeroOneIn) {
+      OwnedBufferU8 inputBuffer = MakeInput(inputLength, zeroOneIn);
+      OwnedBufferU8 encodeBuffer(CobsMaxEncodedSize(inputLength));
+      OwnedBufferU8 referenceEncodeBuffer(CobsMaxEncodedSize(inputLength));
+      OwnedBufferU8 decodeBuffer(inputLength);
+      BufferViewU8 encoded(encodeBuffer);
+      CobsEncode(inputBuffer, &encoded);
+      const size_t encodeKBps = MeasureKBps(inputLength, [&]() {
+        BufferViewU8 output(encodeBuffer);
+        CobsEncode(inputBuffer, &output);
+        return output[0];
+      });
+      const size_t referenceEncodeKBps = MeasureKBps(inputLength, [&]() {
+        const size_t length = ReferenceCobsEncode(&inputBuffer[0], inputLength, &referenceEncodeBuffer[0]);
+        return referenceEncodeBuffer[length - 1];
+      });
+      const size_t decodeKBps = MeasureKBps(inputLength, [&]() {
+        BufferViewU8 output(decodeBuffer);
+        CobsDecode(encoded, &output);
+        return output[0];
+      });
+      const size_t referenceDecodeKBps = MeasureKBps(inputLength, [&]() {
+        const size_t length = ReferenceCobsDecode(&encoded[0], encoded.size(), &decodeBuffer[0]);
+        return decodeBuffer[length - 1];
+      });
+      jll_info("COBS %zu bytes with 1/%u zeros: encode %zu KB/s (reference %zu KB/s), decode %zu KB/s (reference %zu "
+               "KB/s)",
+               inputLength, zeroOneIn, encodeKBps, referenceEncodeKBps, decodeKBps, referenceDecodeKBps);
+    }
+  }
+}
+
+#endif  // JL_RUN_BENCHMARKS
+
 void run_unity_tests() {
   UNITY_BEGIN();
   RUN_TEST(test_short);
   RUN_TEST(test_big);
   RUN_TEST(test_multiple);
+  RUN_TEST(test_in_place_multiple);
+  RUN_TEST(test_block_boundaries);
+  RUN_TEST(test_all_zeros);
+  RUN_TEST(test_invalid_input);
+  RUN_TEST(test_matches_reference);
+#if JL_RUN_BENCHMARKS
+  RUN_TEST(test_benchmark);
+#endif  // JL_RUN_BENCHMARKS
   UNITY_END();
 }
 
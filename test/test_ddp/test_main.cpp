@@ -0,0 +1,300 @@
+#include <unity.h>
+
+#include <cstring>
+#include <vector>
+
+#include "jazzlights/layout/matrix.h"
+#include "jazzlights/network/ddp.h"
+#include "jazzlights/player.h"
+
+#ifndef ESP32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif  // ESP32
+
+namespace jazzlights {
+
+constexpr PatternBits kGlowRedPattern = 0x00000800;
+
+// Renderer whose colors can be written in place.
+class BufferRenderer : public Renderer {
+ public:
+  explicit BufferRenderer(size_t numLeds) : colors(numLeds) {}
+  void renderPixel(size_t index, CRGB color) override { colors[index] = color; }
+  CRGB* pixelBuffer() override { return colors.data(); }
+  std::vector<CRGB> colors;
+};
+
+// Renderer that only gets colors through renderPixel.
+class CaptureRenderer : public Renderer {
+ public:
+  explicit CaptureRenderer(size_t numLeds) : colors(numLeds) {}
+  void renderPixel(size_t index, CRGB color) override {
+    colors[index] = color;
+    numRenderedPixels++;
+  }
+  std::vector<CRGB> colors;
+  size_t numRenderedPixels = 0;
+};
+
+bool SameColor(CRGB a, CRGB b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+
+// Builds a packet with colors for pixels starting at firstPixel, all with value as their components.
+std::vector<uint8_t> MakePacket(uint8_t flags, uint8_t sequence, size_t firstPixel, size_t numPixels, uint8_t value) {
+  DdpHeader header;
+  header.flags = kDdpFlagsVersion1 | flags;
+  header.sequence = sequence;
+  header.offset = firstPixel * 3;
+  header.length = numPixels * 3;
+  std::vector<uint8_t> packet(kDdpHeaderLength + header.length, value);
+  WriteDdpHeader(header, packet.data());
+  return packet;
+}
+
+bool HandlePacket(DdpReceiver* receiver, const std::vector<uint8_t>& packet, Milliseconds currentTime) {
+  return receiver->HandlePacket(packet.data(), packet.size(), currentTime);
+}
+
+void test_ddp_header() {
+  DdpHeader header;
+  header.flags = kDdpFlagsVersion1 | kDdpFlagPush;
+  header.sequence = 9;
+  header.offset = 0x01020304;
+  header.length = 0x0506;
+  uint8_t data[kDdpHeaderLength];
+  WriteDdpHeader(header, data);
+  const uint8_t expected[kDdpHeaderLength] = {0x41, 9, kDdpDataTypeRgb24, 1, 1, 2, 3, 4, 5, 6};
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, data, kDdpHeaderLength);
+  DdpHeader parsed;
+  TEST_ASSERT(ReadDdpHeader(data, sizeof(data), &parsed));
+  TEST_ASSERT_EQUAL(header.flags, parsed.flags);
+  TEST_ASSERT_EQUAL(header.sequence, parsed.sequence);
+  TEST_ASSERT_EQUAL(header.offset, parsed.offset);
+  TEST_ASSERT_EQUAL(header.length, parsed.length);
+  TEST_ASSERT_EQUAL(kDdpHeaderLength, parsed.wireLength());
+  TEST_ASSERT_FALSE(ReadDdpHeader(data, kDdpHeaderLength - 1, &parsed));
+  // The timecode makes the header longer.
+  data[0] |= kDdpFlagTimecode;
+  TEST_ASSERT_FALSE(ReadDdpHeader(data, sizeof(data), &parsed));
+  // Other protocol versions are rejected.
+  data[0] = 0x81;
+  TEST_ASSERT_FALSE(ReadDdpHeader(data, sizeof(data), &parsed));
+}
+
+void test_ddp_receiver_frames() {
+  BufferRenderer bufferRenderer(4);
+  CaptureRenderer captureRenderer(6);
+  std::unique_ptr<DdpReceiver> receiver = DdpReceiver::Create(0);
+  receiver->AddStrand(4, &bufferRenderer);
+  receiver->AddStrand(6, &captureRenderer);
+  TEST_ASSERT_FALSE(receiver->IsStreaming(0));
+
+  // A packet that covers the end of the first strand and the start of the second.
+  TEST_ASSERT_FALSE(HandlePacket(receiver.get(), MakePacket(0, 1, 2, 4, 7), 100));
+  TEST_ASSERT(receiver->IsStreaming(100));
+  TEST_ASSERT(SameColor(CRGB(0, 0, 0), bufferRenderer.colors[1]));
+  TEST_ASSERT(SameColor(CRGB(7, 7, 7), bufferRenderer.colors[2]));
+  TEST_ASSERT(SameColor(CRGB(7, 7, 7), bufferRenderer.colors[3]));
+  // Renderers without a pixel buffer only get colors once the frame is complete.
+  TEST_ASSERT_EQUAL(0, captureRenderer.numRenderedPixels);
+  // The push flag completes the frame, pixels past the last strand are ignored.
+  TEST_ASSERT(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 2, 6, 8, 9), 110));
+  TEST_ASSERT_EQUAL(6, captureRenderer.numRenderedPixels);
+  TEST_ASSERT(SameColor(CRGB(7, 7, 7), captureRenderer.colors[1]));
+  TEST_ASSERT(SameColor(CRGB(9, 9, 9), captureRenderer.colors[2]));
+  TEST_ASSERT(SameColor(CRGB(9, 9, 9), captureRenderer.colors[5]));
+  TEST_ASSERT_EQUAL(1, receiver->numFrames());
+
+  // Packets that are not pixel data for us, or that are truncated, are dropped.
+  std::vector<uint8_t> packet = MakePacket(kDdpFlagPush, 0, 0, 1, 1);
+  packet[3] = 251;
+  TEST_ASSERT_FALSE(HandlePacket(receiver.get(), packet, 120));
+  packet = MakePacket(kDdpFlagPush | kDdpFlagQuery, 0, 0, 1, 1);
+  TEST_ASSERT_FALSE(HandlePacket(receiver.get(), packet, 120));
+  packet = MakePacket(kDdpFlagPush, 0, 0, 1, 1);
+  packet.pop_back();
+  TEST_ASSERT_FALSE(HandlePacket(receiver.get(), packet, 120));
+  TEST_ASSERT_EQUAL(3, receiver->numDroppedPackets());
+  TEST_ASSERT(SameColor(CRGB(0, 0, 0), bufferRenderer.colors[0]));
+
+  // Local patterns resume once packets stop arriving.
+  TEST_ASSERT(receiver->IsStreaming(110 + DdpReceiver::kStreamTimeout - 1));
+  TEST_ASSERT_FALSE(receiver->IsStreaming(110 + DdpReceiver::kStreamTimeout));
+}
+
+void test_ddp_receiver_sequence() {
+  BufferRenderer renderer(2);
+  std::unique_ptr<DdpReceiver> receiver = DdpReceiver::Create(0);
+  receiver->AddStrand(2, &renderer);
+  TEST_ASSERT(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 14, 0, 2, 1), 0));
+  // Wrapping from 15 to 1, with 15 lost.
+  TEST_ASSERT(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 1, 0, 2, 2), 10));
+  TEST_ASSERT_EQUAL(1, receiver->numLostPackets());
+  // Duplicate and late packets would overwrite newer colors.
+  TEST_ASSERT_FALSE(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 1, 0, 2, 3), 20));
+  TEST_ASSERT_FALSE(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 15, 0, 2, 3), 20));
+  TEST_ASSERT(SameColor(CRGB(2, 2, 2), renderer.colors[0]));
+  TEST_ASSERT_EQUAL(2, receiver->numDroppedPackets());
+  TEST_ASSERT(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 2, 0, 2, 4), 30));
+  // A sender that restarts its sequence numbers is followed after a few packets.
+  for (uint8_t sequence : {12, 13, 14}) {
+    TEST_ASSERT_FALSE(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, sequence, 0, 2, 5), 40));
+  }
+  TEST_ASSERT(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 15, 0, 2, 6), 40));
+  TEST_ASSERT(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 1, 0, 2, 7), 50));
+  TEST_ASSERT(SameColor(CRGB(7, 7, 7), renderer.colors[1]));
+  // Sequence numbers start over when a new stream starts.
+  TEST_ASSERT(HandlePacket(receiver.get(), MakePacket(kDdpFlagPush, 9, 0, 2, 8), 50 + DdpReceiver::kStreamTimeout));
+  TEST_ASSERT(SameColor(CRGB(8, 8, 8), renderer.colors[1]));
+}
+
+void test_ddp_frame_packets() {
+  constexpr size_t kNumLeds = 1000;
+  std::vector<CRGB> colors(kNumLeds);
+  for (size_t i = 0; i < kNumLeds; i++) { colors[i] = CRGB(i, i >> 8, 255 - i); }
+  std::vector<uint8_t> packets;
+  WriteDdpFrame(colors.data(), kNumLeds, &packets);
+  TEST_ASSERT_EQUAL(3, DdpPacketCount(kNumLeds));
+  TEST_ASSERT_EQUAL(kDdpHeaderLength + kDdpMaxDataLength, DdpPacketSize(kNumLeds, 0));
+  TEST_ASSERT_EQUAL(kDdpHeaderLength + kNumLeds * 3 - 2 * kDdpMaxDataLength, DdpPacketSize(kNumLeds, 2));
+  TEST_ASSERT_EQUAL(3 * kDdpHeaderLength + kNumLeds * 3, packets.size());
+
+  // Strands of different sizes and kinds of renderers receive the whole frame, which is only complete with the last
+  // packet.
+  BufferRenderer bufferRenderer(300);
+  CaptureRenderer captureRenderer(kNumLeds - 300);
+  std::unique_ptr<DdpReceiver> receiver = DdpReceiver::Create(0);
+  receiver->AddStrand(300, &bufferRenderer);
+  receiver->AddStrand(kNumLeds - 300, &captureRenderer);
+  uint8_t* packet = packets.data();
+  uint8_t sequence = 0;
+  for (size_t index = 0; index < DdpPacketCount(kNumLeds); index++) {
+    sequence = SetDdpSequence(packet, sequence);
+    TEST_ASSERT_EQUAL(index + 1, sequence);
+    const size_t size = DdpPacketSize(kNumLeds, index);
+    TEST_ASSERT_EQUAL(index == 2, receiver->HandlePacket(packet, size, 0));
+    packet += size;
+  }
+  TEST_ASSERT_EQUAL(0, receiver->numLostPackets());
+  TEST_ASSERT(memcmp(colors.data(), bufferRenderer.colors.data(), 300 * sizeof(CRGB)) == 0);
+  TEST_ASSERT(memcmp(colors.data() + 300, captureRenderer.colors.data(), (kNumLeds - 300) * sizeof(CRGB)) == 0);
+  TEST_ASSERT_EQUAL(1, SetDdpSequence(packets.data(), 15));
+
+  // Empty frames still push.
+  WriteDdpFrame(nullptr, 0, &packets);
+  TEST_ASSERT_EQUAL(1, DdpPacketCount(0));
+  TEST_ASSERT_EQUAL(kDdpHeaderLength, packets.size());
+  TEST_ASSERT(receiver->HandlePacket(packets.data(), packets.size(), 0));
+}
+
+#ifndef ESP32
+
+// Sends the packets from another process, as a host streaming to a device would.
+void SendFromChildProcess(uint16_t port, const std::vector<std::vector<uint8_t>>& packets) {
+  const pid_t pid = fork();
+  TEST_ASSERT(pid >= 0);
+  if (pid == 0) {
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in sin = {};
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int failures = 0;
+    for (const std::vector<uint8_t>& packet : packets) {
+      if (sendto(fd, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&sin), sizeof(sin)) < 0) {
+        failures++;
+      }
+    }
+    close(fd);
+    _exit(failures);
+  }
+  int status = 0;
+  TEST_ASSERT_EQUAL(pid, waitpid(pid, &status, 0));
+  TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+constexpr Milliseconds kStartTime = 1;
+
+void StartPlayer(Player* player, const Layout& layout, Renderer* renderer, DdpReceiver* receiver) {
+  player->addStrand(layout, *renderer);
+  player->SetStreamReceiver(receiver);
+  player->begin();
+  player->loopOne(kStartTime);
+  player->setPattern(kGlowRedPattern, kStartTime);
+}
+
+void test_ddp_player_streaming() {
+  const Matrix layout(5, 4);
+  BufferRenderer renderer(layout.pixelCount());
+  Player player;
+  std::unique_ptr<DdpReceiver> receiver = DdpReceiver::Create(0);
+  StartPlayer(&player, layout, &renderer, receiver.get());
+  // Same pattern without streaming.
+  BufferRenderer referenceRenderer(layout.pixelCount());
+  Player referencePlayer;
+  StartPlayer(&referencePlayer, layout, &referenceRenderer, nullptr);
+  // Not streaming yet, this renders the pattern and opens the socket.
+  TEST_ASSERT(player.render(kStartTime));
+  TEST_ASSERT_NOT_EQUAL(0, receiver->port());
+
+  // Two frames sent at once, split over several packets each. Only the second one should be shown.
+  SendFromChildProcess(receiver->port(), {
+                                             MakePacket(0, 1, 0, 12, 40),
+                                             MakePacket(kDdpFlagPush, 2, 12, 8, 41),
+                                             MakePacket(0, 3, 0, 12, 50),
+                                             MakePacket(kDdpFlagPush, 4, 12, 8, 51),
+                                         });
+  TEST_ASSERT(player.render(kStartTime + 20));
+  TEST_ASSERT_EQUAL(2, receiver->numFrames());
+  TEST_ASSERT(SameColor(CRGB(50, 50, 50), renderer.colors[0]));
+  TEST_ASSERT(SameColor(CRGB(50, 50, 50), renderer.colors[11]));
+  TEST_ASSERT(SameColor(CRGB(51, 51, 51), renderer.colors[12]));
+  TEST_ASSERT(SameColor(CRGB(51, 51, 51), renderer.colors[19]));
+  // Nothing new to show while the stream is active, even after the time between pattern frames.
+  TEST_ASSERT_FALSE(player.render(kStartTime + 40));
+  TEST_ASSERT(SameColor(CRGB(50, 50, 50), renderer.colors[0]));
+
+  // Once the stream times out, the pattern comes back.
+  const Milliseconds patternTime = kStartTime + 20 + DdpReceiver::kStreamTimeout;
+  TEST_ASSERT(player.render(patternTime));
+  TEST_ASSERT(referencePlayer.render(patternTime));
+  TEST_ASSERT(memcmp(referenceRenderer.colors.data(), renderer.colors.data(), layout.pixelCount() * sizeof(CRGB)) == 0);
+}
+
+#endif  // ESP32
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ddp_header);
+  RUN_TEST(test_ddp_receiver_frames);
+  RUN_TEST(test_ddp_receiver_sequence);
+  RUN_TEST(test_ddp_frame_packets);
+#ifndef ESP32
+  RUN_TEST(test_ddp_player_streaming);
+#endif  // ESP32
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
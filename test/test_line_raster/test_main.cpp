@@ -0,0 +1,239 @@
+#include <unity.h>
+
+#include <cstdlib>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "jazzlights/effect/line_raster.h"
+#include "jazzlights/fastled_wrapper.h"
+#include "jazzlights/util/log.h"
+#include "jazzlights/util/time.h"
+#include "lcg_random.h"
+
+// Checks the line rasterizers against the per-step division line drawing that ColoredBursts used to do. Build with
+// -DJL_RUN_BENCHMARKS=1 to also log how fast they are. Timing depends on the machine so it is never asserted.
+#ifndef JL_RUN_BENCHMARKS
+#define JL_RUN_BENCHMARKS 0
+#endif  // JL_RUN_BENCHMARKS
+
+namespace jazzlights {
+
+// Reference implementation that divides at every step and bounds-checks every cell, like the old ColoredBursts code.
+void ReferenceDrawLine(CRGB* cells, int width, int height, int x1, int y1, int x2, int y2, CRGB color) {
+  const int steps = std::max(std::abs(x2 - x1), std::abs(y2 - y1)) + 1;
+  for (int i = 1; i <= steps; i++) {
+    const int dx = x1 + (x2 - x1) * i / steps;
+    const int dy = y1 + (y2 - y1) * i / steps;
+    if (dx < 0 || dx >= width || dy < 0 || dy >= height) { continue; }
+    cells[dy * width + dx] += color;
+    cells[dy * width + dx] %= (i * 255 / steps);
+  }
+}
+
+struct Line {
+  int x0, y0, x1, y1;
+};
+
+std::vector<Line> RandomLines(int minCoord, int maxCoord) {
+  std::vector<Line> lines(256);
+  LcgRandom random(1);
+  for (Line& line : lines) {
+    line.x0 = random.NextBetween(minCoord, maxCoord);
+    line.y0 = random.NextBetween(minCoord, maxCoord);
+    line.x1 = random.NextBetween(minCoord, maxCoord);
+    line.y1 = random.NextBetween(minCoord, maxCoord);
+  }
+  return lines;
+}
+
+// Cells of a line keyed by their coordinate along the major axis, with their coordinate along the minor axis.
+using LineCells = std::multimap<int, int>;
+
+// Cells that ReferenceDrawLine() visits, without clipping.
+LineCells ReferenceLineCells(const Line& l) {
+  LineCells cells;
+  const bool xMajor = std::abs(l.x1 - l.x0) >= std::abs(l.y1 - l.y0);
+  const int steps = std::max(std::abs(l.x1 - l.x0), std::abs(l.y1 - l.y0)) + 1;
+  for (int i = 1; i <= steps; i++) {
+    const int x = l.x0 + (l.x1 - l.x0) * i / steps;
+    const int y = l.y0 + (l.y1 - l.y0) * i / steps;
+    cells.emplace(xMajor ? x : y, xMajor ? y : x);
+  }
+  return cells;
+}
+
+// Large enough that no test line gets clipped once shifted by kUnclippedOffset.
+constexpr int kUnclippedSize = 10000;
+constexpr int kUnclippedOffset = kUnclippedSize / 2;
+
+// Checks that the lines drawn by RasterizeLine() and RasterizeLineAntialiased() follow the old per-step division line
+// drawing, and that clipping them to a width x height grid only drops the cells outside it.
+void CheckLines(const std::vector<Line>& lines, int width, int height) {
+  for (const Line& l : lines) {
+    const bool xMajor = std::abs(l.x1 - l.x0) >= std::abs(l.y1 - l.y0);
+    const auto key = [xMajor](int x, int y) { return xMajor ? std::make_pair(x, y) : std::make_pair(y, x); };
+    const auto onGrid = [&](int x, int y) { return x >= 0 && x < width && y >= 0 && y < height; };
+    const int o = kUnclippedOffset;
+
+    // Both move exactly one cell along the major axis per step, and differ by at most one cell along the minor axis
+    // since the reference truncates where Bresenham rounds.
+    const LineCells reference = ReferenceLineCells(l);
+    LineCells unclipped;
+    RasterizeLine(l.x0 + o, l.y0 + o, l.x1 + o, l.y1 + o, kUnclippedSize, kUnclippedSize,
+                  [&](int x, int y, int /*step*/) { unclipped.insert(key(x - o, y - o)); });
+    TEST_ASSERT_EQUAL(reference.size(), unclipped.size());
+    for (const auto& [major, minor] : unclipped) {
+      TEST_ASSERT_EQUAL(1, reference.count(major));
+      TEST_ASSERT(std::abs(reference.find(major)->second - minor) <= 1);
+    }
+    LineCells clipped;
+    RasterizeLine(l.x0, l.y0, l.x1, l.y1, width, height, [&](int x, int y, int /*step*/) {
+      TEST_ASSERT(onGrid(x, y));
+      clipped.insert(key(x, y));
+    });
+    LineCells expectedClipped;
+    for (const auto& [major, minor] : unclipped) {
+      if (xMajor ? onGrid(major, minor) : onGrid(minor, major)) { expectedClipped.emplace(major, minor); }
+    }
+    TEST_ASSERT(expectedClipped == clipped);
+
+    // Anti-aliased lines cover the two cells around the Bresenham cell at each step, with coverages adding up to 255.
+    std::map<std::pair<int, int>, int> coverages;
+    std::map<int, int> coveragePerMajor;
+    RasterizeLineAntialiased(l.x0 + o, l.y0 + o, l.x1 + o, l.y1 + o, kUnclippedSize, kUnclippedSize,
+                             [&](int x, int y, int /*step*/, uint8_t coverage) {
+                               coverages[key(x - o, y - o)] += coverage;
+                               coveragePerMajor[key(x - o, y - o).first] += coverage;
+                             });
+    TEST_ASSERT_EQUAL(unclipped.size(), coveragePerMajor.size());
+    for (const auto& [major, coverage] : coveragePerMajor) { TEST_ASSERT_EQUAL(255, coverage); }
+    for (const auto& [cell, coverage] : coverages) {
+      const int bresenhamMinor = unclipped.find(cell.first)->second;
+      TEST_ASSERT(cell.second == bresenhamMinor || cell.second + 1 == bresenhamMinor ||
+                  cell.second - 1 == bresenhamMinor);
+    }
+    RasterizeLineAntialiased(l.x0, l.y0, l.x1, l.y1, width, height, [&](int x, int y, int /*step*/, uint8_t coverage) {
+      TEST_ASSERT(onGrid(x, y));
+      const auto cell = key(x, y);
+      TEST_ASSERT_EQUAL(coverages[cell], coverage);
+      coverages.erase(cell);
+    });
+    for (const auto& [cell, coverage] : coverages) {
+      TEST_ASSERT_FALSE(xMajor ? onGrid(cell.first, cell.second) : onGrid(cell.second, cell.first));
+    }
+  }
+}
+
+void test_lines_inside() { CheckLines(RandomLines(0, 99), 100, 100); }
+void test_lines_crossing_edges() { CheckLines(RandomLines(-30, 130), 100, 80); }
+void test_lines_mostly_outside() { CheckLines(RandomLines(-2000, 2100), 100, 100); }
+
+#if JL_RUN_BENCHMARKS
+
+// Keeps the compiler from optimizing away benchmark loops.
+volatile uint8_t gBenchmarkSink = 0;
+
+constexpr Milliseconds kBenchmarkDuration = 200;
+
+// Returns how many thousands of lines per second drawLine managed.
+template <typename DrawLineFunction>
+size_t MeasureKLinesPerSecond(const std::vector<Line>& lines, CRGB* cells, int width, DrawLineFunction drawLine) {
+  size_t iterations = 0;
+  Milliseconds startTime = timeMillis();
+  Milliseconds elapsed;
+  do {
+    for (const Line& line : lines) { drawLine(line); }
+    gBenchmarkSink = gBenchmarkSink + cells[width + 1].r;
+    iterations++;
+  } while ((elapsed = timeMillis() - startTime) < kBenchmarkDuration);
+  return iterations * lines.size() / elapsed;
+}
+
+void benchmark_lines(const char* name, int width, int height, int minCoord, int maxCoord) {
+  const std::vector<Line> lines = RandomLines(minCoord, maxCoord);
+  std::vector<CRGB> cells(width * height);
+  const CRGB color(10, 20, 30);
+  const size_t klps = MeasureKLinesPerSecond(lines, cells.data(), width, [&](const Line& l) {
+    DrawLine(cells.data(), width, height, l.x0, l.y0, l.x1, l.y1, color, /*gradient=*/true);
+  });
+  const size_t antialiasedKlps = MeasureKLinesPerSecond(lines, cells.data(), width, [&](const Line& l) {
+    DrawLineAntialiased(cells.data(), width, height, l.x0, l.y0, l.x1, l.y1, color, /*gradient=*/true);
+  });
+  const size_t referenceKlps = MeasureKLinesPerSecond(lines, cells.data(), width, [&](const Line& l) {
+    ReferenceDrawLine(cells.data(), width, height, l.x0, l.y0, l.x1, l.y1, color);
+  });
+  jll_info("Lines %s on %dx%d: %zu klines/s, anti-aliased %zu klines/s (reference %zu klines/s)", name, width, height,
+           klps, antialiasedKlps, referenceKlps);
+}
+
+// ColoredBursts used to draw every combination of the positions each endpoint coordinate moved through since the last
+// frame, now it sweeps one line per cell of movement.
+void test_benchmark_burst_sweep() {
+  constexpr int kSize = 100;
+  constexpr int kMovement = 4;
+  std::vector<CRGB> cells(kSize * kSize);
+  const CRGB color(10, 20, 30);
+  const std::vector<Line> lines = RandomLines(kMovement, kSize - 1);
+  const size_t sweepKlps = MeasureKLinesPerSecond(lines, cells.data(), kSize, [&](const Line& l) {
+    for (int step = 0; step <= kMovement; step++) {
+      DrawLine(cells.data(), kSize, kSize, l.x0 - kMovement + step, l.y0 - kMovement + step, l.x1 - kMovement + step,
+               l.y1 - kMovement + step, color, /*gradient=*/true);
+    }
+  });
+  const size_t referenceKlps = MeasureKLinesPerSecond(lines, cells.data(), kSize, [&](const Line& l) {
+    for (int x0 = l.x0 - kMovement; x0 <= l.x0; x0++) {
+      for (int x1 = l.x1 - kMovement; x1 <= l.x1; x1++) {
+        for (int y0 = l.y0 - kMovement; y0 <= l.y0; y0++) {
+          for (int y1 = l.y1 - kMovement; y1 <= l.y1; y1++) {
+            ReferenceDrawLine(cells.data(), kSize, kSize, x0, y0, x1, y1, color);
+          }
+        }
+      }
+    }
+  });
+  jll_info("Burst sweeps moving %d cells on %dx%d: %zu ksweeps/s (reference %zu ksweeps/s)", kMovement, kSize, kSize,
+           sweepKlps, referenceKlps);
+}
+
+void test_benchmark_grid_100() { benchmark_lines("inside", 100, 100, 0, 99); }
+void test_benchmark_grid_400() { benchmark_lines("inside", 400, 400, 0, 399); }
+// Most of each line is outside the grid, the reference still walks all of it.
+void test_benchmark_clipped() { benchmark_lines("mostly outside", 100, 100, -2000, 2100); }
+
+#endif  // JL_RUN_BENCHMARKS
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lines_inside);
+  RUN_TEST(test_lines_crossing_edges);
+  RUN_TEST(test_lines_mostly_outside);
+#if JL_RUN_BENCHMARKS
+  RUN_TEST(test_benchmark_grid_100);
+  RUN_TEST(test_benchmark_grid_400);
+  RUN_TEST(test_benchmark_clipped);
+  RUN_TEST(test_benchmark_burst_sweep);
+#endif  // JL_RUN_BENCHMARKS
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
@@ -0,0 +1,142 @@
+#include <unity.h>
+
+#include <string>
+#include <thread>
+
+#include "jazzlights/util/seqlock.h"
+#include "jazzlights/util/spsc_ring.h"
+
+namespace jazzlights {
+
+void test_spsc_ring_basic() {
+  SpscRing<int, 4> ring;
+  int value = 0;
+  TEST_ASSERT(ring.empty());
+  TEST_ASSERT_FALSE(ring.TryPop(&value));
+  for (int i = 0; i < 4; i++) { TEST_ASSERT(ring.TryPush(i)); }
+  TEST_ASSERT_FALSE(ring.TryPush(4));
+  TEST_ASSERT_EQUAL(4, ring.size());
+  TEST_ASSERT(ring.TryPop(&value));
+  TEST_ASSERT_EQUAL(0, value);
+  TEST_ASSERT(ring.TryPush(4));
+  for (int i = 1; i <= 4; i++) {
+    TEST_ASSERT(ring.TryPop(&value));
+    TEST_ASSERT_EQUAL(i, value);
+  }
+  TEST_ASSERT_FALSE(ring.TryPop(&value));
+}
+
+void test_spsc_ring_moves_out() {
+  SpscRing<std::string, 2> ring;
+  const std::string longString(100, 'x');
+  TEST_ASSERT(ring.TryPush(longString));
+  TEST_ASSERT(ring.TryPush(""));
+  std::string value;
+  TEST_ASSERT(ring.TryPop(&value));
+  TEST_ASSERT(value == longString);
+  TEST_ASSERT(ring.TryPop(&value));
+  TEST_ASSERT(value.empty());
+  TEST_ASSERT(ring.TryPush("a"));
+  TEST_ASSERT(ring.TryPop(&value));
+  TEST_ASSERT(value == "a");
+}
+
+void test_spsc_ring_threads() {
+  SpscRing<uint32_t, 8> ring;
+  constexpr uint32_t kNumValues = 100000;
+  std::thread producer([&ring]() {
+    for (uint32_t i = 0; i < kNumValues;) {
+      if (ring.TryPush(i)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  bool inOrder = true;
+  while (expected < kNumValues) {
+    uint32_t value;
+    if (!ring.TryPop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (value != expected) { inOrder = false; }
+    expected++;
+  }
+  producer.join();
+  TEST_ASSERT(inOrder);
+  TEST_ASSERT(ring.empty());
+}
+
+struct SeqLockTestData {
+  uint32_t a;
+  uint32_t b;
+  uint8_t c;
+};
+
+void test_seqlock_basic() {
+  SeqLock<SeqLockTestData> seqLock;
+  SeqLockTestData data = seqLock.Load();
+  TEST_ASSERT_EQUAL(0, data.a);
+  const uint32_t version = seqLock.Version();
+  seqLock.Store({.a = 1, .b = 2, .c = 3});
+  TEST_ASSERT_EQUAL(version + 1, seqLock.Version());
+  TEST_ASSERT(seqLock.TryLoad(&data));
+  TEST_ASSERT_EQUAL(1, data.a);
+  TEST_ASSERT_EQUAL(2, data.b);
+  TEST_ASSERT_EQUAL(3, data.c);
+}
+
+void test_seqlock_threads() {
+  SeqLock<SeqLockTestData> seqLock;
+  constexpr uint32_t kNumWrites = 100000;
+  std::thread writer([&seqLock]() {
+    for (uint32_t i = 1; i <= kNumWrites; i++) {
+      seqLock.Store({.a = i, .b = ~i, .c = static_cast<uint8_t>(i)});
+    }
+  });
+  // Readers must never observe a torn value.
+  bool consistent = true;
+  uint32_t last = 0;
+  while (last < kNumWrites) {
+    const SeqLockTestData data = seqLock.Load();
+    if (data.a != 0 && (data.b != ~data.a || data.c != static_cast<uint8_t>(data.a))) { consistent = false; }
+    if (data.a < last) { consistent = false; }
+    if (data.a == last) { std::this_thread::yield(); }
+    last = data.a;
+  }
+  writer.join();
+  TEST_ASSERT(consistent);
+}
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_spsc_ring_basic);
+  RUN_TEST(test_spsc_ring_moves_out);
+  RUN_TEST(test_spsc_ring_threads);
+  RUN_TEST(test_seqlock_basic);
+  RUN_TEST(test_seqlock_threads);
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
@@ -1,5 +1,6 @@
 #include <unity.h>
 
+#include "jazzlights/network/max485_poll_scheduler.h"
 #include "jazzlights/network/network.h"
 
 namespace jazzlights {
@@ -59,11 +60,215 @@ void test_network_int32() {
   }
 }
 
+NetworkMessage make_scheduler_message(uint8_t originatorByte, NumHops numHops) {
+  NetworkMessage message;
+  uint8_t originatorData[6] = {1, 2, 3, 4, 5, originatorByte};
+  message.originator = NetworkDeviceId(originatorData);
+  message.sender = message.originator;
+  message.currentPattern = 0x1234;
+  message.nextPattern = 0x5678;
+  message.precedence = 100;
+  message.numHops = numHops;
+  return message;
+}
+
+constexpr SendScheduler::Config kTestSchedulerConfig = {
+    .minInterval = 100,
+    .maxInterval = 1600,
+    .redundancyConstant = 2,
+    .jitterPerNeighbor = 0,
+};
+
+// Returns number of sends between startTime (inclusive) and endTime (exclusive) when polled every millisecond.
+size_t run_scheduler(SendScheduler& scheduler, Milliseconds startTime, Milliseconds endTime) {
+  size_t numSends = 0;
+  for (Milliseconds t = startTime; t < endTime; t++) {
+    if (scheduler.shouldSend(t)) {
+      scheduler.onSent(t);
+      numSends++;
+    }
+  }
+  return numSends;
+}
+
+void test_send_scheduler_backoff() {
+  SendScheduler scheduler(kTestSchedulerConfig);
+  const NetworkDeviceId localDeviceId;
+  TEST_ASSERT_FALSE(scheduler.shouldSend(1000));
+  scheduler.setMessageToSend(make_scheduler_message(6, 0), 1000);
+  // First send is immediate.
+  TEST_ASSERT(scheduler.shouldSend(1000));
+  scheduler.onSent(1000);
+  // The first interval of 100 contains the immediate send, followed by 200, 400, 800 then 1600 forever with one send
+  // per interval.
+  TEST_ASSERT_EQUAL(3, run_scheduler(scheduler, 1001, 2501));
+  TEST_ASSERT_EQUAL(1600, scheduler.currentInterval());
+  const size_t numSends = run_scheduler(scheduler, 2501, 2500 + 16000);
+  TEST_ASSERT(numSends >= 9 && numSends <= 11);
+  TEST_ASSERT_EQUAL(0, scheduler.numSuppressed());
+  // A pattern change sends immediately and resets the interval.
+  NetworkMessage changed = make_scheduler_message(6, 0);
+  changed.currentPattern = 0x4321;
+  scheduler.setMessageToSend(changed, 20000);
+  TEST_ASSERT(scheduler.shouldSend(20000));
+  scheduler.onSent(20000);
+  TEST_ASSERT_EQUAL(100, scheduler.currentInterval());
+  // Precedence decreasing does not.
+  changed.precedence = 90;
+  scheduler.setMessageToSend(changed, 20001);
+  TEST_ASSERT_FALSE(scheduler.shouldSend(20001));
+}
+
+void test_send_scheduler_suppression() {
+  SendScheduler scheduler(kTestSchedulerConfig);
+  const NetworkDeviceId localDeviceId;
+  scheduler.setMessageToSend(make_scheduler_message(6, 1), 1000);
+  TEST_ASSERT(scheduler.shouldSend(1000));
+  scheduler.onSent(1000);
+  run_scheduler(scheduler, 1001, 1101);
+  // Two neighbors as close to the originator as us suppress our next send.
+  NetworkMessage neighbor1 = make_scheduler_message(6, 1);
+  neighbor1.sender = neighbor1.sender.PlusOne();
+  NetworkMessage neighbor2 = make_scheduler_message(6, 0);
+  scheduler.onMessageReceived(neighbor1, localDeviceId, 1100);
+  scheduler.onMessageReceived(neighbor2, localDeviceId, 1100);
+  TEST_ASSERT_EQUAL(2, scheduler.numRecentNeighbors(1100));
+  TEST_ASSERT_EQUAL(0, run_scheduler(scheduler, 1101, 1301));
+  TEST_ASSERT_EQUAL(1, scheduler.numSuppressed());
+  // Neighbors further from the originator do not.
+  NetworkMessage downstream = make_scheduler_message(6, 2);
+  downstream.sender = neighbor1.sender.PlusOne();
+  scheduler.onMessageReceived(downstream, localDeviceId, 1300);
+  scheduler.onMessageReceived(downstream, localDeviceId, 1300);
+  TEST_ASSERT_EQUAL(1, run_scheduler(scheduler, 1301, 1700));
+  // A neighbor disagreeing with us resets the interval without sending immediately.
+  TEST_ASSERT_EQUAL(400, scheduler.currentInterval());
+  scheduler.onMessageReceived(make_scheduler_message(7, 0), localDeviceId, 1700);
+  TEST_ASSERT_EQUAL(100, scheduler.currentInterval());
+  TEST_ASSERT_FALSE(scheduler.shouldSend(1700));
+  TEST_ASSERT_EQUAL(1, run_scheduler(scheduler, 1700, 1800));
+}
+
+void test_send_scheduler_next_check_time() {
+  SendScheduler scheduler(kTestSchedulerConfig);
+  TEST_ASSERT_EQUAL(-1, scheduler.nextCheckTime());
+  scheduler.setMessageToSend(make_scheduler_message(6, 0), 1000);
+  TEST_ASSERT_EQUAL(1000, scheduler.nextCheckTime());
+  // Only waking up at nextCheckTime() sends as often as polling every millisecond.
+  size_t numSends = 0;
+  for (Milliseconds t = scheduler.nextCheckTime(); t < 5000; t = scheduler.nextCheckTime()) {
+    TEST_ASSERT(t >= 1000);
+    if (scheduler.shouldSend(t)) {
+      scheduler.onSent(t);
+      numSends++;
+    }
+    TEST_ASSERT(scheduler.nextCheckTime() > t);
+  }
+  TEST_ASSERT(numSends >= 5 && numSends <= 6);
+  scheduler.disableSending();
+  TEST_ASSERT_EQUAL(-1, scheduler.nextCheckTime());
+}
+
+constexpr Max485PollScheduler::Config kTestPollSchedulerConfig = {
+    .minResponseTimeout = 10,
+    .maxResponseTimeout = 50,
+    .timeoutsBeforeBackoff = 3,
+    .maxBackoffCycles = 4,
+};
+
+void test_max485_poll_scheduler_round_robin() {
+  Max485PollScheduler scheduler(kTestPollSchedulerConfig);
+  TEST_ASSERT_EQUAL(Max485PollScheduler::kNoFollower, scheduler.NextFollower());
+  TEST_ASSERT(scheduler.AddFollower(6));
+  TEST_ASSERT(scheduler.AddFollower(4));
+  TEST_ASSERT(scheduler.AddFollower(4));
+  TEST_ASSERT_EQUAL(2, scheduler.NumFollowers());
+  TEST_ASSERT_EQUAL(4, scheduler.NextFollower());
+  // Adding a follower mid-cycle slots it in by bus ID without restarting the cycle.
+  TEST_ASSERT(scheduler.AddFollower(5));
+  TEST_ASSERT_EQUAL(5, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(6, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(4, scheduler.NextFollower());
+  TEST_ASSERT(scheduler.AddFollower(3));
+  TEST_ASSERT_EQUAL(5, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(6, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(3, scheduler.NextFollower());
+  TEST_ASSERT_FALSE(scheduler.AddFollower(Max485PollScheduler::kNoFollower));
+}
+
+void test_max485_poll_scheduler_timeouts() {
+  Max485PollScheduler scheduler(kTestPollSchedulerConfig);
+  scheduler.AddFollower(4);
+  // We wait as long as possible until we have measurements.
+  TEST_ASSERT_EQUAL(50, scheduler.ResponseTimeout(4));
+  TEST_ASSERT_EQUAL(-1, scheduler.SmoothedRtt(4));
+  scheduler.OnResponse(4, 14);
+  TEST_ASSERT_EQUAL(14, scheduler.SmoothedRtt(4));
+  TEST_ASSERT_EQUAL(42, scheduler.ResponseTimeout(4));
+  // Consistent RTTs shrink the timeout towards the RTT.
+  for (int i = 0; i < 20; i++) { scheduler.OnResponse(4, 14); }
+  TEST_ASSERT(scheduler.ResponseTimeout(4) > 14);
+  TEST_ASSERT(scheduler.ResponseTimeout(4) <= 18);
+  // A timeout widens it again.
+  const Milliseconds timeoutBefore = scheduler.ResponseTimeout(4);
+  scheduler.OnTimeout(4);
+  TEST_ASSERT(scheduler.ResponseTimeout(4) > timeoutBefore);
+  TEST_ASSERT_FALSE(scheduler.IsBackingOff(4));
+  // Very fast followers are still bounded by the minimum.
+  scheduler.AddFollower(5);
+  for (int i = 0; i < 20; i++) { scheduler.OnResponse(5, 1); }
+  TEST_ASSERT_EQUAL(10, scheduler.ResponseTimeout(5));
+}
+
+void test_max485_poll_scheduler_backoff() {
+  Max485PollScheduler scheduler(kTestPollSchedulerConfig);
+  scheduler.AddFollower(4);
+  scheduler.AddFollower(5);
+  scheduler.AddFollower(6);
+  for (int i = 0; i < 3; i++) { scheduler.OnTimeout(5); }
+  TEST_ASSERT(scheduler.IsBackingOff(5));
+  // Skipped for one cycle, then probed.
+  TEST_ASSERT_EQUAL(4, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(6, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(4, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(5, scheduler.NextFollower());
+  // Each failed probe doubles the number of skipped cycles, up to the maximum of 4.
+  scheduler.OnTimeout(5);
+  TEST_ASSERT_EQUAL(6, scheduler.NextFollower());
+  for (int cycle = 0; cycle < 2; cycle++) {
+    TEST_ASSERT_EQUAL(4, scheduler.NextFollower());
+    TEST_ASSERT_EQUAL(6, scheduler.NextFollower());
+  }
+  TEST_ASSERT_EQUAL(4, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(5, scheduler.NextFollower());
+  scheduler.OnTimeout(5);
+  scheduler.OnTimeout(5);
+  scheduler.OnTimeout(5);
+  TEST_ASSERT(scheduler.IsBackingOff(5));
+  // Hearing from the follower brings it back immediately.
+  scheduler.OnHeardFrom(5);
+  TEST_ASSERT_FALSE(scheduler.IsBackingOff(5));
+  TEST_ASSERT_EQUAL(6, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(4, scheduler.NextFollower());
+  TEST_ASSERT_EQUAL(5, scheduler.NextFollower());
+  // If everyone is backing off we still poll someone.
+  for (BusId busId = 4; busId <= 6; busId++) {
+    for (int i = 0; i < 3; i++) { scheduler.OnTimeout(busId); }
+  }
+  TEST_ASSERT(scheduler.NextFollower() != Max485PollScheduler::kNoFollower);
+}
+
 void run_unity_tests() {
   UNITY_BEGIN();
   RUN_TEST(test_network_reader);
   RUN_TEST(test_network_writer);
   RUN_TEST(test_network_int32);
+  RUN_TEST(test_send_scheduler_backoff);
+  RUN_TEST(test_send_scheduler_suppression);
+  RUN_TEST(test_send_scheduler_next_check_time);
+  RUN_TEST(test_max485_poll_scheduler_round_robin);
+  RUN_TEST(test_max485_poll_scheduler_timeouts);
+  RUN_TEST(test_max485_poll_scheduler_backoff);
   UNITY_END();
 }
 
@@ -1,10 +1,17 @@
 #include <unity.h>
 
+#include <type_traits>
+#include <utility>
+
 #include "jazzlights/network/network.h"
 #include "jazzlights/orrery_common.h"
 
 namespace jazzlights {
 
+// Values can only be changed by assigning to the field, which also sets its presence flag.
+static_assert(std::is_const_v<std::remove_reference_t<decltype(*std::declval<OrreryField<int32_t>&>())>>,
+              "OrreryField must not hand out mutable references");
+
 void test_orrery_message_serialization() {
   OrreryMessage msg1;
   msg1.type = OrreryMessageType::LeaderCommand;
@@ -137,12 +144,70 @@ void test_orrery_message_disable_serialization() {
   TEST_ASSERT(reader.Done());
 }
 
+void test_orrery_message_full_serialization() {
+  OrreryMessage msg1;
+  msg1.type = OrreryMessageType::FollowerResponse;
+  msg1.leaderBootId = 0x01020304;
+  msg1.leaderSequenceNumber = 0x05060708;
+  msg1.speed = -1000;
+  msg1.position = 1;
+  msg1.calibration = 2;
+  msg1.timeHallSensorLastOpened = timeMillis() - 100;
+  msg1.timeHallSensorLastClosed = timeMillis() - 200;
+  msg1.lastOpenDuration = 3;
+  msg1.lastClosedDuration = 4;
+  msg1.ledPattern = 0xFFFFFFFF;
+  msg1.ledBrightness = 255;
+  msg1.ledBasePrecedence = 0xFFFF;
+  msg1.ledPrecedenceGain = 1;
+
+  uint8_t buffer[kOrreryMessageMaxEncodedLength];
+  NetworkWriter writer(buffer, sizeof(buffer));
+  TEST_ASSERT(WriteOrreryMessage(msg1, writer));
+  TEST_ASSERT_EQUAL(kOrreryMessageMaxEncodedLength, writer.LengthWritten());
+  // One byte short is not enough.
+  NetworkWriter shortWriter(buffer, sizeof(buffer) - 1);
+  TEST_ASSERT_FALSE(WriteOrreryMessage(msg1, shortWriter));
+
+  NetworkReader reader(buffer, writer.LengthWritten());
+  OrreryMessage msg2;
+  TEST_ASSERT(ReadOrreryMessage(reader, &msg2));
+  TEST_ASSERT(reader.Done());
+  TEST_ASSERT(msg1 == msg2);
+
+  // Truncated messages are rejected.
+  for (size_t length = 0; length < kOrreryMessageMaxEncodedLength; length++) {
+    NetworkReader truncatedReader(buffer, length);
+    OrreryMessage msg3;
+    TEST_ASSERT_FALSE(ReadOrreryMessage(truncatedReader, &msg3));
+  }
+}
+
+void test_orrery_message_equality() {
+  OrreryMessage msg1;
+  OrreryMessage msg2;
+  TEST_ASSERT(msg1 == msg2);
+  msg1.speed = 0;
+  TEST_ASSERT(msg1 != msg2);
+  msg2.speed = 0;
+  TEST_ASSERT(msg1 == msg2);
+  // Clearing a field makes it equal to one that was never set.
+  msg1.speed = 5;
+  msg1.speed = std::nullopt;
+  msg2.speed = std::nullopt;
+  TEST_ASSERT(msg1 == msg2);
+  msg1.ledBrightness = 7;
+  TEST_ASSERT(msg1 != msg2);
+}
+
 void run_unity_tests() {
   UNITY_BEGIN();
   RUN_TEST(test_orrery_message_serialization);
   RUN_TEST(test_orrery_message_hall_sensor_serialization);
   RUN_TEST(test_orrery_message_sparse_serialization);
   RUN_TEST(test_orrery_message_disable_serialization);
+  RUN_TEST(test_orrery_message_full_serialization);
+  RUN_TEST(test_orrery_message_equality);
   UNITY_END();
 }
 
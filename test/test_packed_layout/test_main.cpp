@@ -0,0 +1,94 @@
+#include <unity.h>
+
+#include <cstring>
+
+#include "jazzlights/layout/packed_layout.h"
+#include "jazzlights/layout/pixelmap.h"
+
+namespace jazzlights {
+
+// Same pixels as the packed ones below.
+constexpr Point kPoints[] = {
+    {-1.5,  2.0},
+    {-1.0,  2.0},
+    EmptyPoint(),
+    { 0.5, -3.0},
+    { 3.0,  2.0},
+    EmptyPoint(),
+    EmptyPoint(),
+    EmptyPoint(),
+    {-1.5,  7.0},
+};
+constexpr int16_t kXs[] = {0, 1, 0, 4, 9, 0, 0, 0, 0};
+constexpr int16_t kYs[] = {5, 5, 0, 0, 5, 0, 0, 0, 10};
+constexpr uint8_t kEmptyBits[] = {0xe4, 0x00};
+constexpr PackedPoints kPackedPoints = {
+    .count = 9,
+    .origin = {-1.5, -3.0},
+    .xStep = 0.5,
+    .yStep = 1.0,
+    .xs = kXs,
+    .ys = kYs,
+    .emptyBits = kEmptyBits,
+};
+
+bool SamePoint(Point a, Point b) { return (IsEmpty(a) && IsEmpty(b)) || memcmp(&a, &b, sizeof(Point)) == 0; }
+
+void test_packed_layout_matches_points() {
+  const PixelMap pixelMap(sizeof(kPoints) / sizeof(kPoints[0]), kPoints);
+  const PackedLayout packed(kPackedPoints);
+  TEST_ASSERT_EQUAL(pixelMap.pixelCount(), packed.pixelCount());
+  for (size_t i = 0; i < packed.pixelCount(); i++) {
+    TEST_ASSERT(SamePoint(pixelMap.at(i), packed.at(i)));
+    TEST_ASSERT_EQUAL(IsEmpty(pixelMap.at(i)), packed.isEmpty(i));
+  }
+  const Box pixelMapBounds = bounds(pixelMap);
+  const Box packedBounds = bounds(packed);
+  TEST_ASSERT(SamePoint(pixelMapBounds.origin, packedBounds.origin));
+  TEST_ASSERT(SamePoint({width(pixelMapBounds), height(pixelMapBounds)}, {width(packedBounds), height(packedBounds)}));
+}
+
+void test_packed_layout_without_empty_pixels() {
+  const PackedPoints points = {
+      .count = 3,
+      .origin = {0.0, 0.0},
+      .xStep = 1.0,
+      .yStep = 0.25,
+      .xs = kXs,
+      .ys = kYs,
+      .emptyBits = nullptr,
+  };
+  const PackedLayout packed(points);
+  TEST_ASSERT_EQUAL(3, packed.pixelCount());
+  TEST_ASSERT_FALSE(packed.isEmpty(2));
+  TEST_ASSERT(SamePoint({1.0, 1.25}, packed.at(1)));
+  TEST_ASSERT(SamePoint({0.0, 0.0}, packed.at(2)));
+}
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_packed_layout_matches_points);
+  RUN_TEST(test_packed_layout_without_empty_pixels);
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
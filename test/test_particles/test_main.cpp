@@ -0,0 +1,164 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "jazzlights/effect/particles.h"
+#include "lcg_random.h"
+
+namespace jazzlights {
+
+using TestPool = ParticlePool<500, 64>;
+static_assert(std::is_trivially_destructible<TestPool>::value, "ParticlePool must fit in an effect context");
+static_assert(std::is_trivially_destructible<ParticleEmitter>::value, "ParticleEmitter must fit in an effect context");
+
+constexpr Box kViewport = {
+    .size = {20.0, 10.0},
+    .origin = {-5.0, -2.0},
+};
+
+// Particles spread over the viewport and a bit beyond, moving in all directions.
+void SpawnTestParticles(TestPool* pool, size_t count) {
+  LcgRandom random(4321);
+  for (size_t i = 0; i < count; i++) {
+    const Point position = {left(kViewport) - 2 + random.NextUnit() * 24, top(kViewport) - 2 + random.NextUnit() * 14};
+    const Point velocity = {random.NextUnit() * 4 - 2, random.NextUnit() * 4 - 2};
+    pool->Spawn(position, velocity, 0, random.NextBetween(500, 2499), i);
+  }
+}
+
+void test_particles_near_matches_brute_force() {
+  auto pool = std::make_unique<TestPool>();
+  pool->Reset(kViewport, 1.5);
+  SpawnTestParticles(pool.get(), 400);
+  for (Milliseconds time : {0, 700, 1900}) {
+    pool->Update(time);
+    for (Coord x = left(kViewport) - 1; x <= right(kViewport) + 1; x += 0.7) {
+      for (Coord y = top(kViewport) - 1; y <= bottom(kViewport) + 1; y += 0.9) {
+        std::vector<size_t> found;
+        pool->ForEachNear({x, y}, [&](size_t i, float /*distanceSquared*/) { found.push_back(i); });
+        std::vector<size_t> expected;
+        for (size_t i = 0; i < pool->count(); i++) {
+          const float dx = pool->position(i).x - static_cast<float>(x);
+          const float dy = pool->position(i).y - static_cast<float>(y);
+          if (dx * dx + dy * dy <= 1.5f * 1.5f) { expected.push_back(i); }
+        }
+        std::sort(found.begin(), found.end());
+        TEST_ASSERT(found == expected);
+      }
+    }
+  }
+}
+
+void test_particles_move_and_expire() {
+  auto pool = std::make_unique<TestPool>();
+  pool->Reset(kViewport, 1.0);
+  TEST_ASSERT_TRUE(pool->Spawn({0, 0}, {2, -1}, 100, 1000, 7));
+  TEST_ASSERT_TRUE(pool->Spawn({1, 1}, {0, 0}, 100, 200, 8));
+  pool->Update(600);
+  TEST_ASSERT_EQUAL(1, pool->count());
+  TEST_ASSERT_EQUAL(7, pool->hue(0));
+  TEST_ASSERT(pool->position(0).x == 1.0 && pool->position(0).y == -0.5);
+  TEST_ASSERT(pool->progress(0) == 0.5f);
+  pool->Update(1100);
+  TEST_ASSERT_EQUAL(0, pool->count());
+
+  SpawnTestParticles(pool.get(), 500);
+  TEST_ASSERT_FALSE(pool->Spawn({0, 0}, {0, 0}, 0, 1000, 0));
+}
+
+// Spawns with emitter until end, rendering a frame every frameInterval, and returns the resulting particles. Also
+// returns how many particles did not fit in the pool in dropped, if set.
+template <typename Pool = TestPool>
+std::vector<std::pair<float, float>> RunEmitter(Milliseconds frameInterval, Milliseconds end,
+                                                uint32_t* dropped = nullptr) {
+  PredictableRandom predictableRandom;
+  Frame frame = {};
+  frame.pattern = 0x12345678;
+  frame.predictableRandom = &predictableRandom;
+  frame.viewport = kViewport;
+  predictableRandom.ResetWithFrameStart(frame, "particles");
+  auto pool = std::make_unique<Pool>();
+  pool->Reset(kViewport, 1.0);
+  ParticleEmitter emitter;
+  emitter.Begin(frame, {
+                           .position = {5.0, 3.0},
+                           .spread = 1.0,
+                           .minSpeed = 1.0,
+                           .maxSpeed = 3.0,
+                           .minLifetime = 300,
+                           .maxLifetime = 900,
+                           .interval = 15,
+                           .hue = 100,
+                           .hueSpread = 40,
+                       });
+  for (Milliseconds time = 0;; time = std::min(time + frameInterval, end)) {
+    emitter.Emit(time, pool.get());
+    pool->Update(time);
+    if (time == end) { break; }
+  }
+  if (dropped != nullptr) { *dropped = emitter.dropped(); }
+  std::vector<std::pair<float, float>> particles;
+  for (size_t i = 0; i < pool->count(); i++) {
+    TEST_ASSERT(pool->hue(i) >= 100 && pool->hue(i) <= 140);
+    TEST_ASSERT(pool->position(i).x >= 5.0 - 1.0 - 3.0 * 0.9 && pool->position(i).x <= 5.0 + 1.0 + 3.0 * 0.9);
+    particles.push_back({pool->position(i).x, pool->position(i).y});
+  }
+  std::sort(particles.begin(), particles.end());
+  return particles;
+}
+
+void test_particles_emitter_ignores_frame_rate() {
+  const std::vector<std::pair<float, float>> fast = RunEmitter(16, 5000);
+  TEST_ASSERT(fast.size() > 20);
+  TEST_ASSERT(fast == RunEmitter(50, 5000));
+  TEST_ASSERT(fast == RunEmitter(5000, 5000));
+  TEST_ASSERT(fast != RunEmitter(16, 5100));
+}
+
+void test_particles_emitter_ignores_frame_rate_when_full() {
+  // About 40 particles are alive at any time, so most of them do not fit.
+  using SmallPool = ParticlePool<16, 64>;
+  uint32_t fastDropped;
+  const std::vector<std::pair<float, float>> fast = RunEmitter<SmallPool>(16, 5000, &fastDropped);
+  TEST_ASSERT(fast.size() > 8);
+  TEST_ASSERT(fastDropped > 100);
+  for (Milliseconds frameInterval : {33, 50, 170}) {
+    uint32_t dropped;
+    TEST_ASSERT(fast == RunEmitter<SmallPool>(frameInterval, 5000, &dropped));
+    TEST_ASSERT_EQUAL(fastDropped, dropped);
+  }
+}
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_particles_near_matches_brute_force);
+  RUN_TEST(test_particles_move_and_expire);
+  RUN_TEST(test_particles_emitter_ignores_frame_rate);
+  RUN_TEST(test_particles_emitter_ignores_frame_rate_when_full);
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
@@ -0,0 +1,187 @@
+#include <unity.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "jazzlights/layout/matrix.h"
+#include "jazzlights/pattern_cache.h"
+#include "jazzlights/player.h"
+
+namespace jazzlights {
+
+constexpr PatternBits kTheMatrixPattern = 0x00001300;
+constexpr PatternBits kGlowRedPattern = 0x00000800;
+
+class CaptureRenderer : public Renderer {
+ public:
+  explicit CaptureRenderer(size_t numLeds) : colors(numLeds) {}
+  void renderPixel(size_t index, CRGB color) override { colors[index] = color; }
+  std::vector<CRGB> colors;
+};
+
+bool SameColors(const CRGB* a, const CRGB* b, size_t count) { return memcmp(a, b, count * sizeof(CRGB)) == 0; }
+
+// Frames with a mix of unchanged, repeated and varying colors.
+std::vector<CRGB> MakeFrame(size_t numLeds, uint32_t frame) {
+  std::vector<CRGB> colors(numLeds);
+  for (size_t i = 0; i < numLeds; i++) {
+    if (i < numLeds / 4) {
+      colors[i] = CRGB(1, 2, 3);
+    } else if (i < numLeds / 2) {
+      colors[i] = CRGB(frame, frame, frame);
+    } else {
+      colors[i] = CRGB(i * frame, i, frame);
+    }
+  }
+  return colors;
+}
+
+void test_pattern_cache_round_trip() {
+  constexpr size_t kNumLeds = 50;
+  constexpr uint32_t kNumFrames = 40;
+  PatternCacheWriter writer(kNumLeds, /*layoutFingerprint=*/1234, /*framesPerSecond=*/50, /*keyframeInterval=*/8);
+  writer.BeginPattern(kGlowRedPattern);
+  for (uint32_t frame = 0; frame < kNumFrames; frame++) { writer.AddFrame(MakeFrame(kNumLeds, frame).data()); }
+  writer.BeginPattern(kTheMatrixPattern);
+  writer.AddFrame(MakeFrame(kNumLeds, 7).data());
+  const std::vector<uint8_t> data = writer.Finish();
+  TEST_ASSERT_LESS_THAN(kNumFrames * kNumLeds * sizeof(CRGB), data.size());
+
+  std::unique_ptr<PatternCache> cache = PatternCache::Create(data.data(), data.size());
+  TEST_ASSERT(cache != nullptr);
+  TEST_ASSERT_EQUAL(kNumLeds, cache->numLeds());
+  TEST_ASSERT_EQUAL(1234, cache->layoutFingerprint());
+  TEST_ASSERT(cache->Contains(kGlowRedPattern));
+  TEST_ASSERT(cache->Contains(kTheMatrixPattern));
+  TEST_ASSERT_FALSE(cache->Contains(0x00000100));
+  // Sequential playback, including times between frames and across keyframes.
+  for (Milliseconds time = 0; time < static_cast<Milliseconds>(kNumFrames * 20); time += 7) {
+    const CRGB* colors = cache->FrameAt(kGlowRedPattern, time);
+    TEST_ASSERT_NOT_NULL(colors);
+    TEST_ASSERT(SameColors(MakeFrame(kNumLeds, time / 20).data(), colors, kNumLeds));
+  }
+  // Seeking backwards, and switching patterns.
+  for (uint32_t frame : {30u, 3u, 17u, 16u, 39u, 0u}) {
+    TEST_ASSERT(SameColors(MakeFrame(kNumLeds, frame).data(), cache->FrameAt(kGlowRedPattern, frame * 20), kNumLeds));
+    TEST_ASSERT(SameColors(MakeFrame(kNumLeds, 7).data(), cache->FrameAt(kTheMatrixPattern, 0), kNumLeds));
+  }
+  TEST_ASSERT_NULL(cache->FrameAt(kGlowRedPattern, kNumFrames * 20));
+  TEST_ASSERT_NULL(cache->FrameAt(kTheMatrixPattern, 20));
+  TEST_ASSERT_NULL(cache->FrameAt(0x00000100, 0));
+}
+
+void test_pattern_cache_rejects_corrupt_data() {
+  PatternCacheWriter writer(/*numLeds=*/10, /*layoutFingerprint=*/0, /*framesPerSecond=*/50);
+  writer.BeginPattern(kGlowRedPattern);
+  writer.AddFrame(MakeFrame(10, 1).data());
+  std::vector<uint8_t> data = writer.Finish();
+  TEST_ASSERT(PatternCache::Create(data.data(), sizeof(PatternCacheHeader) - 1) == nullptr);
+  TEST_ASSERT(PatternCache::Create(data.data(), sizeof(PatternCacheHeader) + 4) == nullptr);
+  // Truncating the frame data is detected when decoding.
+  std::unique_ptr<PatternCache> cache = PatternCache::Create(data.data(), data.size() - 1);
+  TEST_ASSERT(cache != nullptr);
+  TEST_ASSERT_NULL(cache->FrameAt(kGlowRedPattern, 0));
+  data[0] ^= 1;
+  TEST_ASSERT(PatternCache::Create(data.data(), data.size()) == nullptr);
+}
+
+// Renders pattern on a fresh player at the given times, optionally from a cache, and returns all the frames.
+std::vector<std::vector<CRGB>> RenderPattern(const Matrix& layout, PatternBits pattern,
+                                             const std::vector<Milliseconds>& times, PatternCache* cache) {
+  CaptureRenderer renderer(layout.pixelCount());
+  Player player;
+  player.addStrand(layout, renderer);
+  player.SetPatternCache(cache);
+  player.begin();
+  constexpr Milliseconds kStartTime = 1;
+  player.loopOne(kStartTime);
+  player.setPattern(pattern, kStartTime);
+  std::vector<std::vector<CRGB>> frames;
+  for (Milliseconds time : times) {
+    TEST_ASSERT(player.render(kStartTime + time));
+    frames.push_back(renderer.colors);
+  }
+  return frames;
+}
+
+void test_pattern_cache_player_playback() {
+  const Matrix layout(12, 8);
+  constexpr uint16_t kFramesPerSecond = 50;
+  constexpr uint32_t kNumFrames = 100;
+  std::vector<Milliseconds> frameTimes;
+  for (uint32_t frame = 0; frame < kNumFrames; frame++) { frameTimes.push_back(frame * 1000 / kFramesPerSecond); }
+  PatternCacheWriter writer(layout.pixelCount(), PatternCacheLayoutFingerprint({&layout}), kFramesPerSecond);
+  const std::vector<std::vector<CRGB>> liveFrames = RenderPattern(layout, kTheMatrixPattern, frameTimes, nullptr);
+  writer.BeginPattern(kTheMatrixPattern);
+  for (const std::vector<CRGB>& frame : liveFrames) { writer.AddFrame(frame.data()); }
+  const std::vector<uint8_t> data = writer.Finish();
+  std::unique_ptr<PatternCache> cache = PatternCache::Create(data.data(), data.size());
+  TEST_ASSERT(cache != nullptr);
+
+  // Playing back at the rendered times gives the same frames.
+  const std::vector<std::vector<CRGB>> cachedFrames =
+      RenderPattern(layout, kTheMatrixPattern, frameTimes, cache.get());
+  for (uint32_t frame = 0; frame < kNumFrames; frame++) {
+    TEST_ASSERT(SameColors(liveFrames[frame].data(), cachedFrames[frame].data(), layout.pixelCount()));
+  }
+  // Playing back at other times, as a device at a different frame rate would, shows the latest frame.
+  const std::vector<std::vector<CRGB>> offsetFrames =
+      RenderPattern(layout, kTheMatrixPattern, {15, 37, 1000, 1999}, cache.get());
+  TEST_ASSERT(SameColors(liveFrames[0].data(), offsetFrames[0].data(), layout.pixelCount()));
+  TEST_ASSERT(SameColors(liveFrames[1].data(), offsetFrames[1].data(), layout.pixelCount()));
+  TEST_ASSERT(SameColors(liveFrames[50].data(), offsetFrames[2].data(), layout.pixelCount()));
+  TEST_ASSERT(SameColors(liveFrames[99].data(), offsetFrames[3].data(), layout.pixelCount()));
+
+  // The player really shows the cached frames instead of computing the pattern.
+  PatternCacheWriter fakeWriter(layout.pixelCount(), PatternCacheLayoutFingerprint({&layout}), kFramesPerSecond);
+  fakeWriter.BeginPattern(kTheMatrixPattern);
+  fakeWriter.AddFrame(MakeFrame(layout.pixelCount(), 5).data());
+  const std::vector<uint8_t> fakeData = fakeWriter.Finish();
+  std::unique_ptr<PatternCache> fakeCache = PatternCache::Create(fakeData.data(), fakeData.size());
+  const std::vector<std::vector<CRGB>> fakeFrames = RenderPattern(layout, kTheMatrixPattern, {0}, fakeCache.get());
+  TEST_ASSERT(SameColors(MakeFrame(layout.pixelCount(), 5).data(), fakeFrames[0].data(), layout.pixelCount()));
+
+  // Caches rendered for other layouts are ignored, even when they hold the pattern and the pixel count matches.
+  const Matrix otherLayout(8, 12);
+  TEST_ASSERT_EQUAL(layout.pixelCount(), otherLayout.pixelCount());
+  const std::vector<Milliseconds> otherTimes = {0, 500, 1980};
+  const std::vector<std::vector<CRGB>> otherLiveFrames =
+      RenderPattern(otherLayout, kTheMatrixPattern, otherTimes, nullptr);
+  for (PatternCache* otherCache : {cache.get(), fakeCache.get()}) {
+    const std::vector<std::vector<CRGB>> otherFrames =
+        RenderPattern(otherLayout, kTheMatrixPattern, otherTimes, otherCache);
+    for (size_t frame = 0; frame < otherTimes.size(); frame++) {
+      TEST_ASSERT(SameColors(otherLiveFrames[frame].data(), otherFrames[frame].data(), otherLayout.pixelCount()));
+    }
+  }
+}
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_pattern_cache_round_trip);
+  RUN_TEST(test_pattern_cache_rejects_corrupt_data);
+  RUN_TEST(test_pattern_cache_player_playback);
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
@@ -1,5 +1,9 @@
 #include <unity.h>
 
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include "jazzlights/effect/calibration.h"
 #include "jazzlights/effect/clouds.h"
 #include "jazzlights/effect/colored_bursts.h"
@@ -8,17 +12,22 @@
 #include "jazzlights/effect/follow_strand.h"
 #include "jazzlights/effect/glitter.h"
 #include "jazzlights/effect/glow.h"
+#include "jazzlights/effect/grid_kernels.h"
 #include "jazzlights/effect/hiphotic.h"
+#include "jazzlights/effect/line_raster.h"
 #include "jazzlights/effect/mapping.h"
+#include "jazzlights/effect/pixel_field.h"
 #include "jazzlights/effect/metaballs.h"
 #include "jazzlights/effect/plasma.h"
 #include "jazzlights/effect/rings.h"
+#include "jazzlights/effect/separable_tables.h"
 #include "jazzlights/effect/solid.h"
 #include "jazzlights/effect/sync_test.h"
 #include "jazzlights/effect/the_matrix.h"
 #include "jazzlights/effect/threesine.h"
 #include "jazzlights/layout/matrix.h"
 #include "jazzlights/renderer.h"
+#include "lcg_random.h"
 
 namespace jazzlights {
 
@@ -31,6 +40,7 @@ void test_pattern(const Effect& effect) {
   Matrix layout(1, 1);
   NoOpRenderer renderer;
   Strand strand = {layout, renderer, 0};
+  const std::vector<Strand> strands = {strand};
   PredictableRandom predictableRandom;
   XYIndexStore xyIndexStore;
   xyIndexStore.IngestLayout(&layout);
@@ -43,6 +53,7 @@ void test_pattern(const Effect& effect) {
   frame.context = nullptr;
   frame.time = 33;
   frame.pixelCount = layout.pixelCount();
+  frame.strands = &strands;
   TEST_ASSERT_NOT_EQUAL("", effect.effectName(frame.pattern));
   size_t effectContextSize = effect.contextSize(frame);
   if ((effectContextSize % kMaxStateAlignment) != 0) {
@@ -93,10 +104,247 @@ void test_thematrix_pattern() {
   static const TheMatrix thematrix_pattern;
   test_pattern(thematrix_pattern);
 }
+// TheMatrix with only the whole-grid passes, which the per-column row ranges have to match.
+class DenseMatrix : public TheMatrix {
+ public:
+  void innerBegin(const Frame& f, MatrixState* state) const override {
+    state->fallInterval = f.predictableRandom->GetRandomNumberBetween(20, 40);
+    state->spawnRate = f.predictableRandom->GetRandomNumberBetween(192, 255);
+    state->fadeRate = f.predictableRandom->GetRandomNumberBetween(10, 40);
+    state->maxTicks = f.predictableRandom->GetRandomNumberBetween(1, 5);
+    state->currentTicks = 0;
+    memset(cells(f), 0, w(f) * h(f));
+    for (size_t y = 0; y < 2 * h(f); y++) { progressEffect(f, state); }
+  }
+  void innerRewind(const Frame& f, MatrixState* state) const override {
+    state->currentTicks++;
+    if (state->currentTicks < state->maxTicks) { return; }
+    state->currentTicks = 0;
+    progressEffect(f, state);
+  }
+
+ private:
+  void progressEffect(const Frame& f, MatrixState* state) const {
+    GridShiftMarkers(cells(f), w(f), h(f), kMatrixSpawn, kMatrixTrail);
+    GridSubtractSaturating(cells(f), w(f) * h(f), state->fadeRate, /*skip=*/kMatrixSpawn);
+    if (f.predictableRandom->GetRandomByte() < state->spawnRate) {
+      ps(f, f.predictableRandom->GetRandomNumberBetween(0, w(f) - 1), 0) = kMatrixSpawn;
+    }
+  }
+};
+void test_thematrix_columns_match_grid() {
+  static const TheMatrix matrix;
+  static const DenseMatrix dense;
+  // Wide and short grids stay sparse, narrow and tall ones go back and forth between both paths.
+  for (const auto& [width, height] : {std::pair<size_t, size_t>{64, 20}, {5, 40}}) {
+    Matrix layout(width, height);
+    NoOpRenderer renderer;
+    Strand strand = {layout, renderer, 0};
+    const std::vector<Strand> strands = {strand};
+    XYIndexStore xyIndexStore;
+    xyIndexStore.IngestLayout(&layout);
+    xyIndexStore.Finalize(jazzlights::bounds(layout));
+    PredictableRandom predictableRandom;
+    Frame frame;
+    frame.pattern = 0x1234;
+    frame.predictableRandom = &predictableRandom;
+    frame.xyIndexStore = &xyIndexStore;
+    frame.viewport = jazzlights::bounds(layout);
+    frame.time = 0;
+    frame.pixelCount = layout.pixelCount();
+    frame.strands = &strands;
+    Frame denseFrame = frame;
+    size_t contextSize = matrix.contextSize(frame);
+    if ((contextSize % kMaxStateAlignment) != 0) {
+      contextSize += kMaxStateAlignment - (contextSize % kMaxStateAlignment);
+    }
+    frame.context = aligned_alloc(kMaxStateAlignment, contextSize);
+    denseFrame.context = aligned_alloc(kMaxStateAlignment, contextSize);
+    predictableRandom.ResetWithFrameStart(frame, "the-matrix");
+    matrix.begin(frame);
+    predictableRandom.ResetWithFrameStart(denseFrame, "the-matrix");
+    dense.begin(denseFrame);
+    size_t mismatches = 0;
+    size_t litPixels = 0;
+    for (; frame.time < 20000; frame.time += 20) {
+      denseFrame.time = frame.time;
+      predictableRandom.ResetWithFrameTime(frame, "the-matrix");
+      matrix.rewind(frame);
+      predictableRandom.ResetWithFrameTime(denseFrame, "the-matrix");
+      dense.rewind(denseFrame);
+      for (size_t i = 0; i < layout.pixelCount(); i++) {
+        Pixel px;
+        px.strand = &strand;
+        px.strandIndex = i;
+        px.cumulativeIndex = i;
+        px.coord = layout.at(i);
+        const CRGB color = matrix.color(frame, px);
+        const CRGB denseColor = dense.color(denseFrame, px);
+        if (memcmp(&color, &denseColor, sizeof(CRGB)) != 0) { mismatches++; }
+        if (color.r != 0 || color.g != 0 || color.b != 0) { litPixels++; }
+      }
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+    TEST_ASSERT(litPixels > 1000);
+    free(frame.context);
+    free(denseFrame.context);
+  }
+}
 void test_rings_pattern() {
   static const Rings rings_pattern;
   test_pattern(rings_pattern);
 }
+void test_pixel_field() {
+  Matrix layout(3, 2, 1.0);
+  NoOpRenderer renderer;
+  const std::vector<Strand> strands = {Strand{layout, renderer, 0}};
+  Frame frame;
+  frame.viewport = jazzlights::bounds(layout);
+  frame.pixelCount = layout.pixelCount();
+  frame.strands = &strands;
+  float field[6];
+  ComputePixelField(frame, PixelFieldType::kDistance, {0.0, 0.0}, 2.0, field);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.0, field[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 4.0, field[2]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.0 * sqrt(2.0), field[4]);
+  ComputePixelField(frame, PixelFieldType::kNormalizedX, {0.0, 0.0}, 1.0, field);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.5, field[1]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0, field[5]);
+  ComputePixelField(frame, PixelFieldType::kNormalizedY, {0.0, 0.0}, 1.0, field);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.0, field[2]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0, field[3]);
+  ComputePixelField(frame, PixelFieldType::kAngle, {1.0, 0.0}, 1.0, field);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, M_PI / 2, field[4]);
+}
+void test_separable_tables() {
+  Matrix layout(4, 3, 1.0);
+  NoOpRenderer renderer;
+  const Strand strand = {layout, renderer, 0};
+  XYIndexStore xyIndexStore;
+  xyIndexStore.IngestLayout(&layout);
+  xyIndexStore.Finalize(jazzlights::bounds(layout));
+  Frame frame;
+  frame.xyIndexStore = &xyIndexStore;
+  TEST_ASSERT_EQUAL(sizeof(float) * (4 + 3), SeparableTables<float>::Size(frame));
+  float memory[4 + 3];
+  SeparableTables<float> tables(frame, memory);
+  tables.FillColumns([](Coord x) -> float { return x; });
+  tables.FillRows([](Coord y) -> float { return 10 * y; });
+  Pixel px;
+  px.strand = &strand;
+  for (size_t i = 0; i < layout.pixelCount(); i++) {
+    px.strandIndex = i;
+    const XYIndex xyIndex = xyIndexStore.FromPixel(px);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, layout.at(i).x, tables.column(xyIndex));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 10 * layout.at(i).y, tables.row(xyIndex));
+  }
+}
+void test_grid_kernels() {
+  constexpr size_t kWidth = 7;
+  constexpr size_t kHeight = 5;
+  constexpr size_t kCount = kWidth * kHeight;
+  uint8_t initial[kCount];
+  for (size_t i = 0; i < kCount; i++) { initial[i] = static_cast<uint8_t>(i * 37 + 11); }
+  initial[3] = 255;
+  initial[kCount - 2] = 255;
+  uint8_t cells[kCount];
+  uint8_t expected[kCount];
+  // Start one byte in so that the cells are not aligned.
+  uint8_t unaligned[kCount + 1];
+
+  memcpy(&unaligned[1], initial, kCount);
+  GridScale8(&unaligned[1], kCount, 200);
+  for (size_t i = 0; i < kCount; i++) { expected[i] = scale8(initial[i], 200); }
+  TEST_ASSERT_EQUAL_MEMORY(expected, &unaligned[1], kCount);
+
+  CRGB colors[kCount / 3];
+  CRGB expectedColors[kCount / 3];
+  for (size_t i = 0; i < kCount / 3; i++) {
+    colors[i] = CRGB(initial[i * 3], initial[i * 3 + 1], initial[i * 3 + 2]);
+    expectedColors[i] = colors[i];
+    expectedColors[i].nscale8(100);
+  }
+  GridScale8(colors, kCount / 3, 100);
+  TEST_ASSERT_EQUAL_MEMORY(expectedColors, colors, sizeof(colors));
+
+  memcpy(&unaligned[1], initial, kCount);
+  GridSubtractSaturating(&unaligned[1], kCount, 40, /*skip=*/255);
+  for (size_t i = 0; i < kCount; i++) { expected[i] = initial[i] == 255 ? 255 : qsub8(initial[i], 40); }
+  TEST_ASSERT_EQUAL_MEMORY(expected, &unaligned[1], kCount);
+
+  memcpy(cells, initial, kCount);
+  GridBlurShiftRows(cells, kWidth, kHeight);
+  for (size_t x = 0; x < kWidth; x++) {
+    expected[x] = initial[x];
+    expected[kWidth + x] = initial[x];
+    expected[2 * kWidth + x] = (initial[kWidth + x] + initial[x]) / 2;
+    for (size_t y = 3; y < kHeight; y++) {
+      expected[y * kWidth + x] =
+          (initial[(y - 1) * kWidth + x] + initial[(y - 2) * kWidth + x] + initial[(y - 3) * kWidth + x]) / 3;
+    }
+  }
+  TEST_ASSERT_EQUAL_MEMORY(expected, cells, kCount);
+
+  memcpy(cells, initial, kCount);
+  GridShiftMarkers(cells, kWidth, kHeight, /*marker=*/255, /*trail=*/200);
+  memcpy(expected, initial, kCount);
+  // The marker in the first row moves down one row, the one in the last row falls off.
+  expected[3] = 200;
+  expected[kWidth + 3] = 255;
+  expected[kCount - 2] = 200;
+  TEST_ASSERT_EQUAL_MEMORY(expected, cells, kCount);
+}
+void test_line_raster() {
+  constexpr int kWidth = 9;
+  constexpr int kHeight = 6;
+  LcgRandom random(1);
+  for (int line = 0; line < 500; line++) {
+    int endpoints[4];
+    // Include endpoints outside the grid to exercise clipping.
+    for (int& e : endpoints) { e = random.NextBetween(-8, 15); }
+    const int x0 = endpoints[0], y0 = endpoints[1], x1 = endpoints[2], y1 = endpoints[3];
+    const int steps = LineSteps(x0, y0, x1, y1);
+    // Reference: walk the whole line with the rounding formula and keep the cells on the grid.
+    std::vector<std::tuple<int, int, int>> expected;
+    for (int step = 0; step <= steps; step++) {
+      int x = x0, y = y0;
+      if (steps > 0) {
+        x += (x1 >= x0 ? 1 : -1) * ((2 * step * std::abs(x1 - x0) + steps) / (2 * steps));
+        y += (y1 >= y0 ? 1 : -1) * ((2 * step * std::abs(y1 - y0) + steps) / (2 * steps));
+      }
+      if (x >= 0 && x < kWidth && y >= 0 && y < kHeight) { expected.emplace_back(x, y, step); }
+    }
+    std::vector<std::tuple<int, int, int>> visited;
+    RasterizeLine(x0, y0, x1, y1, kWidth, kHeight, [&](int x, int y, int step) { visited.emplace_back(x, y, step); });
+    TEST_ASSERT(expected == visited);
+
+    int antialiasedSteps = 0;
+    RasterizeLineAntialiased(x0, y0, x1, y1, kWidth, kHeight, [&](int x, int y, int /*step*/, uint8_t coverage) {
+      TEST_ASSERT(x >= 0 && x < kWidth && y >= 0 && y < kHeight);
+      TEST_ASSERT(coverage > 0);
+      antialiasedSteps++;
+    });
+    TEST_ASSERT(antialiasedSteps >= static_cast<int>(visited.size()) / 2);
+  }
+  // Endpoints of an anti-aliased line on the grid get full coverage.
+  int fullCoverage = 0;
+  RasterizeLineAntialiased(0, 0, 8, 4, kWidth, kHeight, [&](int x, int y, int /*step*/, uint8_t coverage) {
+    if (coverage == 255) {
+      TEST_ASSERT((x == 0 && y == 0) || (x == 8 && y == 4) || x == 2 || x == 4 || x == 6);
+      fullCoverage++;
+    }
+  });
+  TEST_ASSERT_EQUAL(5, fullCoverage);
+
+  CRGB cells[kWidth * kHeight] = {};
+  DrawLine(cells, kWidth, kHeight, 0, 1, 4, 1, CRGB(100, 100, 100), /*gradient=*/false);
+  for (int x = 0; x <= 4; x++) { TEST_ASSERT_EQUAL(100, cells[kWidth + x].r); }
+  TEST_ASSERT_EQUAL(0, cells[kWidth + 5].r);
+  DrawLine(cells, kWidth, kHeight, 0, 2, 4, 2, CRGB(100, 100, 100), /*gradient=*/true);
+  TEST_ASSERT_EQUAL(0, cells[2 * kWidth].r);
+  TEST_ASSERT(cells[2 * kWidth + 1].r < cells[2 * kWidth + 4].r);
+  TEST_ASSERT_EQUAL(100, cells[2 * kWidth + 4].r);
+}
 void test_threesine_pattern() {
   static const FunctionalEffect threesine_pattern = threesine();
   test_pattern(threesine_pattern);
@@ -191,7 +439,12 @@ void run_unity_tests() {
   RUN_TEST(test_flame_pattern);
   RUN_TEST(test_glitter_pattern);
   RUN_TEST(test_thematrix_pattern);
+  RUN_TEST(test_thematrix_columns_match_grid);
   RUN_TEST(test_rings_pattern);
+  RUN_TEST(test_pixel_field);
+  RUN_TEST(test_separable_tables);
+  RUN_TEST(test_grid_kernels);
+  RUN_TEST(test_line_raster);
   RUN_TEST(test_threesine_pattern);
   RUN_TEST(test_follow_strand_effect);
   RUN_TEST(test_mapping_effect);
@@ -0,0 +1,201 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jazzlights/frame_sink.h"
+#include "jazzlights/layout/matrix.h"
+#include "jazzlights/player.h"
+#include "jazzlights/software_renderer.h"
+
+#ifndef ESP32
+#include <unistd.h>
+#endif  // !ESP32
+
+namespace jazzlights {
+
+bool SameColor(CRGB a, CRGB b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+
+size_t CountLitPixels(const SoftwareRenderer& renderer) {
+  size_t numLit = 0;
+  for (size_t i = 0; i < renderer.width() * renderer.height(); i++) {
+    if (!SameColor(renderer.pixels()[i], CRGB::Black)) { numLit++; }
+  }
+  return numLit;
+}
+
+void test_software_renderer_one_pixel_per_led() {
+  Matrix layout(4, 3);
+  SoftwareRenderer renderer(layout, 4, 3);
+  for (size_t i = 0; i < layout.pixelCount(); i++) { renderer.renderPixel(i, CRGB(i, 2 * i, 3 * i)); }
+  for (size_t i = 0; i < layout.pixelCount(); i++) {
+    TEST_ASSERT_EQUAL(i, renderer.pixels()[i].r);
+    TEST_ASSERT_EQUAL(2 * i, renderer.pixels()[i].g);
+    TEST_ASSERT_EQUAL(3 * i, renderer.pixels()[i].b);
+  }
+}
+
+void test_software_renderer_keeps_aspect_ratio() {
+  Matrix layout(3, 1);
+  SoftwareRenderer renderer(layout, 9, 9);
+  for (size_t i = 0; i < layout.pixelCount(); i++) { renderer.renderPixel(i, CRGB::White); }
+  TEST_ASSERT_EQUAL(3, CountLitPixels(renderer));
+  // The layout is centered vertically and spread across the whole width.
+  TEST_ASSERT(SameColor(renderer.pixels()[4 * 9 + 0], CRGB::White));
+  TEST_ASSERT(SameColor(renderer.pixels()[4 * 9 + 4], CRGB::White));
+  TEST_ASSERT(SameColor(renderer.pixels()[4 * 9 + 8], CRGB::White));
+}
+
+void test_software_renderer_disc() {
+  Matrix layout(2, 2);
+  SoftwareRenderer renderer(layout, 8, 8, /*ledRadius=*/2);
+  renderer.renderPixel(0, CRGB::Red);
+  // A disc of radius 2 covers 13 pixels, and it must fit in the image without clipping.
+  TEST_ASSERT_EQUAL(13, CountLitPixels(renderer));
+  TEST_ASSERT(SameColor(renderer.pixels()[2 * 8 + 2], CRGB::Red));
+  TEST_ASSERT(SameColor(renderer.pixels()[0 * 8 + 2], CRGB::Red));
+  TEST_ASSERT(SameColor(renderer.pixels()[0 * 8 + 0], CRGB::Black));
+  renderer.renderPixel(3, CRGB::Blue);
+  TEST_ASSERT_EQUAL(26, CountLitPixels(renderer));
+  TEST_ASSERT(SameColor(renderer.pixels()[5 * 8 + 5], CRGB::Blue));
+}
+
+uint32_t RenderPatternHash(PatternBits pattern, int numFrames) {
+  Matrix layout(20, 10);
+  SoftwareRenderer renderer(layout, 40, 20);
+  Player player;
+  player.addStrand(layout, renderer);
+  player.begin();
+  constexpr Milliseconds kStartTime = 1000;
+  player.loopOne(kStartTime);
+  player.setPattern(pattern, kStartTime);
+  uint32_t hash = 2166136261u;
+  for (int frame = 0; frame < numFrames; frame++) {
+    player.render(kStartTime + frame * 33);
+    const uint8_t* bytes = &renderer.pixels()[0].r;
+    for (size_t i = 0; i < renderer.width() * renderer.height() * sizeof(CRGB); i++) {
+      hash = (hash ^ bytes[i]) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+void test_software_renderer_deterministic() {
+  constexpr PatternBits kTheMatrixPattern = 0x00001300;
+  TEST_ASSERT_EQUAL_UINT32(RenderPatternHash(kTheMatrixPattern, 30), RenderPatternHash(kTheMatrixPattern, 30));
+}
+
+#ifndef ESP32
+
+std::vector<uint8_t> ReadAll(FILE* file) {
+  std::vector<uint8_t> contents;
+  rewind(file);
+  int c;
+  while ((c = fgetc(file)) != EOF) { contents.push_back(static_cast<uint8_t>(c)); }
+  return contents;
+}
+
+void test_frame_sink_ppm() {
+  FILE* file = tmpfile();
+  TEST_ASSERT_NOT_NULL(file);
+  FileFrameSink sink(file, FrameFormat::kPpm, 2, 1, 30);
+  const CRGB pixels[2] = {CRGB(1, 2, 3), CRGB(4, 5, 6)};
+  TEST_ASSERT(sink.WriteFrame(pixels));
+  TEST_ASSERT(sink.WriteFrame(pixels));
+  const std::string header = "P6\n2 1\n255\n";
+  const std::vector<uint8_t> contents = ReadAll(file);
+  fclose(file);
+  TEST_ASSERT_EQUAL(2 * (header.size() + 6), contents.size());
+  for (size_t frame = 0; frame < 2; frame++) {
+    const uint8_t* data = &contents[frame * (header.size() + 6)];
+    TEST_ASSERT_EQUAL(0, memcmp(data, header.data(), header.size()));
+    for (uint8_t i = 0; i < 6; i++) { TEST_ASSERT_EQUAL(i + 1, data[header.size() + i]); }
+  }
+}
+
+void test_frame_sink_y4m() {
+  FILE* file = tmpfile();
+  TEST_ASSERT_NOT_NULL(file);
+  FileFrameSink sink(file, FrameFormat::kY4m, 2, 1, 25);
+  const CRGB pixels[2] = {CRGB::Black, CRGB::White};
+  TEST_ASSERT(sink.WriteFrame(pixels));
+  TEST_ASSERT(sink.WriteFrame(pixels));
+  const std::string streamHeader = "YUV4MPEG2 W2 H1 F25:1 Ip A1:1 C444\n";
+  const std::string frameHeader = "FRAME\n";
+  const std::vector<uint8_t> contents = ReadAll(file);
+  fclose(file);
+  TEST_ASSERT_EQUAL(streamHeader.size() + 2 * (frameHeader.size() + 6), contents.size());
+  TEST_ASSERT_EQUAL(0, memcmp(contents.data(), streamHeader.data(), streamHeader.size()));
+  const uint8_t* frame = &contents[streamHeader.size()];
+  TEST_ASSERT_EQUAL(0, memcmp(frame, frameHeader.data(), frameHeader.size()));
+  // Studio range: black is Y=16 and white is Y=235, both without chroma.
+  const uint8_t expectedPlanes[6] = {16, 235, 128, 128, 128, 128};
+  TEST_ASSERT_EQUAL(0, memcmp(expectedPlanes, frame + frameHeader.size(), sizeof(expectedPlanes)));
+}
+
+void test_frame_sink_shared_memory() {
+  const std::string name = "/jazzlights-test-" + std::to_string(getpid());
+  std::unique_ptr<SharedMemoryFrameSink> sink = SharedMemoryFrameSink::Create(name, 3, 2, /*slotCount=*/2);
+  TEST_ASSERT(sink != nullptr);
+  // A second writer must not take over the ring of the first.
+  TEST_ASSERT(SharedMemoryFrameSink::Create(name, 3, 2) == nullptr);
+  std::unique_ptr<SharedMemoryFrameReader> reader = SharedMemoryFrameReader::Open(name);
+  TEST_ASSERT(reader != nullptr);
+  TEST_ASSERT_EQUAL(3, reader->width());
+  TEST_ASSERT_EQUAL(2, reader->height());
+  CRGB pixels[6];
+  TEST_ASSERT_EQUAL(0, reader->ReadLatestFrame(pixels));
+  // Write more frames than there are slots to exercise wrapping around.
+  for (uint8_t frame = 1; frame <= 5; frame++) {
+    CRGB written[6];
+    for (uint8_t i = 0; i < 6; i++) { written[i] = CRGB(frame, i, 0); }
+    TEST_ASSERT(sink->WriteFrame(written));
+    TEST_ASSERT_EQUAL(frame, reader->ReadLatestFrame(pixels));
+    TEST_ASSERT_EQUAL(0, memcmp(written, pixels, sizeof(pixels)));
+  }
+  sink.reset();
+  // The reader keeps its mapping after the sink removes the object, but it can no longer be opened.
+  TEST_ASSERT_EQUAL(5, reader->ReadLatestFrame(pixels));
+  TEST_ASSERT(SharedMemoryFrameReader::Open(name) == nullptr);
+  TEST_ASSERT(SharedMemoryFrameSink::Create(name, 3, 2) != nullptr);
+}
+
+#endif  // !ESP32
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_software_renderer_one_pixel_per_led);
+  RUN_TEST(test_software_renderer_keeps_aspect_ratio);
+  RUN_TEST(test_software_renderer_disc);
+  RUN_TEST(test_software_renderer_deterministic);
+#ifndef ESP32
+  RUN_TEST(test_frame_sink_ppm);
+  RUN_TEST(test_frame_sink_y4m);
+  RUN_TEST(test_frame_sink_shared_memory);
+#endif  // !ESP32
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32
@@ -0,0 +1,204 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "jazzlights/layout/matrix.h"
+#include "jazzlights/layout/pixelmap.h"
+#include "jazzlights/renderer.h"
+#include "jazzlights/spatial_index.h"
+#include "lcg_random.h"
+
+namespace jazzlights {
+
+class NullRenderer : public Renderer {
+ public:
+  void renderPixel(size_t /*index*/, CRGB /*color*/) override {}
+};
+
+// Deterministic points with some duplicates and empty ones, spread over a wider area than the matrix.
+std::vector<Point> MakePoints(size_t count) {
+  std::vector<Point> points;
+  LcgRandom random(12345);
+  for (size_t i = 0; i < count; i++) {
+    if (i % 17 == 5) {
+      points.push_back(EmptyPoint());
+    } else if (i % 23 == 7) {
+      points.push_back(points[i - 1]);
+    } else {
+      points.push_back({random.NextUnit() * 30 - 10, random.NextUnit() * 4 - 2});
+    }
+  }
+  return points;
+}
+
+struct TestPixels {
+  TestPixels() : points(MakePoints(200)), pixelMap(points.size(), points.data()), matrix(12, 9) {
+    strands.push_back({matrix, renderer, 0});
+    strands.push_back({pixelMap, renderer, 1});
+    for (const Strand& strand : strands) {
+      for (size_t i = 0; i < strand.layout.pixelCount(); i++) { all.push_back(strand.layout.at(i)); }
+    }
+    index.Build(strands);
+  }
+
+  float DistanceSquared(size_t i, Point center) const {
+    const float dx = static_cast<float>(all[i].x) - static_cast<float>(center.x);
+    const float dy = static_cast<float>(all[i].y) - static_cast<float>(center.y);
+    return dx * dx + dy * dy;
+  }
+
+  // Distances of the k closest non-empty pixels other than exclude, found by looking at every pixel.
+  std::vector<float> BruteForceNearest(Point center, size_t k, size_t exclude) const {
+    std::vector<float> distances;
+    for (size_t i = 0; i < all.size(); i++) {
+      if (i != exclude && !IsEmpty(all[i])) { distances.push_back(DistanceSquared(i, center)); }
+    }
+    std::sort(distances.begin(), distances.end());
+    distances.resize(std::min(k, distances.size()));
+    return distances;
+  }
+
+  // Checks results against BruteForceNearest. Ties can come back in any order so only distances are compared.
+  void CheckNearest(Point center, size_t k, const uint32_t* results, size_t exclude) const {
+    const std::vector<float> expected = BruteForceNearest(center, k, exclude);
+    for (size_t j = 0; j < k; j++) {
+      if (j >= expected.size()) {
+        TEST_ASSERT_EQUAL(SpatialIndex::kNoPixel, results[j]);
+        continue;
+      }
+      TEST_ASSERT(results[j] < all.size());
+      TEST_ASSERT(results[j] != exclude);
+      TEST_ASSERT_FALSE(IsEmpty(all[results[j]]));
+      TEST_ASSERT(DistanceSquared(results[j], center) == expected[j]);
+    }
+  }
+
+  std::vector<Point> points;
+  PixelMap pixelMap;
+  Matrix matrix;
+  NullRenderer renderer;
+  std::vector<Strand> strands;
+  std::vector<Point> all;
+  SpatialIndex index;
+};
+
+const Point kQueries[] = {
+    {0.0, 0.0}, {5.5, 3.5}, {-9.0, 1.9}, {19.9, -2.0}, {-40.0, 0.0}, {3.0, 50.0}, {11.0, 8.0}, {0.25, -0.75},
+};
+
+void test_spatial_index_radius_matches_brute_force() {
+  TestPixels pixels;
+  TEST_ASSERT_EQUAL(pixels.all.size(), pixels.index.pixelCount());
+  for (const Point& center : kQueries) {
+    for (Coord radius : {0.0, 0.3, 1.0, 2.5, 100.0}) {
+      std::vector<uint32_t> found;
+      pixels.index.ForEachWithinRadius(center, radius, [&](uint32_t index, float distanceSquared) {
+        TEST_ASSERT(distanceSquared == pixels.DistanceSquared(index, center));
+        found.push_back(index);
+      });
+      std::vector<uint32_t> expected;
+      const float radiusSquared = radius * radius;
+      for (size_t i = 0; i < pixels.all.size(); i++) {
+        if (!IsEmpty(pixels.all[i]) && pixels.DistanceSquared(i, center) <= radiusSquared) { expected.push_back(i); }
+      }
+      std::sort(found.begin(), found.end());
+      TEST_ASSERT(found == expected);
+    }
+  }
+}
+
+void test_spatial_index_nearest_matches_brute_force() {
+  TestPixels pixels;
+  uint32_t results[SpatialIndex::kMaxNearest];
+  for (const Point& center : kQueries) {
+    for (size_t k : {1, 4, 9, 32}) {
+      std::fill(results, results + k, SpatialIndex::kNoPixel);
+      TEST_ASSERT_EQUAL(k, pixels.index.Nearest(center, k, results));
+      pixels.CheckNearest(center, k, results, SpatialIndex::kNoPixel);
+    }
+  }
+}
+
+void test_spatial_index_neighbor_lists() {
+  TestPixels pixels;
+  constexpr size_t k = 6;
+  std::vector<uint32_t> neighbors(pixels.index.pixelCount() * k);
+  pixels.index.ComputeNeighborLists(k, neighbors.data());
+  for (size_t i = 0; i < pixels.all.size(); i++) {
+    if (IsEmpty(pixels.all[i])) {
+      for (size_t j = 0; j < k; j++) { TEST_ASSERT_EQUAL(SpatialIndex::kNoPixel, neighbors[i * k + j]); }
+      continue;
+    }
+    pixels.CheckNearest(pixels.all[i], k, &neighbors[i * k], i);
+  }
+}
+
+void test_spatial_index_small_layouts() {
+  SpatialIndex index;
+  uint32_t results[4];
+  index.Build({});
+  TEST_ASSERT_EQUAL(0, index.Nearest({0, 0}, 4, results));
+
+  // A single pixel has no neighbors, and a line of pixels must not create a cell per pixel.
+  NullRenderer renderer;
+  Matrix single(1, 1);
+  Matrix line(500, 1);
+  index.Build({{single, renderer, 0}});
+  TEST_ASSERT_EQUAL(1, index.Nearest({3, 3}, 4, results));
+  TEST_ASSERT_EQUAL(0, results[0]);
+  std::fill(results, results + 4, 0);
+  index.ComputeNeighborLists(4, results);
+  for (uint32_t result : results) { TEST_ASSERT_EQUAL(SpatialIndex::kNoPixel, result); }
+  index.Build({{line, renderer, 0}});
+  TEST_ASSERT_EQUAL(2, index.Nearest(line.at(250), 2, results));
+  TEST_ASSERT_EQUAL(250, results[0]);
+  TEST_ASSERT(results[1] == 249 || results[1] == 251);
+}
+
+void test_spatial_index_lazy() {
+  LazySpatialIndex lazy;
+  TEST_ASSERT_EQUAL(0, lazy.Get().pixelCount());
+  NullRenderer renderer;
+  Matrix matrix(4, 3);
+  std::vector<Strand> strands = {{matrix, renderer, 0}};
+  lazy.Reset(&strands);
+  TEST_ASSERT_EQUAL(12, lazy.Get().pixelCount());
+  TEST_ASSERT(&lazy.Get() == &lazy.Get());
+  // Changes to strands are only picked up after the next Reset.
+  strands.push_back({matrix, renderer, 1});
+  TEST_ASSERT_EQUAL(12, lazy.Get().pixelCount());
+  lazy.Reset(&strands);
+  TEST_ASSERT_EQUAL(24, lazy.Get().pixelCount());
+}
+
+void run_unity_tests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_spatial_index_radius_matches_brute_force);
+  RUN_TEST(test_spatial_index_nearest_matches_brute_force);
+  RUN_TEST(test_spatial_index_neighbor_lists);
+  RUN_TEST(test_spatial_index_small_layouts);
+  RUN_TEST(test_spatial_index_lazy);
+  UNITY_END();
+}
+
+}  // namespace jazzlights
+
+void setUp() {}
+
+void tearDown() {}
+
+#ifdef ESP32
+
+void setup() { jazzlights::run_unity_tests(); }
+
+void loop() {}
+
+#else  // ESP32
+
+int main(int /*argc*/, char** /*argv*/) {
+  jazzlights::run_unity_tests();
+  return 0;
+}
+
+#endif  // ESP32